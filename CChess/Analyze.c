@@ -0,0 +1,367 @@
+/*
+File:           Analyze.c
+Author:         Toni Lindeman
+Description:    Headless batch analysis of EPD position files.
+
+The EPD file is memory mapped and worker threads take positions from it one line at a time. Every worker has
+its own search state, so positions are analyzed fully in parallel. Results are written to stdout as JSON lines,
+in the same order as the input, through a window of buffered results. With MultiPV the results also list the best
+lines, and the summary tells what finding them cost.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "OSSpecific.h"
+#include "MoveGen.h"
+#include "Notation.h"
+#include "Search.h"
+#include "Analyze.h"
+
+// How many results may wait for earlier positions to finish.
+#define ANALYSIS_WINDOW 256
+#define EPD_MAX_LENGTH 512
+// Room for MULTIPV_MAX full lines.
+#define RESULT_MAX_LENGTH 8192
+
+struct analysisQueue {
+    pthread_mutex_t lock;
+    pthread_cond_t resultReady;
+    pthread_cond_t slotFree;
+
+    // Input file and the next line to analyze.
+    const char * data;
+    size_t size;
+    size_t offset;
+    long nextIndex;
+
+    // Results waiting to be printed.
+    char (* results)[RESULT_MAX_LENGTH];
+    int ready[ANALYSIS_WINDOW];
+    long nextToPrint;
+    int runningWorkers;
+
+    int depth;
+    int hashMegabytes;
+    int multiPV;
+    // Pawn hash table use of all workers.
+    long pawnProbes;
+    long pawnHits;
+    // Nodes searched by all workers, and how many of them went to the best lines.
+    long nodes;
+    long bestLineNodes;
+};
+
+static long takeNextLine(struct analysisQueue * queue, char * outLine) {
+    // Copy the next position line to outLine. Skips empty lines and '#' comments.
+    // Returns the index of the position, -1 when the file has been read. Caller must hold the lock.
+    while(queue->offset < queue->size) {
+        const char * line = queue->data + queue->offset;
+        size_t length = 0;
+
+        while(queue->offset + length < queue->size && line[length] != '\n') {
+            length++;
+        }
+        queue->offset += length + 1;
+
+        // Windows line endings
+        if(length > 0 && line[length - 1] == '\r') {
+            length--;
+        }
+        if(length == 0 || line[0] == '#') {
+            continue;
+        }
+
+        if(length > EPD_MAX_LENGTH - 1) {
+            length = EPD_MAX_LENGTH - 1;
+        }
+        memcpy(outLine, line, length);
+        outLine[length] = '\0';
+
+        return queue->nextIndex++;
+    }
+    return -1;
+}
+
+static int writeJsonString(char * out, const char * text, int length) {
+    // Write a quoted JSON string, escaping what needs to be escaped. Returns chars written.
+    int written = 0;
+
+    out[written++] = '"';
+    for(int i = 0; i < length && text[i] != '\0'; i++) {
+        // Already escaped quote in the input.
+        if(text[i] == '\\' && i + 1 < length && text[i + 1] == '"') {
+            continue;
+        }
+        if(text[i] == '"' || text[i] == '\\') {
+            out[written++] = '\\';
+        }
+        // Control characters don't belong in an id.
+        if((unsigned char)text[i] >= ' ') {
+            out[written++] = text[i];
+        }
+    }
+    out[written++] = '"';
+    out[written] = '\0';
+
+    return written;
+}
+
+static int writeJsonLine(char * out, struct position * pos, const struct searchLine * line) {
+    // Write one line of a MultiPV search as a JSON object. Returns chars written.
+    char coordinate[8];
+    char san[SAN_MAX_LENGTH];
+    moveToCoordinate(line->pv[0], coordinate);
+    moveToSan(pos, line->pv[0], san);
+    int length = sprintf(out, "{\"move\":\"%s\",\"san\":\"%s\",\"score\":%d", coordinate, san, line->score);
+
+    if(scoreToMateMoves(line->score)) {
+        length += sprintf(out + length, ",\"mate\":%d,\"pv\":[", scoreToMateMoves(line->score));
+    }
+    else {
+        length += sprintf(out + length, ",\"mate\":null,\"pv\":[");
+    }
+    for(int i = 0; i < line->pvLength; i++) {
+        moveToCoordinate(line->pv[i], coordinate);
+        length += sprintf(out + length, "%s\"%s\"", i ? "," : "", coordinate);
+    }
+    length += sprintf(out + length, "]}");
+    return length;
+}
+
+static void analyzeEpdLine(struct searchState * state, const char * line, long index, int depth, int multiPV,
+                           struct searchResult * outSearch, char * outResult) {
+    // Analyze one EPD line and write the result as a JSON object. outSearch gets the search result, its nodes are
+    // 0 if nothing was searched.
+    struct position pos;
+    int length = sprintf(outResult, "{\"index\":%ld", index);
+
+    outSearch->nodes = 0;
+    outSearch->bestLineNodes = 0;
+    int fenLength = setPositionFromFen(&pos, line);
+    if(!fenLength) {
+        sprintf(outResult + length, ",\"error\":\"invalid position\"}");
+        return;
+    }
+
+    // EPD id operation: id "name";
+    const char * id = strstr(line + fenLength, "id \"");
+    if(id) {
+        id += 4;
+        int idLength = 0;
+        while(id[idLength] != '\0' && (id[idLength] != '"' || (idLength > 0 && id[idLength - 1] == '\\'))) {
+            idLength++;
+        }
+        if(idLength > 200) {
+            idLength = 200;
+        }
+        length += sprintf(outResult + length, ",\"id\":");
+        length += writeJsonString(outResult + length, id, idLength);
+    }
+
+    char fen[FEN_MAX_LENGTH];
+    writeFen(&pos, fen);
+    length += sprintf(outResult + length, ",\"fen\":\"%s\"", fen);
+
+    struct searchLimits limits = {depth, 0, 0, multiPV};
+    struct searchResult result;
+    clearTranspositionTable(&state->table);
+    searchPosition(state, &pos, &limits, &result);
+    *outSearch = result;
+
+    if(result.bestMove == MOVE_NONE) {
+        sprintf(outResult + length, ",\"bestmove\":null,\"status\":\"%s\"}",
+                isPlayerInCheck(&pos, pos.turn) ? "checkmate" : "stalemate");
+        return;
+    }
+
+    char coordinate[8];
+    char san[SAN_MAX_LENGTH];
+    moveToCoordinate(result.bestMove, coordinate);
+    moveToSan(&pos, result.bestMove, san);
+    length += sprintf(outResult + length, ",\"bestmove\":\"%s\",\"san\":\"%s\"", coordinate, san);
+
+    if(scoreToMateMoves(result.score)) {
+        length += sprintf(outResult + length, ",\"score\":%d,\"mate\":%d", result.score, scoreToMateMoves(result.score));
+    }
+    else {
+        length += sprintf(outResult + length, ",\"score\":%d,\"mate\":null", result.score);
+    }
+    length += sprintf(outResult + length, ",\"depth\":%d,\"nodes\":%ld,\"pv\":[", result.depth, result.nodes);
+
+    for(int i = 0; i < result.pvLength; i++) {
+        moveToCoordinate(result.pv[i], coordinate);
+        length += sprintf(outResult + length, "%s\"%s\"", i ? "," : "", coordinate);
+    }
+    length += sprintf(outResult + length, "]");
+
+    // The best lines, best first. The first is the same as above.
+    if(multiPV > 1) {
+        length += sprintf(outResult + length, ",\"lines\":[");
+        for(int i = 0; i < result.lineCount; i++) {
+            length += sprintf(outResult + length, "%s", i ? "," : "");
+            length += writeJsonLine(outResult + length, &pos, &result.lines[i]);
+        }
+        length += sprintf(outResult + length, "]");
+    }
+    sprintf(outResult + length, "}");
+}
+
+static void * analysisWorker(void * argument) {
+    struct analysisQueue * queue = (struct analysisQueue *) argument;
+
+    // Search state is large, keep it off the thread stack.
+    struct searchState * state = (struct searchState *) malloc(sizeof(struct searchState));
+    if(!state || !initSearchState(state, (size_t)queue->hashMegabytes)) {
+        fprintf(stderr, "Analysis worker failed to allocate search state.\n");
+        free(state);
+        state = NULL;
+    }
+
+    char line[EPD_MAX_LENGTH];
+    char result[RESULT_MAX_LENGTH];
+    struct searchResult search;
+    long nodes = 0;
+    long bestLineNodes = 0;
+
+    while(state) {
+        pthread_mutex_lock(&queue->lock);
+        long index = takeNextLine(queue, line);
+        pthread_mutex_unlock(&queue->lock);
+
+        if(index == -1) {
+            break;
+        }
+
+        analyzeEpdLine(state, line, index, queue->depth, queue->multiPV, &search, result);
+        nodes += search.nodes;
+        bestLineNodes += search.bestLineNodes;
+
+        // Wait until the result fits in the output window, then hand it to the printer.
+        pthread_mutex_lock(&queue->lock);
+        while(index >= queue->nextToPrint + ANALYSIS_WINDOW) {
+            pthread_cond_wait(&queue->slotFree, &queue->lock);
+        }
+        strcpy(queue->results[index % ANALYSIS_WINDOW], result);
+        queue->ready[index % ANALYSIS_WINDOW] = 1;
+        pthread_cond_signal(&queue->resultReady);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    if(state) {
+        queue->pawnProbes += state->pawnTable.probes;
+        queue->pawnHits += state->pawnTable.hits;
+    }
+    queue->nodes += nodes;
+    queue->bestLineNodes += bestLineNodes;
+    queue->runningWorkers--;
+    pthread_cond_signal(&queue->resultReady);
+    pthread_mutex_unlock(&queue->lock);
+
+    if(state) {
+        freeSearchState(state);
+        free(state);
+    }
+    return NULL;
+}
+
+int runEpdAnalysis(const char * fileName, int depth, int threadCount, int hashMegabytes, int multiPV) {
+    // Analyze every position in an EPD file. Returns 0 on failure.
+
+    struct analysisQueue queue;
+    queue.data = mapFile(fileName, &queue.size);
+    if(!queue.data) {
+        fprintf(stderr, "Failed to open EPD file %s.\n", fileName);
+        return 0;
+    }
+
+    queue.results = malloc(ANALYSIS_WINDOW * sizeof(*queue.results));
+    pthread_t * threads = (pthread_t *) malloc(threadCount * sizeof(pthread_t));
+    if(!queue.results || !threads) {
+        fprintf(stderr, "Failed to allocate memory for analysis.\n");
+        free(queue.results);
+        free(threads);
+        unmapFile(queue.data, queue.size);
+        return 0;
+    }
+
+    queue.offset = 0;
+    queue.nextIndex = 0;
+    queue.nextToPrint = 0;
+    queue.depth = depth;
+    queue.hashMegabytes = hashMegabytes;
+    queue.multiPV = multiPV;
+    queue.pawnProbes = 0;
+    queue.pawnHits = 0;
+    queue.nodes = 0;
+    queue.bestLineNodes = 0;
+    memset(queue.ready, 0, sizeof(queue.ready));
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.resultReady, NULL);
+    pthread_cond_init(&queue.slotFree, NULL);
+
+    double startTime = getTimeSeconds();
+
+    queue.runningWorkers = 0;
+    for(int i = 0; i < threadCount; i++) {
+        if(pthread_create(&threads[i], NULL, analysisWorker, &queue) == 0) {
+            queue.runningWorkers++;
+        }
+        else {
+            fprintf(stderr, "Failed to start analysis thread %d.\n", i);
+            threadCount = i;
+            break;
+        }
+    }
+
+    // Print results in input order as they become ready.
+    pthread_mutex_lock(&queue.lock);
+    while(1) {
+        if(queue.ready[queue.nextToPrint % ANALYSIS_WINDOW]) {
+            int slot = (int)(queue.nextToPrint % ANALYSIS_WINDOW);
+
+            // Print outside the lock, the slot can't be reused before nextToPrint moves on.
+            pthread_mutex_unlock(&queue.lock);
+            printf("%s\n", queue.results[slot]);
+            pthread_mutex_lock(&queue.lock);
+
+            queue.ready[slot] = 0;
+            queue.nextToPrint++;
+            pthread_cond_broadcast(&queue.slotFree);
+        }
+        else if(queue.runningWorkers == 0) {
+            break;
+        }
+        else {
+            pthread_cond_wait(&queue.resultReady, &queue.lock);
+        }
+    }
+    pthread_mutex_unlock(&queue.lock);
+
+    for(int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double seconds = getTimeSeconds() - startTime;
+    fflush(stdout);
+    fprintf(stderr, "Analyzed %ld positions in %.2f s with %d threads, %.2f positions/second.\n",
+            queue.nextToPrint, seconds, threadCount, seconds > 0 ? queue.nextToPrint / seconds : 0.0);
+    fprintf(stderr, "Pawn hash: %ld probes, %.1f%% hits.\n", queue.pawnProbes,
+            queue.pawnProbes ? 100.0 * queue.pawnHits / queue.pawnProbes : 0.0);
+    // What the other lines cost. Separate searches of every line would take about multiPV times the best lines.
+    if(multiPV > 1) {
+        fprintf(stderr, "MultiPV %d: %ld nodes, %.2f times the nodes of the best lines.\n", multiPV, queue.nodes,
+                queue.bestLineNodes ? (double)queue.nodes / queue.bestLineNodes : 0.0);
+    }
+
+    pthread_cond_destroy(&queue.slotFree);
+    pthread_cond_destroy(&queue.resultReady);
+    pthread_mutex_destroy(&queue.lock);
+    free(threads);
+    free(queue.results);
+    unmapFile(queue.data, queue.size);
+
+    return 1;
+}
@@ -0,0 +1,12 @@
+/*
+File:           Analyze.h
+Author:         Toni Lindeman
+Description:    Headless batch analysis of EPD position files.
+*/
+
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+int runEpdAnalysis(const char * fileName, int depth, int threadCount, int hashMegabytes, int multiPV);
+
+#endif /* ANALYZE_H */
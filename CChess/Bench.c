@@ -0,0 +1,258 @@
+/*
+File:           Bench.c
+Author:         Toni Lindeman
+Description:    Microbenchmarks for the rules engine, built and run with "make bench".
+
+Every benchmark calls the game's own public functions on a fixed corpus of positions, so the numbers measure
+the implementation as it is. A benchmark first doubles its batch size until one run takes long enough to time,
+runs a few warmup batches and then times BENCH_REPEATS batches. Times are per call, in nanoseconds.
+
+The report goes to stderr and to a results file with one line per benchmark, easy to diff between commits.
+save and loadGameState print and use gamestate.gst in the working directory, so run this in a scratch
+directory with stdout discarded, as the bench target does.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "OSSpecific.h"
+#include "ChessPiece.h"
+#include "Chessboard.h"
+#include "Notation.h"
+#include "Zobrist.h"
+#include "Stats.h"
+
+#define BENCH_REPEATS 31
+#define BENCH_WARMUP_RUNS 3
+// A timed batch should take at least this long.
+#define BENCH_MIN_RUN_SECONDS 0.005
+#define BENCH_RESULTS_FILE "bench_results.tsv"
+
+// Positions for move validation, check detection and copying.
+static const char * corpusFens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R b - - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w - - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "2r3k1/pp3ppp/2n5/3p4/3P4/2N5/PP3PPP/2R3K1 w - - 0 1",
+    "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1",
+    "6k1/5p2/6p1/8/7p/8/6PP/6K1 b - - 0 1"
+};
+
+// Positions where the player in turn is in check, some of them mated.
+static const char * checkCorpusFens[] = {
+    "r1bqkb1r/pppp1Qpp/2n2n2/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b - - 0 1",
+    "3R2k1/5ppp/8/8/8/8/5PPP/6K1 b - - 0 1",
+    "6rk/5Npp/8/8/8/8/8/6K1 b - - 0 1",
+    "4k3/8/8/8/8/8/8/4R1K1 b - - 0 1",
+    "4k3/8/3N4/8/8/8/8/4K3 b - - 0 1",
+    "k7/8/8/8/8/8/6B1/K7 b - - 0 1",
+    "k6R/pp6/8/8/8/8/3r4/K7 b - - 0 1",
+    "4k3/8/8/8/8/8/4q3/4K3 w - - 0 1"
+};
+
+#define CORPUS_SIZE ((int)(sizeof(corpusFens) / sizeof(corpusFens[0])))
+#define CHECK_CORPUS_SIZE ((int)(sizeof(checkCorpusFens) / sizeof(checkCorpusFens[0])))
+
+struct benchResult {
+    const char * name;
+    long callsPerRun;
+    double minimum;
+    double median;
+    double percentile90;
+    double percentile99;
+};
+
+static struct chessPiece * corpus[CORPUS_SIZE];
+static int corpusTurns[CORPUS_SIZE];
+static struct chessPiece * checkCorpus[CHECK_CORPUS_SIZE];
+static int checkCorpusTurns[CHECK_CORPUS_SIZE];
+static struct chessPiece * scratchBoard;
+
+// Results are summed here so the calls can't be optimized away.
+static volatile long benchSink = 0;
+// Piece rank the validation benchmark is running for.
+static int validatedRank = 0;
+
+// CORPUS --------------------------------------------------------------------------------------------------------------
+static int loadCorpus(const char ** fens, int count, struct chessPiece ** boards, int * turns) {
+    for(int i = 0; i < count; i++) {
+        struct position pos;
+        boards[i] = getEmptyChessboard();
+        if(!boards[i] || !setPositionFromFen(&pos, fens[i])) {
+            fprintf(stderr, "Failed to set up benchmark position %s\n", fens[i]);
+            return 0;
+        }
+        copyChessboard(pos.board, boards[i]);
+        turns[i] = pos.turn;
+    }
+    return 1;
+}
+
+// BENCHMARKS ----------------------------------------------------------------------------------------------------------
+// Each function makes a pass over its corpus and returns the number of calls made.
+static long benchValidateMoves() {
+    // Every piece of the benchmarked rank tries every square.
+    long calls = 0;
+    for(int i = 0; i < CORPUS_SIZE; i++) {
+        for(int from = 0; from < 64; from++) {
+            if(corpus[i][from].rank != validatedRank) {
+                continue;
+            }
+            for(int to = 0; to < 64; to++) {
+                benchSink += validateAndMakeMove(corpus[i], from / 8, from % 8, to / 8, to % 8,
+                                                 corpus[i][from].owner, 1, 0);
+                calls++;
+            }
+        }
+    }
+    return calls;
+}
+
+static long benchCheckDetection() {
+    long calls = 0;
+    for(int i = 0; i < CORPUS_SIZE; i++) {
+        benchSink += checkForCheckedKing(corpus[i], 1, 0);
+        benchSink += checkForCheckedKing(corpus[i], 2, 0);
+        calls += 2;
+    }
+    for(int i = 0; i < CHECK_CORPUS_SIZE; i++) {
+        benchSink += checkForCheckedKing(checkCorpus[i], checkCorpusTurns[i], 0);
+        calls++;
+    }
+    return calls;
+}
+
+static long benchCheckmateDetection() {
+    // Only called with the player in check, like playGame does.
+    for(int i = 0; i < CHECK_CORPUS_SIZE; i++) {
+        benchSink += checkForCheckmate(checkCorpus[i], checkCorpusTurns[i]);
+    }
+    return CHECK_CORPUS_SIZE;
+}
+
+static long benchBoardCopy() {
+    for(int i = 0; i < CORPUS_SIZE; i++) {
+        copyChessboard(corpus[i], scratchBoard);
+        benchSink += scratchBoard[i].rank;
+    }
+    return CORPUS_SIZE;
+}
+
+static long benchSaveLoad() {
+    // One call is a save and a load of the same position.
+    for(int i = 0; i < CORPUS_SIZE; i++) {
+        int turn = 0;
+        save(corpus[i], corpusTurns[i], 0);
+        benchSink += loadGameState(scratchBoard, &turn, 0);
+    }
+    return CORPUS_SIZE;
+}
+
+// TIMING --------------------------------------------------------------------------------------------------------------
+static int compareDoubles(const void * a, const void * b) {
+    double first = *(const double *) a;
+    double second = *(const double *) b;
+    return (first > second) - (first < second);
+}
+
+static double timeRun(long (* benchmark)(), int passes, long * outCalls) {
+    // Time one batch. Returns nanoseconds per call.
+    long calls = 0;
+    double startTime = getTimeSeconds();
+    for(int i = 0; i < passes; i++) {
+        calls += benchmark();
+    }
+    double seconds = getTimeSeconds() - startTime;
+
+    *outCalls = calls;
+    return calls ? (seconds * 1e9) / (double) calls : 0.0;
+}
+
+static void runBenchmark(const char * name, long (* benchmark)(), struct benchResult * outResult) {
+    double samples[BENCH_REPEATS];
+    long calls = 0;
+    int passes = 1;
+
+    // Find a batch size that is long enough to time. This doubles as the first warmup.
+    while(1) {
+        double startTime = getTimeSeconds();
+        timeRun(benchmark, passes, &calls);
+        if(getTimeSeconds() - startTime >= BENCH_MIN_RUN_SECONDS || passes >= (1 << 20)) {
+            break;
+        }
+        passes *= 2;
+    }
+    for(int i = 0; i < BENCH_WARMUP_RUNS; i++) {
+        timeRun(benchmark, passes, &calls);
+    }
+    for(int i = 0; i < BENCH_REPEATS; i++) {
+        samples[i] = timeRun(benchmark, passes, &calls);
+    }
+    qsort(samples, BENCH_REPEATS, sizeof(double), compareDoubles);
+
+    // Nearest rank percentiles
+    outResult->name = name;
+    outResult->callsPerRun = calls;
+    outResult->minimum = samples[0];
+    outResult->median = samples[BENCH_REPEATS / 2];
+    outResult->percentile90 = samples[((BENCH_REPEATS * 90) + 99) / 100 - 1];
+    outResult->percentile99 = samples[((BENCH_REPEATS * 99) + 99) / 100 - 1];
+
+    fprintf(stderr, "%-28s %10ld %12.1f %12.1f %12.1f %12.1f\n", name, calls, outResult->minimum,
+            outResult->median, outResult->percentile90, outResult->percentile99);
+}
+
+int main(int argc, char * argv[]) {
+    // Argument 1: results file, bench_results.tsv by default.
+    const char * resultsFileName = (argc >= 2) ? argv[1] : BENCH_RESULTS_FILE;
+    static const char * validationNames[7] = {
+        "", "validate_pawn", "validate_rook", "validate_knight", "validate_bishop", "validate_queen", "validate_king"
+    };
+    struct benchResult results[12];
+    int resultCount = 0;
+
+    initZobristKeys();
+    initStats();
+
+    scratchBoard = getEmptyChessboard();
+    if(!scratchBoard || !loadCorpus(corpusFens, CORPUS_SIZE, corpus, corpusTurns) ||
+       !loadCorpus(checkCorpusFens, CHECK_CORPUS_SIZE, checkCorpus, checkCorpusTurns)) {
+        return 1;
+    }
+
+    fprintf(stderr, "%-28s %10s %12s %12s %12s %12s\n", "Benchmark (ns per call)", "Calls/run", "Min", "Median",
+            "P90", "P99");
+
+    for(validatedRank = 1; validatedRank <= 6; validatedRank++) {
+        runBenchmark(validationNames[validatedRank], benchValidateMoves, &results[resultCount++]);
+    }
+    runBenchmark("check_detection", benchCheckDetection, &results[resultCount++]);
+    runBenchmark("checkmate_detection", benchCheckmateDetection, &results[resultCount++]);
+    runBenchmark("board_copy", benchBoardCopy, &results[resultCount++]);
+    runBenchmark("save_load_roundtrip", benchSaveLoad, &results[resultCount++]);
+
+    FILE * resultsFile = fopen(resultsFileName, "w");
+    if(!resultsFile) {
+        fprintf(stderr, "Failed to open %s for writing.\n", resultsFileName);
+        return 1;
+    }
+    fprintf(resultsFile, "# benchmark\tcalls_per_run\tmin_ns\tmedian_ns\tp90_ns\tp99_ns\n");
+    for(int i = 0; i < resultCount; i++) {
+        fprintf(resultsFile, "%s\t%ld\t%.1f\t%.1f\t%.1f\t%.1f\n", results[i].name, results[i].callsPerRun,
+                results[i].minimum, results[i].median, results[i].percentile90, results[i].percentile99);
+    }
+    fclose(resultsFile);
+    fprintf(stderr, "Results written to %s\n", resultsFileName);
+
+    for(int i = 0; i < CORPUS_SIZE; i++) {
+        freeChessboardMemory(corpus[i]);
+    }
+    for(int i = 0; i < CHECK_CORPUS_SIZE; i++) {
+        freeChessboardMemory(checkCorpus[i]);
+    }
+    freeChessboardMemory(scratchBoard);
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+/*
+File:           Book.h
+Author:         Toni Lindeman
+Description:    Opening book in the Polyglot .bin format.
+*/
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Position.h"
+
+// Book entries are 16 bytes: key (8), move (2), weight (2), learn (4). All big-endian, sorted by key.
+#define BOOK_ENTRY_SIZE 16
+
+struct openingBook {
+    const unsigned char * data;
+    size_t size;
+    long entryCount;
+};
+
+int openBook(struct openingBook * book, const char * fileName);
+void closeBook(struct openingBook * book);
+int probeBook(const struct openingBook * book, struct position * pos, uint64_t * randomState);
+int buildBook(const char * pgnFileName, const char * bookFileName, int maxPlies, int minGames);
+
+#endif /* BOOK_H */
@@ -1,19 +1,36 @@
-/*
-File:           ChessPiece.h
-Author:         Toni Lindeman
-Description:    Functionality for chess pieces.
-*/
-
-#ifndef CHESSPIECE_H
-#define CHESSPIECE_H
-
-struct chessPiece{
-	int rank;
-	int owner;
-};
-
-int validateAndMakeMove(struct chessPiece * chessboard, int selectedRow, int selectedColumn, int moveRow, int moveColumn,
-        int player, int validateOnly, int checkingRun);
-char * getRankStr(int rank);
-
-#endif /* CHESSPIECE_H */
+/*
+File:           ChessPiece.h
+Author:         Toni Lindeman
+Description:    Functionality for chess pieces.
+*/
+
+#ifndef CHESSPIECE_H
+#define CHESSPIECE_H
+
+struct chessPiece{
+	int rank;
+	int owner;
+};
+
+// Results of validateAndMakeMove, the texts for players are in the table in UserInput.c.
+#define MOVE_VALID 0
+#define MOVE_INVALID_NO_MOVEMENT 1
+#define MOVE_INVALID_PAWN_DIRECTION 2
+#define MOVE_INVALID_PAWN_DISTANCE 3
+#define MOVE_INVALID_PAWN_DIAGONAL 4
+#define MOVE_INVALID_BLOCKED 5
+#define MOVE_INVALID_ROOK 6
+#define MOVE_INVALID_KNIGHT 7
+#define MOVE_INVALID_BISHOP 8
+#define MOVE_INVALID_QUEEN 9
+#define MOVE_INVALID_KING 10
+#define MOVE_INVALID_OWN_PIECE 11
+// Not from validateAndMakeMove, which doesn't know castling. Explains castling the rules don't allow.
+#define MOVE_INVALID_CASTLING 12
+#define MOVE_RESULT_COUNT 13
+
+int validateAndMakeMove(struct chessPiece * chessboard, int selectedRow, int selectedColumn, int moveRow, int moveColumn,
+        int player, int validateOnly, int promotion);
+char * getRankStr(int rank);
+
+#endif /* CHESSPIECE_H */
@@ -0,0 +1,353 @@
+/*
+File:           Evaluate.c
+Author:         Toni Lindeman
+Description:    Static evaluation of positions for the computer player.
+
+Evaluation is material plus piece-square tables, in centipawns from the point of view of the player in turn.
+Tables are written from player 1's (white's) side with row 1 at the bottom, the way a chess book shows them.
+Player 2 reads them mirrored.
+
+Pawn structure (doubled, isolated, backward and passed pawns) only depends on where the pawns are, and pawns
+move in few of the nodes of a search. It is cached by pawn key in a pawn hash table, one per search thread, so
+it is only computed again when the pawns change. The pawn shield in front of a king is cached in the same entry
+for the king square it was computed for.
+*/
+
+#include <stdlib.h>
+#include "Evaluate.h"
+
+const int pieceValues[7] = {0, 100, 500, 320, 330, 900, 0};
+
+// Pawn structure terms in centipawns.
+#define DOUBLED_PAWN_PENALTY 10
+#define ISOLATED_PAWN_PENALTY 15
+#define BACKWARD_PAWN_PENALTY 8
+#define SHIELD_PAWN_BONUS 10
+#define SHIELD_PAWN_ADVANCED_BONUS 5
+#define SHIELD_MISSING_PENALTY 15
+// Per square of king distance, for passed pawns in the end game.
+#define PASSED_PAWN_KING_BONUS 5
+
+// Non-pawn material of both players above which it is the middle game.
+#define MIDDLE_GAME_MATERIAL 2600
+
+// By row counted from the player's own side.
+static const int passedPawnBonus[8] = {0, 5, 10, 20, 35, 60, 100, 0};
+
+// Row 8 first, so the tables look like the board from white's side.
+static const int pawnTable[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+static const int rookTable[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0
+};
+
+static const int knightTable[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+static const int bishopTable[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+static const int queenTable[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+static const int kingMiddleGameTable[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20
+};
+
+static const int kingEndGameTable[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
+
+static const int * pieceTables[7] = {0, pawnTable, rookTable, knightTable, bishopTable, queenTable, 0};
+
+// PAWN STRUCTURE ------------------------------------------------------------------------------------------------------
+int initPawnHashTable(struct pawnHashTable * table) {
+    // Returns 0 if memory allocation fails.
+    table->entries = (struct pawnHashEntry *) calloc(PAWN_HASH_ENTRIES, sizeof(struct pawnHashEntry));
+    table->mask = table->entries ? PAWN_HASH_ENTRIES - 1 : 0;
+    table->probes = 0;
+    table->hits = 0;
+    return table->entries != NULL;
+}
+
+void freePawnHashTable(struct pawnHashTable * table) {
+    free(table->entries);
+    table->entries = NULL;
+    table->mask = 0;
+}
+
+static void evaluatePawnStructure(const struct position * pos, struct pawnHashEntry * entry) {
+    // Fill in the score and passed pawns of an entry.
+    int counts[3][8] = {{0}};
+    // Lowest and highest row of each player's pawns on each column, 8 / -1 if none.
+    int lowest[3][8];
+    int highest[3][8];
+    int score[3] = {0, 0, 0};
+
+    for(int column = 0; column < 8; column++) {
+        for(int player = 1; player <= 2; player++) {
+            lowest[player][column] = 8;
+            highest[player][column] = -1;
+        }
+    }
+    for(int square = 8; square < 56; square++) {
+        if(pos->board[square].rank == 1) {
+            int owner = pos->board[square].owner;
+            int row = SQUARE_ROW(square);
+            int column = SQUARE_COLUMN(square);
+            counts[owner][column]++;
+            lowest[owner][column] = (row < lowest[owner][column]) ? row : lowest[owner][column];
+            highest[owner][column] = (row > highest[owner][column]) ? row : highest[owner][column];
+        }
+    }
+
+    entry->passed[0] = 0;
+    entry->passed[1] = 0;
+    for(int square = 8; square < 56; square++) {
+        if(pos->board[square].rank != 1) {
+            continue;
+        }
+        int owner = pos->board[square].owner;
+        int opponent = (owner % 2) + 1;
+        int forward = (owner == 1) ? 1 : -1;
+        int row = SQUARE_ROW(square);
+        int column = SQUARE_COLUMN(square);
+
+        int isolated = 1;
+        int backward = 1;
+        int passed = 1;
+        for(int adjacent = column - 1; adjacent <= column + 1; adjacent++) {
+            if(adjacent < 0 || adjacent > 7) {
+                continue;
+            }
+            // Opponent pawns in front on this or a neighbour column stop a passed pawn.
+            if((owner == 1 && highest[opponent][adjacent] > row) || (owner == 2 && lowest[opponent][adjacent] < row)) {
+                passed = 0;
+            }
+            if(adjacent == column || counts[owner][adjacent] == 0) {
+                continue;
+            }
+            isolated = 0;
+            // A neighbour pawn beside or behind can still support this one.
+            if((owner == 1 && lowest[owner][adjacent] <= row) || (owner == 2 && highest[owner][adjacent] >= row)) {
+                backward = 0;
+            }
+        }
+
+        if(isolated) {
+            score[owner] -= ISOLATED_PAWN_PENALTY;
+        }
+        else if(backward) {
+            // Only backward if an opponent pawn guards the square in front.
+            int guardRow = row + (2 * forward);
+            int guarded = 0;
+            for(int side = -1; side <= 1 && guardRow >= 0 && guardRow <= 7; side += 2) {
+                int guardColumn = column + side;
+                if(guardColumn >= 0 && guardColumn <= 7 && pos->board[SQUARE(guardRow, guardColumn)].rank == 1 &&
+                   pos->board[SQUARE(guardRow, guardColumn)].owner == opponent) {
+                    guarded = 1;
+                }
+            }
+            score[owner] -= guarded ? BACKWARD_PAWN_PENALTY : 0;
+        }
+        if(passed) {
+            score[owner] += passedPawnBonus[(owner == 1) ? row : 7 - row];
+            entry->passed[owner - 1] |= 1ULL << square;
+        }
+    }
+
+    for(int column = 0; column < 8; column++) {
+        for(int player = 1; player <= 2; player++) {
+            if(counts[player][column] > 1) {
+                score[player] -= DOUBLED_PAWN_PENALTY * (counts[player][column] - 1);
+            }
+        }
+    }
+    entry->score = score[1] - score[2];
+}
+
+static int evaluatePawnShield(const struct position * pos, int player, int kingSquare) {
+    // Pawns in front of a king on its own back two rows. Kings further up get nothing.
+    int homeRow = (player == 1) ? 0 : 7;
+    int forward = (player == 1) ? 1 : -1;
+    int kingRow = SQUARE_ROW(kingSquare);
+    int kingColumn = SQUARE_COLUMN(kingSquare);
+    int shield = 0;
+
+    if(kingRow != homeRow && kingRow != homeRow + forward) {
+        return 0;
+    }
+    for(int column = kingColumn - 1; column <= kingColumn + 1; column++) {
+        if(column < 0 || column > 7) {
+            continue;
+        }
+        struct chessPiece near = pos->board[SQUARE(kingRow + forward, column)];
+        struct chessPiece far = pos->board[SQUARE(kingRow + (2 * forward), column)];
+        if(near.rank == 1 && near.owner == player) {
+            shield += SHIELD_PAWN_BONUS;
+        }
+        else if(far.rank == 1 && far.owner == player) {
+            shield += SHIELD_PAWN_ADVANCED_BONUS;
+        }
+        else {
+            shield -= SHIELD_MISSING_PENALTY;
+        }
+    }
+    return shield;
+}
+
+static int squareDistance(int from, int to) {
+    int rows = abs(SQUARE_ROW(from) - SQUARE_ROW(to));
+    int columns = abs(SQUARE_COLUMN(from) - SQUARE_COLUMN(to));
+    return (rows > columns) ? rows : columns;
+}
+
+static int evaluatePawns(const struct position * pos, struct pawnHashTable * pawnTable, const int kingSquares[3],
+                         int isMiddleGame) {
+    // Pawn structure and king terms that depend on pawns, from player 1's point of view.
+    struct pawnHashEntry local;
+    struct pawnHashEntry * entry = &local;
+
+    if(pawnTable) {
+        entry = &pawnTable->entries[pos->pawnKey & pawnTable->mask];
+        pawnTable->probes++;
+    }
+    if(pawnTable && entry->used && entry->key == pos->pawnKey) {
+        pawnTable->hits++;
+    }
+    else {
+        evaluatePawnStructure(pos, entry);
+        entry->key = pos->pawnKey;
+        entry->shieldSquare[0] = 0;
+        entry->shieldSquare[1] = 0;
+        entry->used = 1;
+    }
+
+    int score = entry->score;
+    for(int player = 1; player <= 2; player++) {
+        int sign = (player == 1) ? 1 : -1;
+        int opponent = (player % 2) + 1;
+        if(kingSquares[player] == -1) {
+            continue;
+        }
+
+        if(isMiddleGame) {
+            if(entry->shieldSquare[player - 1] != kingSquares[player] + 1) {
+                entry->shield[player - 1] = (short) evaluatePawnShield(pos, player, kingSquares[player]);
+                entry->shieldSquare[player - 1] = (unsigned char)(kingSquares[player] + 1);
+            }
+            score += sign * entry->shield[player - 1];
+        }
+        else if(kingSquares[opponent] != -1) {
+            // End game: kings should escort their own passed pawns and stop the opponent's.
+            uint64_t passed = entry->passed[player - 1];
+            while(passed) {
+                int square = __builtin_ctzll(passed);
+                int stopSquare = square + ((player == 1) ? 8 : -8);
+                int opponentDistance = squareDistance(kingSquares[opponent], stopSquare);
+                int ownDistance = squareDistance(kingSquares[player], stopSquare);
+                score += sign * PASSED_PAWN_KING_BONUS * (opponentDistance - ownDistance);
+                passed &= passed - 1;
+            }
+        }
+    }
+    return score;
+}
+
+// EVALUATION ----------------------------------------------------------------------------------------------------------
+int evaluatePosition(const struct position * pos, struct pawnHashTable * pawnTable) {
+    // Returns score in centipawns, positive if the player in turn is better.
+    // pawnTable caches the pawn structure terms, it can be NULL.
+    int score[3] = {0, 0, 0};
+    int nonPawnMaterial = 0;
+    int kingSquares[3] = {-1, -1, -1};
+    int kingTableIndexes[3] = {-1, -1, -1};
+
+    for(int square = 0; square < 64; square++) {
+        struct chessPiece piece = pos->board[square];
+        if(piece.rank == 0) {
+            continue;
+        }
+
+        // Table index: player 1 reads the table upside down (table starts from row 8), player 2 as written.
+        int tableIndex = (piece.owner == 1) ? (square ^ 56) : square;
+
+        if(piece.rank == 6) {
+            kingSquares[piece.owner] = square;
+            kingTableIndexes[piece.owner] = tableIndex;
+            continue;
+        }
+
+        score[piece.owner] += pieceValues[piece.rank] + pieceTables[piece.rank][tableIndex];
+        if(piece.rank != 1) {
+            nonPawnMaterial += pieceValues[piece.rank];
+        }
+    }
+
+    // Kings hide in the middle game and walk to the center in the end game.
+    int isMiddleGame = nonPawnMaterial > MIDDLE_GAME_MATERIAL;
+    for(int player = 1; player <= 2; player++) {
+        if(kingTableIndexes[player] != -1) {
+            score[player] += isMiddleGame ? kingMiddleGameTable[kingTableIndexes[player]]
+                                          : kingEndGameTable[kingTableIndexes[player]];
+        }
+    }
+    score[1] += evaluatePawns(pos, pawnTable, kingSquares, isMiddleGame);
+
+    int opponent = (pos->turn % 2) + 1;
+    return score[pos->turn] - score[opponent];
+}
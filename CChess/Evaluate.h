@@ -0,0 +1,44 @@
+/*
+File:           Evaluate.h
+Author:         Toni Lindeman
+Description:    Static evaluation of positions for the computer player.
+*/
+
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Position.h"
+
+// Pawn structure cache size, a power of two. About 1 MB per search thread.
+#define PAWN_HASH_ENTRIES 32768
+
+// Piece values in centipawns, indexed by chess piece rank.
+extern const int pieceValues[7];
+
+// Pawn structure evaluation of one pawn key.
+struct pawnHashEntry {
+    uint64_t key;
+    // Passed pawns of player 1 and 2, one bit per square.
+    uint64_t passed[2];
+    // Doubled, isolated, backward and passed pawns, from player 1's point of view.
+    int score;
+    // Pawn shield of each player's king and the king square it was computed for, plus 1 (0: not computed yet).
+    short shield[2];
+    unsigned char shieldSquare[2];
+    unsigned char used;
+};
+
+struct pawnHashTable {
+    struct pawnHashEntry * entries;
+    size_t mask;
+    long probes;
+    long hits;
+};
+
+int initPawnHashTable(struct pawnHashTable * table);
+void freePawnHashTable(struct pawnHashTable * table);
+int evaluatePosition(const struct position * pos, struct pawnHashTable * pawnTable);
+
+#endif /* EVALUATE_H */
@@ -1,553 +1,874 @@
-/*
-File:           Gameplay.c
-Author:         Toni Lindeman
-Description:    Gameplay logic.
-*/
-
-#include <stdio.h>
-#include <stdlib.h>
-#include "Menu.h"
-#include "UserInput.h"
-#include "ChessPiece.h"
-#include "Chessboard.h"
-
-void playGame(int gameMode) {
-    /* Gameplay logic
-     * gameMode:
-     *      0 -> Load game state
-     *      1-3 -> Load scenario 1-3
-     *      4 -> New standard game
-     * */
-
-    // White (player 1) always starts.
-    int whoseTurn = 1;
-
-    // ints for square selection and move.
-    int xSelect = -1;
-    int ySelect = -1;
-    int xMove = -1;
-    int yMove= -1;
-
-    // Program checks if king is checked from the start of the move.
-    // If so, only moves that end check are valid.
-    int kingCheckedStart = 0;
-
-    // Checkmate flag
-    int checkmate = 0;
-
-    // Clear console before game begins
-    clearConsole();
-
-    // Initialize a chessboard for the game.
-    struct chessPiece * chessboard = NULL;
-    chessboard = getInitChessboard();
-
-    if(gameMode >= 0 && gameMode <= 3) {
-        // If something goes wrong loading, free memory and get init chessboard.
-        if(!loadGameState(chessboard, &whoseTurn, gameMode)) {
-            promptReturnToContinue();
-            // Load failed, free memory...
-            freeChessboardMemory(chessboard);
-            // and load initial chessboard setup.
-            chessboard = getInitChessboard();
-        }
-    }
-
-    // Make a copy of the chessboard to keep previous move.
-    // We need this for check and checkmate validation.
-    struct chessPiece * chessboardPrevious = NULL;
-    chessboardPrevious = getEmptyChessboard();
-    copyChessboard(chessboard, chessboardPrevious);
-
-    // Game loop, make absolutely sure the game always can end in some way (quit or end condition).
-    while(1) {
-        // Clear console
-        clearConsole();
-        // Exit info text
-        printf("Exit game / cancel move by entering '0' in selection.\n\n");
-        // Draw chessboard
-        printChessboard(chessboard);
-
-        // Ask current player to make a move
-        if(whoseTurn == 1) {
-            printf("Player 1 turn\n");
-        }
-        else {
-            printf("Player 2 turn\n");
-        }
-
-        // Check if king is checked from the start of the move.
-        kingCheckedStart = checkForCheckedKing(chessboard, whoseTurn, 0);
-
-        // If king is checked, check for checkmate.
-        if(kingCheckedStart) {
-
-            if(checkForCheckmate(chessboard, whoseTurn)) {
-                checkmate = 1;
-                break;
-            }
-
-        }
-
-        while(1) {
-            // Get player pick
-            getSelectSquare(&xSelect, &ySelect, 0);
-
-            // Exit loop if player has entered '0'.
-            if(xSelect == -1) {
-                break;
-            }
-
-            // Validate select
-            if(validateSelect(chessboard, ySelect, xSelect, whoseTurn)) {
-                    // Valid selection, break out of loop.
-                    break;
-            }
-        }
-
-        // Exit game loop if player has entered '0'.
-        if(xSelect == -1) {
-            break;
-        }
-
-        while(1) {
-            // Prompt where player wants to move
-            getSelectSquare(&xMove, &yMove, 1);
-            if(xMove == -1) {
-                break;
-            }
-
-            // Validate move
-            if(validateAndMakeMove(chessboard, ySelect, xSelect, yMove, xMove, whoseTurn, 0, 0)) {
-                // Now we need to check if king became / remains checked.
-                if(checkForCheckedKing(chessboard, whoseTurn, 0)) {
-                    // Kings is / remains checked => illegal move.
-                    if(kingCheckedStart) {
-                        printf("King remains checked, you must save the king.\n");
-                    }
-                    else {
-                        printf("That move endangers your king, that is not allowed!\n");
-                    }
-                    // Cancel move
-                    copyChessboard(chessboardPrevious, chessboard);
-
-                }
-                else {
-                    // Move was ok, make move on chessboardPrevious and break out.
-                    validateAndMakeMove(chessboardPrevious, ySelect, xSelect, yMove, xMove, whoseTurn, 0, 1);
-                    break;
-                }
-            }
-        }
-        // Player chose to cancel move.
-        if(xMove == -1) {
-            continue;
-        }
-
-        // Change player turn
-        whoseTurn = (whoseTurn % 2) + 1;
-    }
-
-    // If game ended in checkmate
-    if(checkmate) {
-        printf("\n\nPlayer %d won the game!\n", (whoseTurn % 2) + 1);
-        promptReturnToContinue();
-    }
-
-    // Ask user whether they wish to save their game.
-    else if(promptYesNo("Would you like to save the game (overwrites last save)? ")) {
-        save(chessboard, whoseTurn, 0);
-        promptReturnToContinue();
-    }
-
-    // Free memory allocated to chessboard and chessboard previous.
-    chessboard = freeChessboardMemory(chessboard);
-    chessboardPrevious = freeChessboardMemory(chessboardPrevious);
-
-}
-
-void scenarioEditor() {
-    // Allows user to build chess scenarios
-    clearConsole();
-    int scenarioChoice = scenarioMenu();
-
-    // If cancel
-    if(scenarioChoice == 0) {
-        return;
-    }
-
-    // Scenario chessboard.
-    struct chessPiece * chessboard = NULL;
-    // In scenarios player 1 always starts, we still need a variable for loading.
-    int whoseTurn = 1;
-
-    // Play scenario
-    if(scenarioChoice >= 1 && scenarioChoice <= 3) {
-        playGame(scenarioChoice);
-        return;
-    }
-
-    // Load scenario
-    else if(scenarioChoice >= 4 && scenarioChoice <= 6) {
-        chessboard = getInitChessboard();
-        // If loading scenario fails, e.g. file doesn't exist, create empty chessboard.
-        if(!loadGameState(chessboard, &whoseTurn, scenarioChoice - 3)) {
-            printf("Failed to load scenario, continuing with empty chessboard.\n");
-            scenarioChoice = 7;
-            chessboard = freeChessboardMemory(chessboard);
-            promptReturnToContinue();
-        }
-    }
-
-    // New scenario
-    if(scenarioChoice == 7) {
-        // Check if user wants to start with standard setup
-        if(promptYesNo("Would you like to initialize scenario with standard setup? ") == 1) {
-            chessboard = getInitChessboard();
-
-        }
-        else {
-            chessboard = getEmptyChessboard();
-        }
-    }
-
-    // Check that we have a chessboard to work with.
-    if(!chessboard) {
-        printf("Failed to initialize scenario editor!\n");
-        promptReturnToContinue();
-        return;
-    }
-
-    // Print info about scenario editor
-    clearConsole();
-    printInfo("scenario");
-
-    // Array to keep track of number of chess pieces.
-    // numPieces[0-5] => player1 pawn, rook, knight, bishop, queen, king
-    // numPieces[6-11] => player2 -- || --
-    int * numPieces = (int *)calloc(12, sizeof(int));
-    int isLimitBreached = 0;
-    int pieceLimits[] = {8, 2, 2, 2, 1, 1};
-
-    // Count chess pieces.
-    countChessPieces(chessboard, numPieces);
-
-    /*
-     * Scenario only allows:
-     *      8 pawns
-     *      2 rooks, knights and bishops
-     *      1 queen and king.
-     * */
-    // TODO: Allow more freedom with piece placement, taking pawn promotion into account.
-    //      This will require a more comprehensive check for piece counts. E.g. player has 10 queens (which is fine),
-    //      then player cannot have a single pawn.
-
-    // Array to hold chess piece placement data.
-    // Player, chess piece, x, y
-    int placement[4] = {0, 0, 0, 0};
-
-    // Scenario editor loop
-    while(1) {
-        // First clear console.
-        clearConsole();
-
-        // Print info on top
-        printf("0: Empty; 1: Pawn; 2: Rook; 3; Knight; 4: Bishop; 5: Queen; 6: King\n");
-        printf("Place: '[player] [rank] [position]' | Clear: '0 [position]'.\n");
-        printf("Enter '0' to stop.\n\n");
-        printChessboard(chessboard);
-
-        getScenarioPlacement(placement);
-
-        // TODO: Allow user to exit without saving when requirements aren't met
-
-        // Check for exit
-        if(placement[0] == -1) {
-
-            // Minimum requirements:
-            //      - King per side
-            //      - Neither player is in checkmate.
-            //      - At least one other piece.
-
-            // Check that both sides have a king
-            if(numPieces[5] != 1 || numPieces[11] != 1) {
-                printf("Both sides must have a king.\n");
-                promptReturnToContinue();
-                continue;
-            }
-            if(checkForCheckedKing(chessboard, 1, 0)) {
-                if(checkForCheckmate(chessboard, 1)) {
-                    printf("Player 1 is in checkmate, please modify the scenario.\n");
-                    promptReturnToContinue();
-                    continue;
-                }
-            }
-            if(checkForCheckedKing(chessboard, 2, 0)) {
-                if(checkForCheckmate(chessboard, 2)) {
-                    printf("Player 2 is in checkmate, please modify the scenario.\n");
-                    promptReturnToContinue();
-                    continue;
-                }
-            }
-            // Check that there is at least one other chess piece in addition to the kings.
-            int pieceCounter = 0;
-            for(int i = 0; i < 12; i++) {
-                pieceCounter += numPieces[i];
-            }
-            if(pieceCounter < 3) {
-                printf("This setup is a stalemate, please modify the scenario.\n");
-                promptReturnToContinue();
-                continue;
-            }
-
-            printf("You are about to stop editing this scenario.\n");
-            if(promptYesNo("Are you sure? ") == 1) {
-                break;
-            }
-            else {
-                continue;
-            }
-        }
-
-        // Get piece at current position
-        struct chessPiece overwriteSquare = chessboard[(8 * placement[3]) + placement[2]];
-
-        // Decrement piece counter unless square is empty --------------------------------------------------------------
-        switch(overwriteSquare.rank) {
-            case 0:
-                break;
-
-            // Pawn decrement
-            case 1:
-                if(overwriteSquare.owner == 1) {
-                    numPieces[0] -= 1;
-                }
-                else {
-                    numPieces[6] -= 1;
-                }
-                break;
-
-            // Rook decrement
-            case 2:
-                if(overwriteSquare.owner == 1) {
-                    numPieces[1] -= 1;
-                }
-                else {
-                    numPieces[7] -= 1;
-                }
-                break;
-
-            // Knight decrement
-            case 3:
-                if(overwriteSquare.owner == 1) {
-                    numPieces[2] -= 1;
-                }
-                else {
-                    numPieces[8] -= 1;
-                }
-                break;
-            // Bishop decrement
-            case 4:
-                if(overwriteSquare.owner == 1) {
-                    numPieces[3] -= 1;
-                }
-                else {
-                    numPieces[9] -= 1;
-                }
-                break;
-            // Queen decrement
-            case 5:
-                if(overwriteSquare.owner == 1) {
-                    numPieces[4] -= 1;
-                }
-                else {
-                    numPieces[10] -= 1;
-                }
-                break;
-            // King decrement
-            case 6:
-                if(overwriteSquare.owner == 1) {
-                    numPieces[5] -= 1;
-                }
-                else {
-                    numPieces[11] -= 1;
-                }
-                break;
-        }
-
-        // Increment piece counter unless new piece is "clear square" --------------------------------------------------
-        // Note: we allow exceeding count limit for a piece here.
-        // Limit breach is checked later. This is done in the hopes of making code more readable here.
-        switch(placement[1]) {
-            case 0:
-                break;
-
-            // Pawn increment
-            case 1:
-                if(placement[0] == 1) {
-                    numPieces[0] += 1;
-                }
-                else {
-                    numPieces[6] += 1;
-                }
-                break;
-
-            // Rook increment
-            case 2:
-                if(placement[0] == 1) {
-                    numPieces[1] += 1;
-                }
-                else {
-                    numPieces[7] += 1;
-                }
-                break;
-
-            // Knight increment
-            case 3:
-                if(placement[0] == 1) {
-                    numPieces[2] += 1;
-                }
-                else {
-                    numPieces[8] += 1;
-                }
-                break;
-            // Bishop increment
-            case 4:
-                if(placement[0] == 1) {
-                    numPieces[3] += 1;
-                }
-                else {
-                    numPieces[9] += 1;
-                }
-                break;
-            // Queen increment
-            case 5:
-                if(placement[0] == 1) {
-                    numPieces[4] += 1;
-                }
-                else {
-                    numPieces[10] += 1;
-                }
-                break;
-            // King increment
-            case 6:
-                if(placement[0] == 1) {
-                    numPieces[5] += 1;
-                }
-                else {
-                    numPieces[11] += 1;
-                }
-                break;
-        }
-
-        // Reset limit breach flag
-        isLimitBreached = 0;
-
-        // Check limit breach
-        if(placement[0] != 0) {
-            // TODO: This comparison is stupid complicated => refactor?
-            if(numPieces[(placement[1] - 1) + (6 * (placement[0] - 1))] > pieceLimits[placement[1] - 1]) {
-                printf("Invalid placement: Too many %ss, you have %d/%d.\n",
-                       getRankStr(placement[1]),
-                       numPieces[(placement[1] - 1) + (6 * (placement[0] - 1))] - 1,
-                       pieceLimits[placement[1] - 1]);
-
-                // Let user read error before moving on.
-                promptReturnToContinue();
-
-                // Decrement limit violator back to limit.
-                numPieces[(placement[1] - 1) + (6 * (placement[0] - 1))] -= 1;
-
-                // Set limit breached flag.
-                isLimitBreached = 1;
-            }
-
-        }
-
-        // If everything is fine, place chess piece.
-        if(!isLimitBreached) {
-            // Everything should be clear, so let's place the piece / clear square.
-            chessboard[(8 * placement[3]) + placement[2]].owner = placement[0];
-            chessboard[(8 * placement[3]) + placement[2]].rank = placement[1];
-        }
-    }
-
-    // Free memory allocated to numPieces
-    free(numPieces);
-    // Set pointer to NULL so we don't risk double freeing this.
-    numPieces = NULL;
-
-    int userChoice = 0;
-    printf("\n");
-
-    while(userChoice == 0) {
-        // User: save or not?
-        userChoice = saveScenarioMenu();
-
-        // Confirm no save
-        if(userChoice == 0) {
-            printf("\nThis scenario build will be gone for good.\n");
-            userChoice = promptYesNo("Are you sure? ");
-            if(userChoice == 1) {
-                userChoice = 0;
-                break;
-            }
-        }
-        printf("\n");
-    }
-
-    // If save scenario
-    if(userChoice > 0 && userChoice < 4) {
-        save(chessboard, 1, userChoice);
-    }
-
-    // Finally, free memory allocated to chessboard.
-    chessboard = freeChessboardMemory(chessboard);
-
-}
-
-void start(int showWelcome) {
-    // Clear console before we get started.
-    clearConsole();
-
-    // Print welcome if showWelcome.
-    if(showWelcome) {
-        printInfo("welcome");
-    }
-
-    // Game state is where in the program we are (play game, exit, etc.)
-    int gameState = 0;
-
-    do {
-        // Clear the console
-        clearConsole();
-        // Print menu
-        gameState = menu();
-
-        switch(gameState) {
-            // Play game
-            case 1:
-                playGame(4);
-                break;
-            // Load game
-            case 2:
-                playGame(0);
-                break;
-            // Scenario builder
-            case 3:
-                scenarioEditor();
-                break;
-            // Information
-            case 4:
-                clearConsole();
-                printInfo("information");
-                break;
-
-            default:
-                printf("\nThank you for playing!\n\n");
-        }
-
-    } while(gameState != 0);
-
-}
-
+/*
+File:           Gameplay.c
+Author:         Toni Lindeman
+Description:    Gameplay logic.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Menu.h"
+#include "UserInput.h"
+#include "ChessPiece.h"
+#include "Chessboard.h"
+#include "Position.h"
+#include "MoveGen.h"
+#include "PGN.h"
+#include "Tablebase.h"
+#include "Log.h"
+#include "Validate.h"
+#include "Notation.h"
+#include "Search.h"
+#include "Hint.h"
+#include "MoveHistory.h"
+
+// Game ids for the log, counted from program start.
+static int gameCounter = 0;
+
+// Thinking time of the computer player per move, on top of what it pondered on the player's time.
+#define COMPUTER_MOVE_SECONDS 2.0
+// Best moves a hint shows.
+#define HINT_LINES 3
+
+void exportGame(struct moveHistory * game, char * result) {
+    // Append a finished game to the PGN export file. Moves taken back are not part of it.
+    FILE * file = fopen(FILE_PGN_EXPORT, "a");
+    if(!file) {
+        printf("Failed to open %s.\n", FILE_PGN_EXPORT);
+        return;
+    }
+
+    // PGN date format YYYY.MM.DD
+    char date[16] = "????.??.??";
+    time_t now = time(NULL);
+    struct tm * localNow = localtime(&now);
+    if(localNow) {
+        strftime(date, sizeof(date), "%Y.%m.%d", localNow);
+    }
+
+    struct pgnTag tags[7];
+    setPgnTag(&tags[0], "Event", "C-Chess game");
+    setPgnTag(&tags[1], "Site", "?");
+    setPgnTag(&tags[2], "Date", date);
+    setPgnTag(&tags[3], "Round", "-");
+    setPgnTag(&tags[4], "White", "Player 1");
+    setPgnTag(&tags[5], "Black", "Player 2");
+    setPgnTag(&tags[6], "Result", result);
+
+    if(writePgnGame(file, tags, 7, &game->start, game->moves, game->count, result)) {
+        printf("Game exported to %s.\n", FILE_PGN_EXPORT);
+    }
+    fclose(file);
+}
+
+static int refereeSpecialMove(struct position * game, struct chessPiece * chessboard,
+                              struct chessPiece * chessboardPrevious, int move, int * outMove) {
+    // Castling and en passant depend on earlier moves, which a chessboard doesn't remember but the game's position
+    // does. Same results as refereeMove.
+    struct moveList pseudoLegal;
+    struct undoRecord undo;
+    int player = game->turn;
+    int found = MOVE_NONE;
+
+    generatePseudoLegalMoves(game, &pseudoLegal);
+    for(int i = 0; i < pseudoLegal.count; i++) {
+        if(MOVE_FROM(pseudoLegal.moves[i]) == MOVE_FROM(move) && MOVE_TO(pseudoLegal.moves[i]) == MOVE_TO(move)) {
+            found = pseudoLegal.moves[i];
+        }
+    }
+    if(found == MOVE_NONE) {
+        return 0;
+    }
+
+    makeMove(game, found, &undo);
+    if(isPlayerInCheck(game, player)) {
+        unmakeMove(game, found, &undo);
+        return -1;
+    }
+    copyChessboard(game->board, chessboard);
+    copyChessboard(game->board, chessboardPrevious);
+    if(outMove) {
+        *outMove = found;
+    }
+    return 1;
+}
+
+int refereeMove(struct position * game, struct chessPiece * chessboard, struct chessPiece * chessboardPrevious,
+                int selectRow, int selectColumn, int moveRow, int moveColumn, int promotion, int * outMove) {
+    /* The rules of the game. Engine matches and sessions move through here. Human players in playGame pick from the
+     * move generator's legal moves, and the differential test (Generate.c) checks that those are exactly the moves
+     * allowed here, so nobody can play by different rules.
+     *
+     * Validates and makes the move for the player in turn, and takes it back if it leaves the player's king checked.
+     * game is the same game as a position, it keeps the castling rights and the en passant square. The move is made
+     * on it too. chessboardPrevious must equal chessboard when called, and is kept in sync.
+     * Nothing is printed, a pawn reaching the last row is promoted to promotion.
+     * outMove (can be NULL) gets the move that was made, with its promotion and flags.
+     *
+     * Returns 1 if the move was made, 0 if the move is invalid, -1 if it would leave the king checked.
+     * */
+    int player = game->turn;
+    int from = SQUARE(selectRow, selectColumn);
+    int to = SQUARE(moveRow, moveColumn);
+    struct chessPiece piece = chessboard[from];
+
+    // A king moving two columns can only castle, a pawn moving diagonally to an empty square can only capture en
+    // passant.
+    if(piece.owner == player && ((piece.rank == 6 && selectRow == moveRow && abs(moveColumn - selectColumn) == 2) ||
+       (piece.rank == 1 && to == game->enPassantSquare && selectColumn != moveColumn))) {
+        return refereeSpecialMove(game, chessboard, chessboardPrevious, MOVE_ENCODE(from, to, 0), outMove);
+    }
+
+    // A pawn reaching the last row must promote.
+    int promotes = piece.rank == 1 && (moveRow == 0 || moveRow == 7);
+    if(promotes && (promotion < 2 || promotion > 5)) {
+        return 0;
+    }
+
+    if(validateAndMakeMove(chessboard, selectRow, selectColumn, moveRow, moveColumn, player, 0,
+                           promotes ? promotion : 0) != MOVE_VALID) {
+        return 0;
+    }
+
+    // Now we need to check if king became / remains checked.
+    if(checkForCheckedKing(chessboard, player, 0)) {
+        // Cancel move
+        copyChessboard(chessboardPrevious, chessboard);
+        return -1;
+    }
+
+    // Move was ok, bring chessboardPrevious and the game up to date. A pawn that changed rank was promoted.
+    copyChessboard(chessboard, chessboardPrevious);
+    int move = MOVE_ENCODE(from, to, (piece.rank == 1 && chessboard[to].rank != 1) ? chessboard[to].rank : 0);
+    struct undoRecord undo;
+    makeMove(game, move, &undo);
+    if(outMove) {
+        *outMove = move;
+    }
+    return 1;
+}
+
+static void printIllegalMoveReason(struct position * game, int from, int to, int kingCheckedStart) {
+    // Tell the player why a move is not one of the legal moves. Only illegal picks come here, so asking the rules
+    // for the reason costs nothing in the normal flow.
+    struct chessPiece piece = game->board[from];
+    int result = validateAndMakeMove(game->board, SQUARE_ROW(from), SQUARE_COLUMN(from), SQUARE_ROW(to),
+                                     SQUARE_COLUMN(to), game->turn, 1, 0);
+
+    // validateAndMakeMove doesn't know castling or en passant.
+    if(piece.rank == 6 && SQUARE_ROW(from) == SQUARE_ROW(to) && abs(SQUARE_COLUMN(to) - SQUARE_COLUMN(from)) == 2) {
+        result = MOVE_INVALID_CASTLING;
+    }
+    else if(piece.rank == 1 && to == game->enPassantSquare && SQUARE_COLUMN(from) != SQUARE_COLUMN(to)) {
+        result = MOVE_VALID;
+    }
+
+    if(result != MOVE_VALID) {
+        printf("%s\n", getMoveResultText(result));
+    }
+    // The move itself is fine, so it must leave the king checked.
+    else if(kingCheckedStart) {
+        printf("King remains checked, you must save the king.\n");
+    }
+    else {
+        printf("That move endangers your king, that is not allowed!\n");
+    }
+}
+
+static void printHint(struct hintAnalyzer * hint, struct position * pos) {
+    // Show the computer's best move so far for the position on the board. hint is NULL if hints are off.
+    struct searchResult result;
+    if(!hint) {
+        printf("Hints are off for this game.\n");
+        return;
+    }
+    if(!getHint(hint, &result)) {
+        printf("No suggestion yet, the computer is still thinking.\n");
+        return;
+    }
+
+    // Best move first, with the score for the player in turn.
+    printf("The computer's best moves (depth %d):\n", result.depth);
+    for(int i = 0; i < result.lineCount; i++) {
+        char san[SAN_MAX_LENGTH];
+        int mateMoves = scoreToMateMoves(result.lines[i].score);
+        moveToSan(pos, result.lines[i].pv[0], san);
+        if(mateMoves > 0) {
+            printf("  %d. %-8s mate in %d\n", i + 1, san, mateMoves);
+        }
+        else if(mateMoves < 0) {
+            printf("  %d. %-8s mated in %d\n", i + 1, san, -mateMoves);
+        }
+        else {
+            printf("  %d. %-8s %+.2f\n", i + 1, san, result.lines[i].score / 100.0);
+        }
+    }
+}
+
+static int stepGameHistory(struct moveHistory * game, int back, int computerPlayer) {
+    // Take back (back set) or redo a move. Against the computer, as many moves as it takes to get back to the
+    // player's turn. Returns 0 if there was nothing to take back or redo.
+    int (* step)(struct moveHistory *) = back ? takeBackMove : redoMove;
+    if(!step(game)) {
+        return 0;
+    }
+    while(game->current.turn == computerPlayer && step(game)) {
+        continue;
+    }
+    return 1;
+}
+
+static int showHistoryPosition(struct moveHistory * game, struct chessPiece * chessboard,
+                               struct chessPiece * chessboardPrevious, struct hintAnalyzer * computer) {
+    // Bring the chessboards to the position a take back or redo left the game in. Returns the player in turn.
+    copyChessboard(game->current.board, chessboard);
+    copyChessboard(game->current.board, chessboardPrevious);
+    // Whatever the computer was pondering, it's not the position on the board anymore.
+    if(computer) {
+        stopHint(computer);
+    }
+    return game->current.turn;
+}
+
+void playGame(int gameMode) {
+    /* Gameplay logic
+     * gameMode:
+     *      0 -> Load game state
+     *      1-3 -> Load scenario 1-3
+     *      4 -> New standard game
+     * */
+
+    // White (player 1) always starts.
+    int whoseTurn = 1;
+
+    // ints for square selection and move.
+    int xSelect = -1;
+    int ySelect = -1;
+    int xMove = -1;
+    int yMove= -1;
+
+    // Program checks if king is checked from the start of the move.
+    // If so, only moves that end check are valid.
+    int kingCheckedStart = 0;
+
+    // Checkmate flag
+    int checkmate = 0;
+    // Stalemate flag, the player in turn has no legal moves but isn't in check.
+    int stalemate = 0;
+    // DRAW_NONE, or the rule that ended the game in a draw.
+    int draw = DRAW_NONE;
+
+    // Clear console before game begins
+    clearConsole();
+
+    // Initialize a chessboard for the game.
+    struct chessPiece * chessboard = NULL;
+    chessboard = getInitChessboard();
+
+    if(gameMode >= 0 && gameMode <= 3) {
+        // If something goes wrong loading, free memory and get init chessboard.
+        if(!loadGameState(chessboard, &whoseTurn, gameMode)) {
+            printf("Failed to load the game, starting a new game instead.\n");
+            promptReturnToContinue();
+            // Load failed, free memory...
+            freeChessboardMemory(chessboard);
+            // and load initial chessboard setup.
+            chessboard = getInitChessboard();
+        }
+    }
+
+    // The game as its starting position and the moves made, with their undo records. It has the position on the
+    // board for the rules, the keys for the draw rules, the moves for export and what takebacks need.
+    struct moveHistory * game = (struct moveHistory *) malloc(sizeof(struct moveHistory));
+    if(!game) {
+        printf("Failed to allocate memory for the game.\n");
+        promptReturnToContinue();
+        freeChessboardMemory(chessboard);
+        return;
+    }
+    struct position startPosition;
+    setPositionFromChessboard(&startPosition, chessboard, whoseTurn);
+    initMoveHistory(game, &startPosition);
+
+    // Legal moves of the position on the board, and where the selected piece can go.
+    struct legalMoveCache moveCache;
+    clearLegalMoveCache(&moveCache);
+    int destinations[64];
+    int destinationCount = 0;
+
+    // Make a copy of the chessboard to keep previous move.
+    // We need this for check and checkmate validation.
+    struct chessPiece * chessboardPrevious = NULL;
+    chessboardPrevious = getEmptyChessboard();
+    copyChessboard(chessboard, chessboardPrevious);
+
+    // The computer can play player 2, thinking on player 1's time too. Otherwise it can analyze the position while
+    // the players think, '?' shows its best moves. Either way it searches with hintAnalyzer.
+    struct hintAnalyzer hintAnalyzer;
+    struct hintAnalyzer * hint = NULL;
+    struct hintAnalyzer * computer = NULL;
+    int computerPlayer = 0;
+    char computerMove[SAN_MAX_LENGTH] = "";
+    if(promptYesNo("Would you like to play against the computer? ")) {
+        if(initHintAnalyzer(&hintAnalyzer, HINT_HASH_MEGABYTES)) {
+            computer = &hintAnalyzer;
+            computerPlayer = 2;
+        }
+        else {
+            printf("Failed to allocate memory for the computer player, playing without it.\n");
+            promptReturnToContinue();
+        }
+    }
+    else if(promptYesNo("Would you like the computer to analyze while you think ('?' shows its best moves)? ")) {
+        if(initHintAnalyzer(&hintAnalyzer, HINT_HASH_MEGABYTES)) {
+            hint = &hintAnalyzer;
+            hint->multiPV = HINT_LINES;
+        }
+        else {
+            printf("Failed to allocate memory for analysis, playing without hints.\n");
+            promptReturnToContinue();
+        }
+    }
+
+    int gameId = ++gameCounter;
+
+    // Game loop, make absolutely sure the game always can end in some way (quit or end condition).
+    while(1) {
+        // Clear console
+        clearConsole();
+        // Exit info text
+        printf("Exit game / cancel move by entering '0' in selection. Take back / redo moves with '<' / '>'.\n");
+        printf(hint ? "Enter '?' to see what the computer would play.\n\n" : "\n");
+        // Draw chessboard
+        printChessboard(chessboard);
+
+        if(computerMove[0] != '\0') {
+            printf("The computer played %s.\n", computerMove);
+        }
+
+        // Ask current player to make a move
+        if(whoseTurn == 1) {
+            printf("Player 1 turn\n");
+        }
+        else {
+            printf("Player 2 turn\n");
+        }
+
+        // Errors logged during this move are tagged with it.
+        setLogContext(gameId, (game->count / 2) + 1);
+
+        // Check if king is checked from the start of the move.
+        kingCheckedStart = isPlayerInCheck(&game->current, whoseTurn);
+
+        // No legal moves ends the game, with checkmate if the king is checked and stalemate if not. The move
+        // generator knows en passant and pins, which the chessboard checks don't.
+        if(getCachedLegalMoves(&moveCache, &game->current)->count == 0) {
+            if(kingCheckedStart) {
+                checkmate = 1;
+            }
+            else {
+                stalemate = 1;
+            }
+            break;
+        }
+
+        // Repeated or dead positions end the game right away.
+        draw = getDrawReason(&game->keys, &game->current);
+        if(draw != DRAW_NONE) {
+            break;
+        }
+
+        // The computer's turn. If it has been pondering the position on the board, startHint lets that search go on,
+        // otherwise the search starts over, with what its transposition table learned while pondering.
+        if(whoseTurn == computerPlayer) {
+            printf("The computer is thinking...\n");
+            fflush(stdout);
+            struct searchResult result;
+            startHint(computer, &game->current, &game->keys);
+            if(!finishHint(computer, COMPUTER_MOVE_SECONDS, &result)) {
+                // The search thread couldn't be started, think on this thread instead.
+                struct searchLimits limits = {0, COMPUTER_MOVE_SECONDS, 0, 1};
+                setSearchHistory(computer->state, &game->keys);
+                searchPosition(computer->state, &game->current, &limits, &result);
+            }
+
+            // The referee checks the move on a copy, the history makes it.
+            int move = result.bestMove;
+            struct position refereed = game->current;
+            moveToSan(&game->current, move, computerMove);
+            if(refereeMove(&refereed, chessboard, chessboardPrevious, SQUARE_ROW(MOVE_FROM(move)),
+                           SQUARE_COLUMN(MOVE_FROM(move)), SQUARE_ROW(MOVE_TO(move)), SQUARE_COLUMN(MOVE_TO(move)),
+                           MOVE_PROMOTION(move), &move) != 1) {
+                logMessage(LOG_ERROR, ERROR_NONE, "playGame: referee rejected computer move %s", computerMove);
+                printf("\n\nThe computer tried an illegal move %s, the game can't go on.\n", computerMove);
+                promptReturnToContinue();
+                break;
+            }
+            if(!playHistoryMove(game, move)) {
+                printf("\n\nFailed to allocate memory for the game record, the game can't go on.\n");
+                promptReturnToContinue();
+                break;
+            }
+
+            // Ponder: think about the reply the search expects, on the player's time.
+            if(result.pvLength >= 2) {
+                struct position expected = game->current;
+                struct undoRecord undo;
+                makeMove(&expected, result.pv[1], &undo);
+                pushPositionHistory(&game->keys, game->current.key);
+                startHint(computer, &expected, &game->keys);
+                popPositionHistory(&game->keys);
+            }
+
+            whoseTurn = (whoseTurn % 2) + 1;
+            continue;
+        }
+
+        // Analyze the position on the board until the player has made a move.
+        if(hint) {
+            startHint(hint, &game->current, &game->keys);
+        }
+
+        while(1) {
+            // Get player pick
+            getSelectSquare(&xSelect, &ySelect, 0);
+
+            // Exit loop if player has entered '0'.
+            if(xSelect == SELECT_EXIT) {
+                break;
+            }
+            if(xSelect == SELECT_HINT) {
+                printHint(hint, &game->current);
+                continue;
+            }
+            if(xSelect == SELECT_TAKEBACK || xSelect == SELECT_REDO) {
+                if(stepGameHistory(game, xSelect == SELECT_TAKEBACK, computerPlayer)) {
+                    break;
+                }
+                printf((xSelect == SELECT_TAKEBACK) ? "No moves to take back.\n" : "No moves to redo.\n");
+                continue;
+            }
+
+            // Validate select
+            if(validateSelect(chessboard, ySelect, xSelect, whoseTurn)) {
+                destinationCount = getLegalDestinations(&moveCache, &game->current, SQUARE(ySelect, xSelect),
+                                                        destinations);
+                if(destinationCount > 0) {
+                    // Valid selection, break out of loop.
+                    break;
+                }
+                printf("That piece has no legal moves, please select another piece.\n");
+            }
+        }
+
+        // Exit game loop if player has entered '0'.
+        if(xSelect == -1) {
+            break;
+        }
+
+        // A move was taken back or redone, show the board as it is now.
+        if(xSelect == SELECT_TAKEBACK || xSelect == SELECT_REDO) {
+            whoseTurn = showHistoryPosition(game, chessboard, chessboardPrevious, computer);
+            computerMove[0] = '\0';
+            continue;
+        }
+
+        // Show where the selected piece can go.
+        clearConsole();
+        printf("Exit game / cancel move by entering '0' in selection. Take back / redo moves with '<' / '>'.\n");
+        printf(hint ? "Enter '?' to see what the computer would play.\n\n" : "\n");
+        printChessboardWithMoves(chessboard, destinations, destinationCount, whoseTurn);
+
+        while(1) {
+            // Prompt where player wants to move
+            getSelectSquare(&xMove, &yMove, 1);
+            if(xMove == SELECT_EXIT) {
+                break;
+            }
+            if(xMove == SELECT_HINT) {
+                printHint(hint, &game->current);
+                continue;
+            }
+            // Taking back or redoing a move cancels the selection.
+            if(xMove == SELECT_TAKEBACK || xMove == SELECT_REDO) {
+                if(stepGameHistory(game, xMove == SELECT_TAKEBACK, computerPlayer)) {
+                    break;
+                }
+                printf((xMove == SELECT_TAKEBACK) ? "No moves to take back.\n" : "No moves to redo.\n");
+                continue;
+            }
+
+            // The move must be one of the legal moves, so validating it is a lookup.
+            int move = findCachedMove(&moveCache, &game->current, SQUARE(ySelect, xSelect), SQUARE(yMove, xMove), 0);
+            if(move == MOVE_NONE) {
+                printIllegalMoveReason(&game->current, SQUARE(ySelect, xSelect), SQUARE(yMove, xMove),
+                                       kingCheckedStart);
+                continue;
+            }
+            if(MOVE_PROMOTION(move)) {
+                move = findCachedMove(&moveCache, &game->current, MOVE_FROM(move), MOVE_TO(move), promptPromotePawn());
+            }
+
+            // The player has moved, the analysis of the position is no longer needed.
+            if(hint) {
+                stopHint(hint);
+            }
+
+            // Make the move in the game's history and bring the chessboards up to date.
+            if(!playHistoryMove(game, move)) {
+                printf("Failed to allocate memory for the game record, move not made.\n");
+                continue;
+            }
+            copyChessboard(game->current.board, chessboard);
+            copyChessboard(game->current.board, chessboardPrevious);
+            break;
+        }
+        // Player chose to cancel move.
+        if(xMove == -1) {
+            continue;
+        }
+        if(xMove == SELECT_TAKEBACK || xMove == SELECT_REDO) {
+            whoseTurn = showHistoryPosition(game, chessboard, chessboardPrevious, computer);
+            computerMove[0] = '\0';
+            continue;
+        }
+
+        // Change player turn
+        whoseTurn = (whoseTurn % 2) + 1;
+    }
+
+    // Nothing left to analyze.
+    if(hint || computer) {
+        freeHintAnalyzer(&hintAnalyzer);
+    }
+
+    // If game ended in checkmate
+    if(checkmate) {
+        printf("\n\nPlayer %d won the game!\n", (whoseTurn % 2) + 1);
+        promptReturnToContinue();
+    }
+
+    // Or in a stalemate
+    else if(stalemate) {
+        printf("\n\nPlayer %d has no legal moves, the game is a draw by stalemate.\n", whoseTurn);
+        promptReturnToContinue();
+    }
+
+    // Or in a draw
+    else if(draw != DRAW_NONE) {
+        if(draw == DRAW_REPETITION) {
+            printf("\n\nThe same position appeared for the third time, the game is a draw.\n");
+        }
+        else if(draw == DRAW_FIFTY_MOVES) {
+            printf("\n\nFifty moves without a capture or a pawn move, the game is a draw.\n");
+        }
+        else {
+            printf("\n\nNeither player can checkmate anymore, the game is a draw.\n");
+        }
+        promptReturnToContinue();
+    }
+
+    // Ask user whether they wish to save their game.
+    else if(promptYesNo("Would you like to save the game (overwrites last save)? ")) {
+        save(chessboard, whoseTurn, 0);
+        promptReturnToContinue();
+    }
+
+    // Ask user whether they wish to export the moves.
+    if(game->count > 0 && promptYesNo("Would you like to export the game to PGN (appends to " FILE_PGN_EXPORT ")? ")) {
+        if(checkmate) {
+            exportGame(game, whoseTurn == 2 ? "1-0" : "0-1");
+        }
+        else if(stalemate || draw != DRAW_NONE) {
+            exportGame(game, "1/2-1/2");
+        }
+        else {
+            exportGame(game, "*");
+        }
+        promptReturnToContinue();
+    }
+
+    // Free memory allocated to the game record.
+    freeMoveHistory(game);
+    free(game);
+
+    // Free memory allocated to chessboard and chessboard previous.
+    chessboard = freeChessboardMemory(chessboard);
+    chessboardPrevious = freeChessboardMemory(chessboardPrevious);
+
+    setLogContext(0, 0);
+}
+
+void printTablebaseVerdict(struct chessPiece * chessboard) {
+    // Print the tablebase result of a scenario, player 1 to move. Prints nothing if there is no table for it.
+    struct position pos;
+    struct tablebaseResult result;
+
+    setPositionFromChessboard(&pos, chessboard, 1);
+    if(!probeTablebase(&pos, &result)) {
+        return;
+    }
+
+    if(result.wdl == 0) {
+        printf("Tablebase: draw with best play.\n");
+    }
+    else {
+        printf("Tablebase: player %d wins, mate in %d moves with best play.\n", (result.wdl == 1) ? 1 : 2,
+               result.movesToMate);
+    }
+}
+
+static int isWithinScenarioLimits(const struct position * scenario, int player, int rank) {
+    // Check the piece counts of player after placing a rank, and print why they are over the limits.
+    // Returns 1 if they are within the limits.
+    const int * counts = scenario->pieceCounts[player];
+
+    if(counts[6] > 1) {
+        printf("Invalid placement: Too many kings, you have 1/1.\n");
+        return 0;
+    }
+    int promoted = countPromotedPieces(counts);
+    if(counts[1] + promoted > 8) {
+        printf("Invalid placement: Too many %ss. Pawns and promoted pieces can be at most 8 together, this would "
+               "make %d.\n", getRankStr(rank), counts[1] + promoted);
+        return 0;
+    }
+    return 1;
+}
+
+void scenarioEditor() {
+    // Allows user to build chess scenarios
+    clearConsole();
+    int scenarioChoice = scenarioMenu();
+
+    // If cancel
+    if(scenarioChoice == 0) {
+        return;
+    }
+
+    // Scenario chessboard.
+    struct chessPiece * chessboard = NULL;
+    // In scenarios player 1 always starts, we still need a variable for loading.
+    int whoseTurn = 1;
+
+    // Play scenario
+    if(scenarioChoice >= 1 && scenarioChoice <= 3) {
+        playGame(scenarioChoice);
+        return;
+    }
+
+    // Load scenario
+    else if(scenarioChoice >= 4 && scenarioChoice <= 6) {
+        chessboard = getInitChessboard();
+        // If loading scenario fails, e.g. file doesn't exist, create empty chessboard.
+        if(!loadGameState(chessboard, &whoseTurn, scenarioChoice - 3)) {
+            printf("Failed to load scenario, continuing with empty chessboard.\n");
+            scenarioChoice = 7;
+            chessboard = freeChessboardMemory(chessboard);
+            promptReturnToContinue();
+        }
+    }
+
+    // New scenario
+    if(scenarioChoice == 7) {
+        // Check if user wants to start with standard setup
+        if(promptYesNo("Would you like to initialize scenario with standard setup? ") == 1) {
+            chessboard = getInitChessboard();
+
+        }
+        else {
+            chessboard = getEmptyChessboard();
+        }
+    }
+
+    // Check that we have a chessboard to work with.
+    if(!chessboard) {
+        printf("Failed to initialize scenario editor!\n");
+        promptReturnToContinue();
+        return;
+    }
+
+    // Print info about scenario editor
+    clearConsole();
+    printInfo("scenario");
+
+    // The scenario as a position too. Every placement goes to both, so its piece lists and king squares are always
+    // up to date. Player 1 starts scenarios.
+    struct position scenario;
+    setPositionFromChessboard(&scenario, chessboard, 1);
+
+    /*
+     * Scenario only allows what a real game could reach: one king per side, and pawns plus promoted pieces (every
+     * piece above 2 rooks, knights and bishops and 1 queen) at most 8. The counts come from the scenario position,
+     * placePiece keeps them up to date.
+     * */
+
+    // Array to hold chess piece placement data.
+    // Player, chess piece, x, y
+    int placement[4] = {0, 0, 0, 0};
+
+    // Scenario editor loop
+    while(1) {
+        // First clear console.
+        clearConsole();
+
+        // Print info on top
+        printf("0: Empty; 1: Pawn; 2: Rook; 3; Knight; 4: Bishop; 5: Queen; 6: King\n");
+        printf("Place: '[player] [rank] [position]' | Clear: '0 [position]'.\n");
+        printf("Enter '0' to stop.\n\n");
+        printChessboard(chessboard);
+
+        getScenarioPlacement(placement);
+
+        // TODO: Allow user to exit without saving when requirements aren't met
+
+        // Check for exit
+        if(placement[0] == -1) {
+
+            // Minimum requirements:
+            //      - King per side
+            //      - Neither player is in checkmate.
+            //      - At least one other piece.
+
+            // Check that both sides have a king
+            if(scenario.pieceCounts[1][6] != 1 || scenario.pieceCounts[2][6] != 1) {
+                printf("Both sides must have a king.\n");
+                promptReturnToContinue();
+                continue;
+            }
+            // Player 1 starts scenarios, so e.g. player 2 can't be in check.
+            int invalidReasons = validateChessboard(chessboard, 1);
+            if(invalidReasons) {
+                for(int i = 0; i < INVALID_REASON_COUNT; i++) {
+                    if(invalidReasons & (1 << i)) {
+                        printf("%s\n", getInvalidReasonText(1 << i));
+                    }
+                }
+                printf("Please modify the scenario.\n");
+                promptReturnToContinue();
+                continue;
+            }
+            if(isPlayerInCheck(&scenario, 1)) {
+                if(checkForCheckmate(chessboard, 1)) {
+                    printf("Player 1 is in checkmate, please modify the scenario.\n");
+                    promptReturnToContinue();
+                    continue;
+                }
+            }
+            if(isPlayerInCheck(&scenario, 2)) {
+                if(checkForCheckmate(chessboard, 2)) {
+                    printf("Player 2 is in checkmate, please modify the scenario.\n");
+                    promptReturnToContinue();
+                    continue;
+                }
+            }
+            // Check that there is at least one other chess piece in addition to the kings.
+            if(scenario.pieceListCount[1] + scenario.pieceListCount[2] < 3) {
+                printf("This setup is a stalemate, please modify the scenario.\n");
+                promptReturnToContinue();
+                continue;
+            }
+
+            // Endgames small enough for the tablebases get a perfect answer.
+            printTablebaseVerdict(chessboard);
+
+            printf("You are about to stop editing this scenario.\n");
+            if(promptYesNo("Are you sure? ") == 1) {
+                break;
+            }
+            else {
+                continue;
+            }
+        }
+
+        // Place the piece / clear the square on the scenario position first, and take it back if it breaks the
+        // limits.
+        int square = SQUARE(placement[3], placement[2]);
+        struct chessPiece previous = chessboard[square];
+        struct chessPiece placed = {placement[1], placement[0]};
+        placePiece(&scenario, square, placed);
+        if(placement[0] != 0 && !isWithinScenarioLimits(&scenario, placement[0], placement[1])) {
+            placePiece(&scenario, square, previous);
+            // Let user read error before moving on.
+            promptReturnToContinue();
+            continue;
+        }
+
+        // Everything should be clear, so let's place the piece / clear square.
+        chessboard[square] = scenario.board[square];
+    }
+
+    int userChoice = 0;
+    printf("\n");
+
+    while(userChoice == 0) {
+        // User: save or not?
+        userChoice = saveScenarioMenu();
+
+        // Confirm no save
+        if(userChoice == 0) {
+            printf("\nThis scenario build will be gone for good.\n");
+            userChoice = promptYesNo("Are you sure? ");
+            if(userChoice == 1) {
+                userChoice = 0;
+                break;
+            }
+        }
+        printf("\n");
+    }
+
+    // If save scenario
+    if(userChoice > 0 && userChoice < 4) {
+        save(chessboard, 1, userChoice);
+    }
+
+    // Finally, free memory allocated to chessboard.
+    chessboard = freeChessboardMemory(chessboard);
+
+}
+
+void start(int showWelcome) {
+    // Clear console before we get started.
+    clearConsole();
+
+    // Print welcome if showWelcome.
+    if(showWelcome) {
+        printInfo("welcome");
+    }
+
+    // Game state is where in the program we are (play game, exit, etc.)
+    int gameState = 0;
+
+    do {
+        // Clear the console
+        clearConsole();
+        // Print menu
+        gameState = menu();
+
+        switch(gameState) {
+            // Play game
+            case 1:
+                playGame(4);
+                break;
+            // Load game
+            case 2:
+                playGame(0);
+                break;
+            // Scenario builder
+            case 3:
+                scenarioEditor();
+                break;
+            // Information
+            case 4:
+                clearConsole();
+                printInfo("information");
+                break;
+
+            default:
+                printf("\nThank you for playing!\n\n");
+        }
+
+    } while(gameState != 0);
+
+}
+
@@ -1,12 +1,17 @@
-/*
-File            Gameplay.h
-Author          Toni Lindeman
-Description:    Gameplay logic.
-*/
-
-#ifndef GAMEPLAY_H
-#define GAMEPLAY_H
-
-void start(int showWelcome);
-
-#endif /* GAMEPLAY_H */
+/*
+File            Gameplay.h
+Author          Toni Lindeman
+Description:    Gameplay logic.
+*/
+
+#ifndef GAMEPLAY_H
+#define GAMEPLAY_H
+
+#include "ChessPiece.h"
+#include "Position.h"
+
+int refereeMove(struct position * game, struct chessPiece * chessboard, struct chessPiece * chessboardPrevious,
+                int selectRow, int selectColumn, int moveRow, int moveColumn, int promotion, int * outMove);
+void start(int showWelcome);
+
+#endif /* GAMEPLAY_H */
@@ -0,0 +1,331 @@
+/*
+File:           Generate.c
+Author:         Toni Lindeman
+Description:    Seeded random legal positions for scenarios, benchmarks and testing.
+
+Pieces of the requested material are dropped on random squares until the result passes validatePosition and
+the player in turn has a legal move (so it isn't checkmate or stalemate). With mateIn set, the position must
+also have a mate in at most that many moves, proven by the mate solver (Mate.c). A position the solver gives up
+on within GENERATE_MATE_NODES nodes counts as having none.
+
+Position n only depends on the seed and n: it gets its own random stream, so the output is the same for any
+number of threads. Threads take every threadCount-th position of a round and the round is printed in order.
+
+The differential mode runs compareMoveGeneration on every position instead of printing it. It checks that the
+move generator and the game's own rules (refereeMove, built on validateAndMakeMove) allow exactly the same
+moves.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "OSSpecific.h"
+#include "ChessPiece.h"
+#include "Chessboard.h"
+#include "Gameplay.h"
+#include "MoveGen.h"
+#include "Notation.h"
+#include "Validate.h"
+#include "Zobrist.h"
+#include "Generate.h"
+
+// Positions per round
+#define GENERATE_ROUND 4096
+#define GENERATE_HASH_MEGABYTES 1
+// Nodes the mate solver may spend on one placement
+#define GENERATE_MATE_NODES 2000000
+
+struct generatorRound {
+    const struct generatorSettings * settings;
+    long first;
+    long count;
+    // One line per position, empty if generating it failed.
+    char (* lines)[2 * FEN_MAX_LENGTH];
+    long failures;
+    long mismatches;
+};
+
+struct generatorJob {
+    struct generatorRound * round;
+    int threadIndex;
+    struct mateSolver * solver;
+    long failures;
+    long mismatches;
+};
+
+int parseMaterialSignature(const char * text, int outCounts[3][7]) {
+    // E.g. "KQPvKR": player 1's pieces, 'v', player 2's pieces. Returns 1 if the signature can be a position.
+    static const char letters[] = " PRNBQK";
+    int owner = 1;
+
+    memset(outCounts, 0, 3 * 7 * sizeof(int));
+    for(int i = 0; text[i] != '\0'; i++) {
+        char letter = text[i];
+        if(letter == 'v' && owner == 1) {
+            owner = 2;
+            continue;
+        }
+        if(letter >= 'a' && letter <= 'z') {
+            letter -= 'a' - 'A';
+        }
+        const char * found = (letter != ' ') ? strchr(letters, letter) : NULL;
+        if(!found || letter == '\0') {
+            return 0;
+        }
+        outCounts[owner][found - letters]++;
+    }
+    if(owner != 2) {
+        return 0;
+    }
+
+    // Same limits as validatePosition.
+    for(owner = 1; owner <= 2; owner++) {
+        if(outCounts[owner][6] != 1 || outCounts[owner][1] + countPromotedPieces(outCounts[owner]) > 8) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// GENERATION ----------------------------------------------------------------------------------------------------------
+static void placePieces(const struct generatorSettings * settings, uint64_t * randomState, struct position * pos) {
+    // Drop every piece on a random empty square, pawns only on rows 2-7.
+    memset(pos->board, 0, sizeof(pos->board));
+
+    for(int owner = 1; owner <= 2; owner++) {
+        for(int rank = 6; rank >= 1; rank--) {
+            for(int i = 0; i < settings->counts[owner][rank]; i++) {
+                int square = 0;
+                do {
+                    uint64_t random = nextRandom(randomState);
+                    square = (rank == 1) ? 8 + (int)(random % 48) : (int)(random % 64);
+                } while(pos->board[square].rank != 0);
+                pos->board[square].rank = rank;
+                pos->board[square].owner = owner;
+            }
+        }
+    }
+}
+
+int generatePosition(const struct generatorSettings * settings, long index, struct mateSolver * solver,
+                     struct position * outPos) {
+    // Generate position number index. solver is only needed for mateIn, NULL otherwise.
+    // Returns the number of placements tried, 0 if none of GENERATE_MAX_ATTEMPTS worked.
+    uint64_t randomState = settings->seed ^ ((uint64_t) index * 0xD1B54A32D192ED03ULL);
+    nextRandom(&randomState);
+
+    for(int attempt = 1; attempt <= GENERATE_MAX_ATTEMPTS; attempt++) {
+        placePieces(settings, &randomState, outPos);
+        outPos->turn = settings->turn ? settings->turn : 1 + (int)(nextRandom(&randomState) & 1);
+        outPos->halfmoveClock = 0;
+        outPos->fullmoveNumber = 1;
+        outPos->castlingRights = 0;
+        outPos->enPassantSquare = NO_SQUARE;
+        outPos->key = computePositionKey(outPos);
+        outPos->pawnKey = computePawnKey(outPos);
+        computePieceCounts(outPos);
+
+        if(validatePosition(outPos)) {
+            continue;
+        }
+
+        struct moveList list;
+        generateLegalMoves(outPos, &list);
+        if(list.count == 0) {
+            continue;
+        }
+
+        if(settings->mateIn && solver) {
+            struct mateResult result;
+            if(solveMate(solver, outPos, settings->mateIn, &result) <= 0) {
+                continue;
+            }
+        }
+        return attempt;
+    }
+    return 0;
+}
+
+// DIFFERENTIAL TESTING ------------------------------------------------------------------------------------------------
+int compareMoveGeneration(struct position * pos, int * outMove) {
+    // Try every from / to pair with refereeMove and check that exactly the generated moves pass.
+    // Promotions count as one move, refereeMove tries them as queens. Returns 1 if they agree, 0 if not
+    // (outMove is then a move only one of them allows), -1 if out of memory.
+    int generated[64][64];
+    struct moveList list;
+
+    memset(generated, 0, sizeof(generated));
+    generateLegalMoves(pos, &list);
+    for(int i = 0; i < list.count; i++) {
+        generated[MOVE_FROM(list.moves[i])][MOVE_TO(list.moves[i])] = 1;
+    }
+
+    struct chessPiece * chessboard = getEmptyChessboard();
+    struct chessPiece * chessboardPrevious = getEmptyChessboard();
+    if(!chessboard || !chessboardPrevious) {
+        freeChessboardMemory(chessboard);
+        freeChessboardMemory(chessboardPrevious);
+        return -1;
+    }
+    copyChessboard(pos->board, chessboard);
+    copyChessboard(pos->board, chessboardPrevious);
+
+    int agree = 1;
+    for(int from = 0; from < 64 && agree; from++) {
+        if(pos->board[from].owner != pos->turn) {
+            continue;
+        }
+        for(int to = 0; to < 64; to++) {
+            if(from == to) {
+                continue;
+            }
+            struct position game = *pos;
+            int allowed = refereeMove(&game, chessboard, chessboardPrevious, SQUARE_ROW(from), SQUARE_COLUMN(from),
+                                      SQUARE_ROW(to), SQUARE_COLUMN(to), 5, NULL) == 1;
+            if(allowed) {
+                // Take the move back for the next try.
+                copyChessboard(pos->board, chessboard);
+                copyChessboard(pos->board, chessboardPrevious);
+            }
+            if(allowed != generated[from][to]) {
+                *outMove = MOVE_ENCODE(from, to, 0);
+                agree = 0;
+                break;
+            }
+        }
+    }
+
+    freeChessboardMemory(chessboard);
+    freeChessboardMemory(chessboardPrevious);
+    return agree;
+}
+
+// PARALLEL RUNS -------------------------------------------------------------------------------------------------------
+static void * generatorWorker(void * argument) {
+    struct generatorJob * job = (struct generatorJob *) argument;
+    struct generatorRound * round = job->round;
+    const struct generatorSettings * settings = round->settings;
+    int step = settings->threadCount;
+
+    for(long i = job->threadIndex; i < round->count; i += step) {
+        struct position pos;
+        char * line = round->lines[i];
+        line[0] = '\0';
+
+        if(!generatePosition(settings, round->first + i, job->solver, &pos)) {
+            job->failures++;
+            continue;
+        }
+
+        char fen[FEN_MAX_LENGTH];
+        writeFen(&pos, fen);
+        if(!settings->differential) {
+            strcpy(line, fen);
+            continue;
+        }
+
+        int move = MOVE_NONE;
+        if(compareMoveGeneration(&pos, &move) == 0) {
+            char coordinate[8];
+            moveToCoordinate(move, coordinate);
+            sprintf(line, "mismatch %ld %s %s", round->first + i, fen, coordinate);
+            job->mismatches++;
+        }
+    }
+    return NULL;
+}
+
+int runGenerator(const struct generatorSettings * settings, int scenarioSlot) {
+    // Print settings->count positions as FENs to stdout, or with scenarioSlot 1-3 save the first one as that
+    // scenario. Returns 0 on failure.
+    int threadCount = settings->threadCount;
+    struct generatorRound round;
+    // Scenarios always start with player 1's turn.
+    struct generatorSettings scenarioSettings = *settings;
+    scenarioSettings.turn = 1;
+    round.settings = (scenarioSlot > 0) ? &scenarioSettings : settings;
+    round.lines = malloc(GENERATE_ROUND * sizeof(*round.lines));
+    struct generatorJob * jobs = (struct generatorJob *) calloc(threadCount, sizeof(struct generatorJob));
+    pthread_t * threads = (pthread_t *) malloc(threadCount * sizeof(pthread_t));
+    int success = round.lines && jobs && threads;
+
+    // Mate proofs need a mate solver per thread.
+    for(int i = 0; i < threadCount && success && settings->mateIn; i++) {
+        jobs[i].solver = (struct mateSolver *) malloc(sizeof(struct mateSolver));
+        if(!jobs[i].solver || !initMateSolver(jobs[i].solver, GENERATE_HASH_MEGABYTES)) {
+            free(jobs[i].solver);
+            jobs[i].solver = NULL;
+            success = 0;
+            break;
+        }
+        jobs[i].solver->nodeLimit = GENERATE_MATE_NODES;
+    }
+    if(!success) {
+        fprintf(stderr, "Failed to allocate memory for the generator.\n");
+    }
+
+    long total = (scenarioSlot > 0) ? 1 : settings->count;
+    double startTime = getTimeSeconds();
+
+    for(long first = 0; first < total && success; first += GENERATE_ROUND) {
+        round.first = first;
+        round.count = (total - first < GENERATE_ROUND) ? total - first : GENERATE_ROUND;
+
+        int started = 0;
+        for(int i = 0; i < threadCount; i++) {
+            jobs[i].round = &round;
+            jobs[i].threadIndex = i;
+            if(pthread_create(&threads[i], NULL, generatorWorker, &jobs[i]) != 0) {
+                fprintf(stderr, "Failed to start generator thread %d.\n", i);
+                success = 0;
+                break;
+            }
+            started++;
+        }
+        for(int i = 0; i < started; i++) {
+            pthread_join(threads[i], NULL);
+        }
+
+        for(long i = 0; i < round.count && success; i++) {
+            if(round.lines[i][0] == '\0') {
+                continue;
+            }
+            if(scenarioSlot > 0) {
+                struct position pos;
+                setPositionFromFen(&pos, round.lines[i]);
+                success = save(pos.board, 1, scenarioSlot);
+            }
+            else {
+                printf("%s\n", round.lines[i]);
+            }
+        }
+    }
+    fflush(stdout);
+
+    long failures = 0;
+    long mismatches = 0;
+    for(int i = 0; i < threadCount && jobs; i++) {
+        failures += jobs[i].failures;
+        mismatches += jobs[i].mismatches;
+        if(jobs[i].solver) {
+            freeMateSolver(jobs[i].solver);
+            free(jobs[i].solver);
+        }
+    }
+
+    double seconds = getTimeSeconds() - startTime;
+    fprintf(stderr, "Generated %ld positions in %.2f s with %d threads, %.0f positions/second.\n",
+            total - failures, seconds, threadCount, seconds > 0 ? (total - failures) / seconds : 0.0);
+    if(failures) {
+        fprintf(stderr, "No position found for %ld of them in %d tries.\n", failures, GENERATE_MAX_ATTEMPTS);
+    }
+    if(settings->differential) {
+        fprintf(stderr, "Move generation and the rules disagree in %ld positions.\n", mismatches);
+    }
+
+    free(round.lines);
+    free(jobs);
+    free(threads);
+    return success && (!settings->differential || mismatches == 0) && failures < total;
+}
@@ -0,0 +1,37 @@
+/*
+File:           Generate.h
+Author:         Toni Lindeman
+Description:    Seeded random legal positions for scenarios, benchmarks and testing.
+*/
+
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include <stdint.h>
+#include "Position.h"
+#include "Mate.h"
+
+// Random placements tried for one position before giving up.
+#define GENERATE_MAX_ATTEMPTS 100000
+
+struct generatorSettings {
+    // Pieces per player (1 and 2) and rank, kings included.
+    int counts[3][7];
+    // Player in turn, 0 picks one at random for every position.
+    int turn;
+    // If not 0, the player in turn must have a mate in at most this many moves, proven by the mate solver.
+    int mateIn;
+    uint64_t seed;
+    long count;
+    int threadCount;
+    // Instead of printing positions, compare move generation against validateAndMakeMove on each.
+    int differential;
+};
+
+int parseMaterialSignature(const char * text, int outCounts[3][7]);
+int generatePosition(const struct generatorSettings * settings, long index, struct mateSolver * solver,
+                     struct position * outPos);
+int compareMoveGeneration(struct position * pos, int * outMove);
+int runGenerator(const struct generatorSettings * settings, int scenarioSlot);
+
+#endif /* GENERATE_H */
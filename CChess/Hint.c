@@ -0,0 +1,142 @@
+/*
+File:           Hint.c
+Author:         Toni Lindeman
+Description:    Background analysis of the position on the board while a player thinks.
+
+The game loop spends most of its time waiting for the player to type a square. startHint searches the position on
+a thread of its own meanwhile, and every finished iteration is published to the analyzer's result, where getHint
+can read it at any time. stopHint ends the search and waits for the thread, the game calls it once a move is made.
+The search state lives as long as the analyzer, so what was learned about one position helps with the next.
+
+A computer player thinks on its opponent's time the same way. After its move it analyzes the position after the
+reply it expects, and on its next turn starts analyzing the position actually on the board. If the expected reply
+was played that does nothing and the search so far counts (a ponder hit), otherwise the search is stopped and
+started again. finishHint then gives the search its thinking time.
+*/
+
+#include <stdlib.h>
+#include "OSSpecific.h"
+#include "Hint.h"
+
+static void publishIteration(const struct searchResult * result, void * context) {
+    // Runs on the analysis thread after every finished iteration.
+    struct hintAnalyzer * hint = (struct hintAnalyzer *) context;
+
+    pthread_mutex_lock(&hint->lock);
+    hint->result = *result;
+    pthread_mutex_unlock(&hint->lock);
+
+    if(atomic_load(&hint->stopRequested)) {
+        stopSearch(hint->state);
+    }
+}
+
+static void * hintWorker(void * argument) {
+    struct hintAnalyzer * hint = (struct hintAnalyzer *) argument;
+
+    // No limits, the search runs until it is stopped or finds nothing more to learn.
+    struct searchLimits limits = {0, 0, 0, hint->multiPV};
+    struct searchResult result;
+    searchPosition(hint->state, &hint->position, &limits, &result);
+    atomic_store(&hint->searching, 0);
+    return NULL;
+}
+
+int initHintAnalyzer(struct hintAnalyzer * hint, size_t hashMegabytes) {
+    // Returns 0 if the search state couldn't be allocated.
+    hint->running = 0;
+    hint->multiPV = 1;
+    atomic_init(&hint->searching, 0);
+    atomic_init(&hint->stopRequested, 0);
+    hint->result.bestMove = MOVE_NONE;
+
+    // Search state is large, keep it off the stack.
+    hint->state = (struct searchState *) malloc(sizeof(struct searchState));
+    if(!hint->state || !initSearchState(hint->state, hashMegabytes)) {
+        free(hint->state);
+        hint->state = NULL;
+        return 0;
+    }
+    pthread_mutex_init(&hint->lock, NULL);
+    return 1;
+}
+
+void freeHintAnalyzer(struct hintAnalyzer * hint) {
+    if(!hint->state) {
+        return;
+    }
+    stopHint(hint);
+    pthread_mutex_destroy(&hint->lock);
+    freeSearchState(hint->state);
+    free(hint->state);
+    hint->state = NULL;
+}
+
+int startHint(struct hintAnalyzer * hint, const struct position * pos, const struct positionHistory * history) {
+    // Start analyzing pos, with history the positions played before it (can be NULL).
+    // Does nothing if pos is already being analyzed. Returns 0 if the analysis couldn't be started.
+    if(!hint->state) {
+        return 0;
+    }
+    if(hint->running && hint->position.key == pos->key) {
+        return 1;
+    }
+    stopHint(hint);
+
+    hint->position = *pos;
+    setSearchHistory(hint->state, history);
+    hint->state->onIteration = publishIteration;
+    hint->state->iterationContext = hint;
+    atomic_store(&hint->stopRequested, 0);
+    atomic_store(&hint->searching, 1);
+    pthread_mutex_lock(&hint->lock);
+    hint->result.bestMove = MOVE_NONE;
+    pthread_mutex_unlock(&hint->lock);
+
+    if(pthread_create(&hint->thread, NULL, hintWorker, hint) != 0) {
+        atomic_store(&hint->searching, 0);
+        return 0;
+    }
+    hint->running = 1;
+    return 1;
+}
+
+void stopHint(struct hintAnalyzer * hint) {
+    // Stop the analysis and wait for its thread. The last published result can still be read.
+    if(!hint->running) {
+        return;
+    }
+    atomic_store(&hint->stopRequested, 1);
+    stopSearch(hint->state);
+    pthread_join(hint->thread, NULL);
+    hint->running = 0;
+
+    // Searches of the game made with the state from now on publish nothing.
+    hint->state->onIteration = NULL;
+    hint->state->iterationContext = NULL;
+}
+
+int finishHint(struct hintAnalyzer * hint, double seconds, struct searchResult * outResult) {
+    // Give the analysis at most seconds more, then stop it and copy its result to outResult like getHint.
+    // Time already spent analyzing the position comes on top, so a computer player moves sooner and better after
+    // a ponder hit.
+    if(hint->running) {
+        double deadline = getTimeSeconds() + seconds;
+        while(atomic_load(&hint->searching) && getTimeSeconds() < deadline) {
+            sleepSeconds(HINT_POLL_SECONDS);
+        }
+        stopHint(hint);
+    }
+    return getHint(hint, outResult);
+}
+
+int getHint(struct hintAnalyzer * hint, struct searchResult * outResult) {
+    // Copy the deepest finished iteration to outResult. Returns 0 if there is no move to suggest yet.
+    if(!hint->state) {
+        return 0;
+    }
+    pthread_mutex_lock(&hint->lock);
+    *outResult = hint->result;
+    pthread_mutex_unlock(&hint->lock);
+    return outResult->bestMove != MOVE_NONE;
+}
@@ -0,0 +1,48 @@
+/*
+File:           Hint.h
+Author:         Toni Lindeman
+Description:    Background analysis of the position on the board while a player thinks.
+*/
+
+#ifndef HINT_H
+#define HINT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include "Position.h"
+#include "Search.h"
+
+#define HINT_HASH_MEGABYTES 16
+// How often finishHint looks if the search has ended by itself.
+#define HINT_POLL_SECONDS 0.01
+
+struct hintAnalyzer {
+    pthread_t thread;
+    // Guards result, the rest is only touched by the thread that starts and stops the analysis.
+    pthread_mutex_t lock;
+    // Analysis thread started and not yet joined.
+    int running;
+    // Cleared by the analysis thread when the search has ended, stopped or not.
+    atomic_int searching;
+    // Set by stopHint. The thread also checks it after every iteration, a stopSearch that comes before the search
+    // has started would be missed.
+    atomic_int stopRequested;
+    // Kept for the whole game, so the transposition table stays warm from move to move. Free to use for other
+    // searches of the game while the analysis is stopped.
+    struct searchState * state;
+    struct position position;
+    // Lines to find, set before startHint. 1 unless changed.
+    int multiPV;
+    // Deepest finished iteration for position, bestMove is MOVE_NONE until the first one.
+    struct searchResult result;
+};
+
+int initHintAnalyzer(struct hintAnalyzer * hint, size_t hashMegabytes);
+void freeHintAnalyzer(struct hintAnalyzer * hint);
+int startHint(struct hintAnalyzer * hint, const struct position * pos, const struct positionHistory * history);
+void stopHint(struct hintAnalyzer * hint);
+int finishHint(struct hintAnalyzer * hint, double seconds, struct searchResult * outResult);
+int getHint(struct hintAnalyzer * hint, struct searchResult * outResult);
+
+#endif /* HINT_H */
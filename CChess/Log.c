@@ -0,0 +1,247 @@
+/*
+File:           Log.c
+Author:         Toni Lindeman
+Description:    Asynchronous error log. Any thread can log without locking, a background thread writes the file.
+
+Messages go into a fixed size ring buffer shared by all threads. Every slot has a sequence number: a producer
+claims the next write position with a compare and swap, fills the slot and then publishes it by bumping the
+sequence, so a slow producer never blocks the others. The single flusher thread reads published slots in order
+and writes them to the log file. When the buffer is full the message is dropped and counted instead of waiting,
+the flusher writes the number of dropped messages into the log.
+
+Every line carries the game id and move number of the logging thread (see setLogContext) and an error code:
+2019-05-04 12:30:01 ERROR game=3 move=12 code=2(KING_NOT_FOUND) checkForCheckmate: failed to find king
+Before startLog and after stopLog messages are written straight to stderr.
+*/
+
+// localtime_r and clock_gettime are POSIX, not part of C11.
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include "OSSpecific.h"
+#include "Log.h"
+
+// How long the flusher sleeps when the buffer is empty.
+#define LOG_FLUSH_INTERVAL 0.01
+
+static const char * severityNames[4] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+static const char * errorCodeNames[ERROR_CODE_COUNT] = {
+    "NONE", "OUT_OF_MEMORY", "KING_NOT_FOUND", "ATTACKER_NOT_FOUND", "FILE_OPEN", "FILE_INVALID_DATA",
+    "FILE_TOO_SHORT"
+};
+
+struct logRecord {
+    struct timespec time;
+    int severity;
+    int gameId;
+    int moveNumber;
+    int errorCode;
+    char message[LOG_MESSAGE_LENGTH];
+};
+
+struct logSlot {
+    // Equal to the write position when the slot is free, write position + 1 once the record is published.
+    atomic_size_t sequence;
+    struct logRecord record;
+};
+
+static struct logSlot logBuffer[LOG_BUFFER_SIZE];
+static atomic_size_t logWritePosition;
+// Only touched by the flusher (or by stopLog after the flusher has finished).
+static size_t logReadPosition = 0;
+
+static atomic_int logRunning = 0;
+static atomic_long logDropped = 0;
+static long logDroppedReported = 0;
+static int logMinimumSeverity = LOG_DEBUG;
+static FILE * logFile = NULL;
+static pthread_t logThread;
+
+static _Thread_local int logGameId = 0;
+static _Thread_local int logMoveNumber = 0;
+
+// WRITING -------------------------------------------------------------------------------------------------------------
+static void writeLogRecord(FILE * file, const struct logRecord * record) {
+    char timeText[32];
+    struct tm localTime;
+    time_t seconds = record->time.tv_sec;
+    localtime_r(&seconds, &localTime);
+    strftime(timeText, sizeof(timeText), "%Y-%m-%d %H:%M:%S", &localTime);
+
+    fprintf(file, "%s %s game=%d move=%d code=%d(%s) %s\n", timeText, severityNames[record->severity],
+            record->gameId, record->moveNumber, record->errorCode, getErrorCodeName(record->errorCode),
+            record->message);
+}
+
+static int flushLogBuffer() {
+    // Write every published record. Returns the number of records written.
+    int written = 0;
+
+    while(1) {
+        struct logSlot * slot = &logBuffer[logReadPosition & (LOG_BUFFER_SIZE - 1)];
+        if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != logReadPosition + 1) {
+            // Empty, or the next producer is still filling its slot.
+            break;
+        }
+        writeLogRecord(logFile, &slot->record);
+        // Free the slot for the write position one lap ahead.
+        atomic_store_explicit(&slot->sequence, logReadPosition + LOG_BUFFER_SIZE, memory_order_release);
+        logReadPosition++;
+        written++;
+    }
+
+    long dropped = atomic_load_explicit(&logDropped, memory_order_relaxed);
+    if(dropped != logDroppedReported) {
+        struct logRecord record = {.severity = LOG_WARNING, .errorCode = ERROR_NONE};
+        clock_gettime(CLOCK_REALTIME, &record.time);
+        snprintf(record.message, sizeof(record.message), "log buffer full, %ld messages dropped",
+                 dropped - logDroppedReported);
+        writeLogRecord(logFile, &record);
+        logDroppedReported = dropped;
+        written++;
+    }
+
+    if(written) {
+        fflush(logFile);
+    }
+    return written;
+}
+
+static void * logFlusherThread(void * argument) {
+    (void) argument;
+
+    while(atomic_load(&logRunning)) {
+        if(!flushLogBuffer()) {
+            sleepSeconds(LOG_FLUSH_INTERVAL);
+        }
+    }
+    return NULL;
+}
+
+// PUBLIC FUNCTIONS ----------------------------------------------------------------------------------------------------
+int startLog(const char * fileName, int minimumSeverity) {
+    // Open the log file for appending and start the flusher. The log is closed automatically at exit.
+    // Returns 1 on success, 0 if the file or the thread can't be made (messages then keep going to stderr).
+    if(atomic_load(&logRunning)) {
+        return 1;
+    }
+
+    logFile = fopen(fileName, "a");
+    if(!logFile) {
+        return 0;
+    }
+
+    for(size_t i = 0; i < LOG_BUFFER_SIZE; i++) {
+        atomic_init(&logBuffer[i].sequence, i);
+    }
+    atomic_store(&logWritePosition, 0);
+    logReadPosition = 0;
+    logMinimumSeverity = minimumSeverity;
+
+    atomic_store(&logRunning, 1);
+    if(pthread_create(&logThread, NULL, logFlusherThread, NULL) != 0) {
+        atomic_store(&logRunning, 0);
+        fclose(logFile);
+        logFile = NULL;
+        return 0;
+    }
+
+    atexit(stopLog);
+    return 1;
+}
+
+void stopLog() {
+    // Stop the flusher, write what is left and close the file. Safe to call more than once.
+    if(!atomic_exchange(&logRunning, 0)) {
+        return;
+    }
+    pthread_join(logThread, NULL);
+
+    // A message may have been published after the flusher's last pass.
+    flushLogBuffer();
+    fclose(logFile);
+    logFile = NULL;
+}
+
+void setLogContext(int gameId, int moveNumber) {
+    // Game id and move number of the calling thread's messages, 0 when not in a game.
+    logGameId = gameId;
+    logMoveNumber = moveNumber;
+}
+
+void logMessage(int severity, int errorCode, const char * format, ...) {
+    if(severity < LOG_DEBUG || severity > LOG_ERROR || severity < logMinimumSeverity) {
+        return;
+    }
+
+    va_list arguments;
+    va_start(arguments, format);
+
+    if(!atomic_load_explicit(&logRunning, memory_order_acquire)) {
+        // No log file, write the message right away.
+        struct logRecord record = {.severity = severity, .gameId = logGameId, .moveNumber = logMoveNumber,
+                                   .errorCode = errorCode};
+        clock_gettime(CLOCK_REALTIME, &record.time);
+        vsnprintf(record.message, sizeof(record.message), format, arguments);
+        writeLogRecord(stderr, &record);
+        va_end(arguments);
+        return;
+    }
+
+    // Claim a slot
+    struct logSlot * slot = NULL;
+    size_t position = atomic_load_explicit(&logWritePosition, memory_order_relaxed);
+    while(1) {
+        slot = &logBuffer[position & (LOG_BUFFER_SIZE - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+        if(difference == 0) {
+            // Slot is free, try to take it. On failure position is reloaded and we try again.
+            if(atomic_compare_exchange_weak_explicit(&logWritePosition, &position, position + 1,
+                                                     memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if(difference < 0) {
+            // The flusher hasn't freed this slot yet, the buffer is full.
+            atomic_fetch_add_explicit(&logDropped, 1, memory_order_relaxed);
+            va_end(arguments);
+            return;
+        }
+        else {
+            // Another producer took this position.
+            position = atomic_load_explicit(&logWritePosition, memory_order_relaxed);
+        }
+    }
+
+    // Fill and publish
+    struct logRecord * record = &slot->record;
+    clock_gettime(CLOCK_REALTIME, &record->time);
+    record->severity = severity;
+    record->gameId = logGameId;
+    record->moveNumber = logMoveNumber;
+    record->errorCode = errorCode;
+    vsnprintf(record->message, sizeof(record->message), format, arguments);
+    va_end(arguments);
+
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+}
+
+const char * getErrorCodeName(int errorCode) {
+    if(errorCode < 0 || errorCode >= ERROR_CODE_COUNT) {
+        return "UNKNOWN";
+    }
+    return errorCodeNames[errorCode];
+}
+
+long getDroppedLogMessages() {
+    return atomic_load(&logDropped);
+}
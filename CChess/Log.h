@@ -0,0 +1,40 @@
+/*
+File:           Log.h
+Author:         Toni Lindeman
+Description:    Asynchronous error log. Any thread can log without locking, a background thread writes the file.
+*/
+
+#ifndef LOG_H
+#define LOG_H
+
+#define FILE_LOG "cchess.log"
+
+// Severity levels
+#define LOG_DEBUG 0
+#define LOG_INFO 1
+#define LOG_WARNING 2
+#define LOG_ERROR 3
+
+// Error codes, names are in the table in Log.c.
+#define ERROR_NONE 0
+#define ERROR_OUT_OF_MEMORY 1
+#define ERROR_KING_NOT_FOUND 2
+#define ERROR_ATTACKER_NOT_FOUND 3
+#define ERROR_FILE_OPEN 4
+#define ERROR_FILE_INVALID_DATA 5
+#define ERROR_FILE_TOO_SHORT 6
+#define ERROR_CODE_COUNT 7
+
+// Messages longer than this are cut.
+#define LOG_MESSAGE_LENGTH 160
+// Ring buffer slots, must be a power of two. Messages logged while the buffer is full are dropped and counted.
+#define LOG_BUFFER_SIZE 1024
+
+int startLog(const char * fileName, int minimumSeverity);
+void stopLog();
+void setLogContext(int gameId, int moveNumber);
+void logMessage(int severity, int errorCode, const char * format, ...) __attribute__((format(printf, 3, 4)));
+const char * getErrorCodeName(int errorCode);
+long getDroppedLogMessages();
+
+#endif /* LOG_H */
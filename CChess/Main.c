@@ -4,11 +4,361 @@ Author          Toni Lindeman
 Description:    Program starts here, all gameplay logic is handled in the rest of the source files.
 */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "Gameplay.h"
+#include "OSSpecific.h"
+#include "Zobrist.h"
+#include "PGN.h"
+#include "Analyze.h"
+#include "Match.h"
+#include "Book.h"
+#include "Tablebase.h"
+#include "Stats.h"
+#include "Log.h"
+#include "Server.h"
+#include "Validate.h"
+#include "Generate.h"
+#include "Mate.h"
+#include "Search.h"
+#include "Network.h"
+#include "MoveGen.h"
+#include "Notation.h"
 
-// Command line argument 1: show welcome text
+// Published perft counts, depth 1 first.
+#define PERFT_MAX_DEPTH 6
+
+struct perftReference {
+    const char * name;
+    const char * fen;
+    // Depth the suite runs to by default.
+    int depth;
+    long long nodes[PERFT_MAX_DEPTH];
+};
+
+static const struct perftReference perftSuite[] = {
+    {"initial", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+     {48, 2039, 97862, 4085603, 193690690, 8031647685}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6,
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+     {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+     {44, 1486, 62379, 2103487, 89941194, 0}},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+     {46, 2079, 89890, 3894594, 164075551, 6923051137}}
+};
+
+void printUsage() {
+    printf("Usage:\n");
+    printf("  CChess [show welcome 0/1]\n");
+    printf("  CChess --read-pgn <file.pgn> [out.pgn]\n");
+    printf("  CChess --analyze <file.epd> [--depth N] [--threads N] [--hash MB] [--multipv N]\n");
+    printf("  CChess --match [openings.epd] [--games N] [--threads N] [--tc seconds+increment] [--max-moves N]\n");
+    printf("         [--depth-a N] [--depth-b N] [--nodes-a N] [--nodes-b N] [--hash MB] [--elo0 N --elo1 N]\n");
+    printf("         [--book file.bin]\n");
+    printf("  CChess --build-tablebases [pieces] [--threads N]\n");
+    printf("  CChess --build-book <file.pgn> <out.bin> [--plies N] [--min-games N]\n");
+    printf("  CChess --validate <file.epd | -> [--threads N] [--illegal-only]\n");
+    printf("  CChess --generate <material, e.g. KQvKR> [--count N] [--seed N] [--turn w|b] [--mate-in N]\n");
+    printf("         [--threads N] [--scenario 1-3] [--differential]\n");
+    printf("  CChess --solve-mate <scenario 1-3 | file.scn | directory> [--moves N] [--threads N] [--hash MB]\n");
+    printf("         [--nodes N] [--checks-only]\n");
+    printf("  CChess --write-network <file.nnue>\n");
+    printf("  CChess --perft [fen] [--depth N]\n");
+    printf("  CChess --server <port | host:port | unix:path> [--max-games N]\n");
+    printf("  CChess --client <port | host:port | unix:path>\n");
+    printf("Search commands take [--network file.nnue], %s is used if it exists.\n", NETWORK_DEFAULT_FILE);
+}
+
+char * getStringOption(int argc, char * argv[], char * option) {
+    // Value of a "--option value" pair, or NULL if the option is not given.
+    for(int i = 2; i < argc - 1; i++) {
+        if(!strcmp(argv[i], option)) {
+            return argv[i + 1];
+        }
+    }
+    return NULL;
+}
+
+int getIntOption(int argc, char * argv[], char * option, int defaultValue) {
+    // Value of a "--option value" pair, or defaultValue if the option is not given.
+    char * value = getStringOption(argc, argv, option);
+    return value ? atoi(value) : defaultValue;
+}
+
+int runMatchCommand(int argc, char * argv[]) {
+    // Parse match options and run the match.
+    struct matchSettings settings;
+
+    settings.openingsFile = (argc >= 3 && strncmp(argv[2], "--", 2)) ? argv[2] : NULL;
+    settings.games = getIntOption(argc, argv, "--games", 100);
+    settings.threads = getIntOption(argc, argv, "--threads", getCoreCount());
+    settings.maxPlies = 2 * getIntOption(argc, argv, "--max-moves", 200);
+    settings.elo0 = getIntOption(argc, argv, "--elo0", 0);
+    settings.elo1 = getIntOption(argc, argv, "--elo1", 0);
+
+    for(int i = 0; i < 2; i++) {
+        settings.engines[i].name = (i == 0) ? "A" : "B";
+        settings.engines[i].depth = getIntOption(argc, argv, (i == 0) ? "--depth-a" : "--depth-b", 0);
+        settings.engines[i].nodes = getIntOption(argc, argv, (i == 0) ? "--nodes-a" : "--nodes-b", 0);
+        settings.engines[i].hashMegabytes = getIntOption(argc, argv, "--hash", 16);
+        settings.engines[i].book = NULL;
+    }
+
+    // Time control "base+increment" in seconds. Default is 10+0.1 unless depth or nodes limit the search.
+    settings.baseSeconds = 0;
+    settings.incrementSeconds = 0;
+    char * timeControl = getStringOption(argc, argv, "--tc");
+    int hasFixedLimits = settings.engines[0].depth || settings.engines[0].nodes || settings.engines[1].depth ||
+                         settings.engines[1].nodes;
+    if(timeControl) {
+        if(sscanf(timeControl, "%lf+%lf", &settings.baseSeconds, &settings.incrementSeconds) < 1) {
+            printUsage();
+            return 1;
+        }
+    }
+    else if(!hasFixedLimits) {
+        settings.baseSeconds = 10;
+        settings.incrementSeconds = 0.1;
+    }
+
+    // Both engines use the same book.
+    struct openingBook book = {NULL, 0, 0};
+    char * bookFile = getStringOption(argc, argv, "--book");
+    if(bookFile) {
+        if(!openBook(&book, bookFile)) {
+            return 1;
+        }
+        settings.engines[0].book = &book;
+        settings.engines[1].book = &book;
+    }
+
+    int success = 0;
+    if(settings.games < 1 || settings.threads < 1 || settings.maxPlies < 2 || settings.engines[0].hashMegabytes < 1) {
+        printUsage();
+    }
+    else {
+        success = runMatch(&settings);
+    }
+    closeBook(&book);
+    return success ? 0 : 1;
+}
+
+int runGenerateCommand(int argc, char * argv[]) {
+    // Parse generator options and print or save the positions.
+    struct generatorSettings settings;
+
+    if(!parseMaterialSignature(argv[2], settings.counts)) {
+        printf("Invalid material \"%s\", give each side's pieces like KQPvKR.\n", argv[2]);
+        return 1;
+    }
+    char * seed = getStringOption(argc, argv, "--seed");
+    settings.seed = seed ? strtoull(seed, NULL, 10) : 1;
+    settings.count = getIntOption(argc, argv, "--count", 1);
+    settings.mateIn = getIntOption(argc, argv, "--mate-in", 0);
+    settings.threadCount = getIntOption(argc, argv, "--threads", getCoreCount());
+    settings.differential = 0;
+    for(int i = 3; i < argc; i++) {
+        settings.differential |= !strcmp(argv[i], "--differential");
+    }
+
+    char * turn = getStringOption(argc, argv, "--turn");
+    settings.turn = 0;
+    if(turn) {
+        settings.turn = !strcmp(turn, "w") ? 1 : (!strcmp(turn, "b") ? 2 : -1);
+    }
+
+    int scenario = getIntOption(argc, argv, "--scenario", 0);
+    if(settings.count < 1 || settings.mateIn < 0 || settings.threadCount < 1 || settings.turn < 0 || scenario < 0 ||
+       scenario > 3) {
+        printUsage();
+        return 1;
+    }
+    return runGenerator(&settings, scenario) ? 0 : 1;
+}
+
+int runPerftCommand(int argc, char * argv[]) {
+    // Count the move tree of one FEN, or of the reference positions and compare with their published counts.
+    char * fen = (argc >= 3 && strncmp(argv[2], "--", 2)) ? argv[2] : NULL;
+    int depth = getIntOption(argc, argv, "--depth", 0);
+    int suiteSize = (int)(sizeof(perftSuite) / sizeof(perftSuite[0]));
+    int failures = 0;
+    long long totalNodes = 0;
+    double startTime = getTimeSeconds();
+
+    if(depth < 0 || (!fen && depth > PERFT_MAX_DEPTH)) {
+        printUsage();
+        return 1;
+    }
+
+    for(int i = 0; i < (fen ? 1 : suiteSize); i++) {
+        struct position pos;
+        const char * positionFen = fen ? fen : perftSuite[i].fen;
+        if(!setPositionFromFen(&pos, positionFen)) {
+            printf("Invalid FEN \"%s\".\n", positionFen);
+            return 1;
+        }
+        int positionDepth = depth ? depth : (fen ? 5 : perftSuite[i].depth);
+        double positionStart = getTimeSeconds();
+        long long nodes = perft(&pos, positionDepth);
+        double seconds = getTimeSeconds() - positionStart;
+        totalNodes += nodes;
+
+        printf("%-12s depth %d: %13lld nodes, %.2f s", fen ? "perft" : perftSuite[i].name, positionDepth, nodes,
+               seconds);
+        long long expected = fen ? 0 : perftSuite[i].nodes[positionDepth - 1];
+        if(expected) {
+            printf(expected == nodes ? ", ok" : ", expected %lld", expected);
+            failures += (expected != nodes);
+        }
+        printf("\n");
+    }
+
+    double seconds = getTimeSeconds() - startTime;
+    printf("%lld nodes in %.2f s, %.0f nodes/second.\n", totalNodes, seconds, seconds > 0 ? totalNodes / seconds : 0.0);
+    if(failures) {
+        printf("%d positions don't match the published counts.\n", failures);
+    }
+    return failures ? 1 : 0;
+}
+
+// Command line argument 1: show welcome text, or a command (starting with "--") to run without the menu.
 int main(int argc, char * argv[]) {
+    initZobristKeys();
+    // Prints hot path counters at exit in a statistics build, does nothing otherwise.
+    initStats();
+    // Errors go to the log file, or to stderr if it can't be opened.
+    startLog(FILE_LOG, LOG_INFO);
+    // Tablebases are optional, nothing happens if there are none.
+    openTablebases(TABLEBASE_DIRECTORY);
+    // Same for the evaluation network, the handwritten evaluation is used without one.
+    char * networkFile = getStringOption(argc, argv, "--network");
+    if(networkFile) {
+        if(!openNetwork(networkFile)) {
+            printf("Failed to open network %s.\n", networkFile);
+            return 1;
+        }
+        fprintf(stderr, "Evaluating with network %s (%s).\n", networkFile, getNetworkInstructionSet());
+    }
+    else {
+        openNetwork(NETWORK_DEFAULT_FILE);
+    }
+
+    if(argc >= 2 && !strncmp(argv[1], "--", 2)) {
+        // Read a PGN file, optionally writing the games back out.
+        if(!strcmp(argv[1], "--read-pgn") && (argc == 3 || argc == 4)) {
+            return runPgnStats(argv[2], argc == 4 ? argv[3] : NULL) ? 0 : 1;
+        }
+
+        // Analyze every position of an EPD file.
+        if(!strcmp(argv[1], "--analyze") && argc >= 3) {
+            int depth = getIntOption(argc, argv, "--depth", 8);
+            int threads = getIntOption(argc, argv, "--threads", getCoreCount());
+            int hash = getIntOption(argc, argv, "--hash", 16);
+            int multiPV = getIntOption(argc, argv, "--multipv", 1);
+            if(depth < 1 || threads < 1 || hash < 1 || multiPV < 1 || multiPV > MULTIPV_MAX) {
+                printUsage();
+                return 1;
+            }
+            return runEpdAnalysis(argv[2], depth, threads, hash, multiPV) ? 0 : 1;
+        }
+
+        // Engine versus engine match.
+        if(!strcmp(argv[1], "--match")) {
+            return runMatchCommand(argc, argv);
+        }
+
+        // Build an opening book from a PGN file.
+        if(!strcmp(argv[1], "--build-book") && argc >= 4) {
+            int plies = getIntOption(argc, argv, "--plies", 20);
+            int minGames = getIntOption(argc, argv, "--min-games", 2);
+            if(plies < 1 || minGames < 1) {
+                printUsage();
+                return 1;
+            }
+            return buildBook(argv[2], argv[3], plies, minGames) ? 0 : 1;
+        }
+
+        // Generate endgame tablebases, 4 pieces by default.
+        if(!strcmp(argv[1], "--build-tablebases")) {
+            int pieces = (argc >= 3 && strncmp(argv[2], "--", 2)) ? atoi(argv[2]) : 4;
+            int threads = getIntOption(argc, argv, "--threads", getCoreCount());
+            if(threads < 1) {
+                printUsage();
+                return 1;
+            }
+            return buildTablebases(TABLEBASE_DIRECTORY, pieces, threads) ? 0 : 1;
+        }
+
+        // Check the legality of every position of an EPD / FEN file.
+        if(!strcmp(argv[1], "--validate") && argc >= 3) {
+            int threads = getIntOption(argc, argv, "--threads", getCoreCount());
+            int illegalOnly = 0;
+            for(int i = 3; i < argc; i++) {
+                illegalOnly |= !strcmp(argv[i], "--illegal-only");
+            }
+            if(threads < 1) {
+                printUsage();
+                return 1;
+            }
+            return runValidation(argv[2], threads, illegalOnly) ? 0 : 1;
+        }
+
+        // Random legal positions for scenarios, benchmarks and move generation testing.
+        if(!strcmp(argv[1], "--generate") && argc >= 3) {
+            return runGenerateCommand(argc, argv);
+        }
+
+        // Find forced mates in scenario files.
+        if(!strcmp(argv[1], "--solve-mate") && argc >= 3) {
+            int moves = getIntOption(argc, argv, "--moves", MATE_DEFAULT_MOVES);
+            int threads = getIntOption(argc, argv, "--threads", getCoreCount());
+            int hash = getIntOption(argc, argv, "--hash", 16);
+            char * nodes = getStringOption(argc, argv, "--nodes");
+            int checksOnly = 0;
+            for(int i = 3; i < argc; i++) {
+                checksOnly |= !strcmp(argv[i], "--checks-only");
+            }
+            if(moves < 1 || moves > MATE_MAX_MOVES || threads < 1 || hash < 1) {
+                printUsage();
+                return 1;
+            }
+            return runMateSolver(argv[2], moves, threads, hash, checksOnly, nodes ? atol(nodes) : 0) ? 0 : 1;
+        }
+
+        // Move generator test against published counts.
+        if(!strcmp(argv[1], "--perft")) {
+            return runPerftCommand(argc, argv);
+        }
+
+        // Write the starting network for training, it only counts material.
+        if(!strcmp(argv[1], "--write-network") && argc == 3) {
+            return writeMaterialNetwork(argv[2]) ? 0 : 1;
+        }
+
+        // Host games for clients over a socket.
+        if(!strcmp(argv[1], "--server") && argc >= 3) {
+            int maxGames = getIntOption(argc, argv, "--max-games", SERVER_DEFAULT_SESSIONS);
+            if(maxGames < 1) {
+                printUsage();
+                return 1;
+            }
+            return runServer(argv[2], maxGames) ? 0 : 1;
+        }
+
+        // Talk to a server from the terminal or a script.
+        if(!strcmp(argv[1], "--client") && argc == 3) {
+            return runClient(argv[2]) ? 0 : 1;
+        }
+
+        printUsage();
+        return 1;
+    }
+
     if(argc == 2) {
         int showWelcome = 1;
         showWelcome = atoi(argv[1]);
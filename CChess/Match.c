@@ -0,0 +1,493 @@
+/*
+File:           Match.c
+Author:         Toni Lindeman
+Description:    Engine versus engine matches for measuring strength changes.
+
+Games are played concurrently, one game per thread. Every opening is played twice with colors swapped. Moves
+chosen by the engines go through refereeMove, and a game ends when the player in turn has no legal moves, with
+checkmate or stalemate depending on whether the king is checked, the same as in playGame. If the referee and the
+engine disagree, the game is counted and reported.
+
+Results are reported from engine A's point of view as an Elo difference with a 95% error margin. When SPRT
+bounds are given, the match stops as soon as the sequential probability ratio test accepts either hypothesis.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include "OSSpecific.h"
+#include "ChessPiece.h"
+#include "Chessboard.h"
+#include "Gameplay.h"
+#include "MoveGen.h"
+#include "Notation.h"
+#include "Evaluate.h"
+#include "Search.h"
+#include "Log.h"
+#include "Match.h"
+
+// Print match status every this many games.
+#define MATCH_REPORT_INTERVAL 10
+// A side this much material ahead for this many plies in a row wins.
+#define ADJUDICATE_MATERIAL 900
+#define ADJUDICATE_PLIES 8
+// At the move limit, a side this much ahead wins, else the game is drawn.
+#define MOVE_LIMIT_MATERIAL 300
+// SPRT error probabilities
+#define SPRT_ALPHA 0.05
+#define SPRT_BETA 0.05
+
+// Ways a game can end.
+#define GAME_END_CHECKMATE 0
+#define GAME_END_STALEMATE 1
+#define GAME_END_MOVE_LIMIT 2
+#define GAME_END_MATERIAL 3
+#define GAME_END_TIME 4
+#define GAME_END_ILLEGAL_MOVE 5
+#define GAME_END_NO_MOVE 6
+#define GAME_END_REPETITION 7
+#define GAME_END_FIFTY_MOVES 8
+#define GAME_END_INSUFFICIENT_MATERIAL 9
+#define GAME_END_COUNT 10
+
+static const char * gameEndNames[GAME_END_COUNT] = {
+    "checkmate", "stalemate", "move limit", "material", "time forfeit",
+    "illegal move (referee rejected engine move)", "no move from engine", "threefold repetition",
+    "fifty move rule", "insufficient material"
+};
+
+struct matchState {
+    const struct matchSettings * settings;
+    struct position * openings;
+    int openingCount;
+
+    pthread_mutex_t lock;
+    int nextGame;
+    int finishedGames;
+    // From engine A's point of view.
+    int wins;
+    int draws;
+    int losses;
+    int gameEnds[GAME_END_COUNT];
+    int stop;
+    double startTime;
+    // Pawn hash table use of all search states.
+    long pawnProbes;
+    long pawnHits;
+};
+
+// STATISTICS ----------------------------------------------------------------------------------------------------------
+static double expectedScore(double elo) {
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+static double scoreToElo(double score) {
+    // Clamp so a perfect score gives a large but finite number.
+    if(score < 0.001) {
+        score = 0.001;
+    }
+    if(score > 0.999) {
+        score = 0.999;
+    }
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static double scoreVariance(int wins, int draws, int losses, double score) {
+    // Variance of a single game's score.
+    int games = wins + draws + losses;
+    return (wins * pow(1.0 - score, 2) + draws * pow(0.5 - score, 2) + losses * pow(score, 2)) / games;
+}
+
+static double sprtLogLikelihoodRatio(int wins, int draws, int losses, double elo0, double elo1) {
+    // Normal approximation of the log-likelihood ratio of H1 (elo1) against H0 (elo0).
+    int games = wins + draws + losses;
+    if(games == 0) {
+        return 0;
+    }
+    double score = (wins + draws / 2.0) / games;
+    double variance = scoreVariance(wins, draws, losses, score);
+    if(variance <= 0) {
+        return 0;
+    }
+    double score0 = expectedScore(elo0);
+    double score1 = expectedScore(elo1);
+    return (score1 - score0) * (2 * games * score - games * (score0 + score1)) / (2 * variance);
+}
+
+static void printMatchStatus(struct matchState * match) {
+    int games = match->wins + match->draws + match->losses;
+    if(games == 0) {
+        return;
+    }
+
+    double score = (match->wins + match->draws / 2.0) / games;
+    double margin = 1.96 * sqrt(scoreVariance(match->wins, match->draws, match->losses, score) / games);
+    double elo = scoreToElo(score);
+    double errorBar = (scoreToElo(score + margin) - scoreToElo(score - margin)) / 2;
+
+    printf("Games %d: +%d =%d -%d, score %.1f%%, Elo %+.1f +/- %.1f", games, match->wins, match->draws,
+           match->losses, 100 * score, elo, errorBar);
+
+    if(match->settings->elo0 != match->settings->elo1) {
+        printf(", LLR %.2f [%.2f, %.2f]",
+               sprtLogLikelihoodRatio(match->wins, match->draws, match->losses, match->settings->elo0,
+                                      match->settings->elo1),
+               log(SPRT_BETA / (1 - SPRT_ALPHA)), log((1 - SPRT_BETA) / SPRT_ALPHA));
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+// GAMES ---------------------------------------------------------------------------------------------------------------
+static int materialBalance(const struct position * pos) {
+    // Player 1 material minus player 2 material.
+    int balance = 0;
+    for(int rank = 1; rank <= 6; rank++) {
+        balance += (pos->pieceCounts[1][rank] - pos->pieceCounts[2][rank]) * pieceValues[rank];
+    }
+    return balance;
+}
+
+static int playMatchGame(struct matchState * match, struct searchState * states[2], int gameIndex,
+                         int * outGameEnd) {
+    // Play one game. Returns 1 if engine A won, 0 for a draw and -1 if engine B won.
+    const struct matchSettings * settings = match->settings;
+
+    struct position pos = match->openings[(gameIndex / 2) % match->openingCount];
+    // Engine A plays player 1 in even games.
+    int engineOfPlayer[3] = {0, gameIndex % 2, 1 - (gameIndex % 2)};
+
+    // The referee's boards
+    struct chessPiece * chessboard = getEmptyChessboard();
+    struct chessPiece * chessboardPrevious = getEmptyChessboard();
+    if(!chessboard || !chessboardPrevious) {
+        freeChessboardMemory(chessboard);
+        freeChessboardMemory(chessboardPrevious);
+        *outGameEnd = GAME_END_MOVE_LIMIT;
+        return 0;
+    }
+    copyChessboard(pos.board, chessboard);
+    copyChessboard(pos.board, chessboardPrevious);
+
+    double clocks[3] = {0, settings->baseSeconds, settings->baseSeconds};
+    int winningPlies[3] = {0, 0, 0};
+    struct positionHistory history;
+    clearPositionHistory(&history);
+    // Both games of an opening pair follow the same book line.
+    uint64_t bookRandom = (uint64_t)(gameIndex / 2);
+    // Winner as a player number, 0 for a draw.
+    int winner = 0;
+
+    for(int ply = 0; ; ply++) {
+        int player = pos.turn;
+        int opponent = (player % 2) + 1;
+        const struct matchEngine * engine = &settings->engines[engineOfPlayer[player]];
+        setLogContext(gameIndex + 1, (ply / 2) + 1);
+
+        // No legal moves ends the game, exactly as in playGame.
+        struct moveList legalMoves;
+        generateLegalMoves(&pos, &legalMoves);
+        if(legalMoves.count == 0) {
+            if(isPlayerInCheck(&pos, player)) {
+                winner = opponent;
+                *outGameEnd = GAME_END_CHECKMATE;
+            }
+            else {
+                *outGameEnd = GAME_END_STALEMATE;
+            }
+            break;
+        }
+        int draw = getDrawReason(&history, &pos);
+        if(draw != DRAW_NONE) {
+            *outGameEnd = (draw == DRAW_REPETITION) ? GAME_END_REPETITION :
+                          (draw == DRAW_FIFTY_MOVES) ? GAME_END_FIFTY_MOVES : GAME_END_INSUFFICIENT_MATERIAL;
+            break;
+        }
+        if(ply >= settings->maxPlies) {
+            int balance = materialBalance(&pos);
+            winner = (balance >= MOVE_LIMIT_MATERIAL) ? 1 : (balance <= -MOVE_LIMIT_MATERIAL) ? 2 : 0;
+            *outGameEnd = GAME_END_MOVE_LIMIT;
+            break;
+        }
+
+        struct searchLimits limits = {engine->depth, 0, engine->nodes, 1};
+        if(settings->baseSeconds > 0) {
+            // Spend a fair share of the clock, never most of it.
+            limits.timeSeconds = clocks[player] / 30 + settings->incrementSeconds * 0.75;
+            if(limits.timeSeconds > clocks[player] * 0.5) {
+                limits.timeSeconds = clocks[player] * 0.5;
+            }
+        }
+
+        // Book moves are free, the search and the clock are skipped.
+        struct searchResult result;
+        result.bestMove = engine->book ? probeBook(engine->book, &pos, &bookRandom) : MOVE_NONE;
+        result.seconds = 0;
+        if(result.bestMove == MOVE_NONE) {
+            setSearchHistory(states[engineOfPlayer[player]], &history);
+            searchPosition(states[engineOfPlayer[player]], &pos, &limits, &result);
+        }
+
+        if(settings->baseSeconds > 0) {
+            clocks[player] -= result.seconds;
+            if(clocks[player] < 0) {
+                winner = opponent;
+                *outGameEnd = GAME_END_TIME;
+                break;
+            }
+            clocks[player] += settings->incrementSeconds;
+        }
+
+        // The engine found no move although the player has legal moves.
+        if(result.bestMove == MOVE_NONE) {
+            winner = opponent;
+            *outGameEnd = GAME_END_NO_MOVE;
+            break;
+        }
+
+        int from = MOVE_FROM(result.bestMove);
+        int to = MOVE_TO(result.bestMove);
+        uint64_t keyBefore = pos.key;
+        if(refereeMove(&pos, chessboard, chessboardPrevious, SQUARE_ROW(from), SQUARE_COLUMN(from), SQUARE_ROW(to),
+                       SQUARE_COLUMN(to), MOVE_PROMOTION(result.bestMove), NULL) != 1) {
+            winner = opponent;
+            *outGameEnd = GAME_END_ILLEGAL_MOVE;
+            break;
+        }
+        pushPositionHistory(&history, keyBefore);
+
+        // Material adjudication
+        int balance = materialBalance(&pos);
+        winningPlies[1] = (balance >= ADJUDICATE_MATERIAL) ? winningPlies[1] + 1 : 0;
+        winningPlies[2] = (balance <= -ADJUDICATE_MATERIAL) ? winningPlies[2] + 1 : 0;
+        if(winningPlies[1] >= ADJUDICATE_PLIES || winningPlies[2] >= ADJUDICATE_PLIES) {
+            winner = (winningPlies[1] >= ADJUDICATE_PLIES) ? 1 : 2;
+            *outGameEnd = GAME_END_MATERIAL;
+            break;
+        }
+    }
+
+    freeChessboardMemory(chessboard);
+    freeChessboardMemory(chessboardPrevious);
+
+    if(winner == 0) {
+        return 0;
+    }
+    return (engineOfPlayer[winner] == 0) ? 1 : -1;
+}
+
+static void * matchWorker(void * argument) {
+    struct matchState * match = (struct matchState *) argument;
+    const struct matchSettings * settings = match->settings;
+
+    // One search state per engine, so engines never share a transposition table.
+    struct searchState * states[2] = {NULL, NULL};
+    for(int i = 0; i < 2; i++) {
+        states[i] = (struct searchState *) malloc(sizeof(struct searchState));
+        if(!states[i] || !initSearchState(states[i], (size_t)settings->engines[i].hashMegabytes)) {
+            fprintf(stderr, "Match worker failed to allocate search state.\n");
+            free(states[i]);
+            states[i] = NULL;
+        }
+    }
+
+    while(states[0] && states[1]) {
+        pthread_mutex_lock(&match->lock);
+        if(match->stop || match->nextGame >= settings->games) {
+            pthread_mutex_unlock(&match->lock);
+            break;
+        }
+        int gameIndex = match->nextGame++;
+        pthread_mutex_unlock(&match->lock);
+
+        clearTranspositionTable(&states[0]->table);
+        clearTranspositionTable(&states[1]->table);
+
+        int gameEnd = GAME_END_MOVE_LIMIT;
+        int result = playMatchGame(match, states, gameIndex, &gameEnd);
+
+        pthread_mutex_lock(&match->lock);
+        if(result == 1) {
+            match->wins++;
+        }
+        else if(result == -1) {
+            match->losses++;
+        }
+        else {
+            match->draws++;
+        }
+        match->gameEnds[gameEnd]++;
+        match->finishedGames++;
+
+        if(match->finishedGames % MATCH_REPORT_INTERVAL == 0) {
+            printMatchStatus(match);
+        }
+
+        // Sequential probability ratio test
+        if(settings->elo0 != settings->elo1 && !match->stop) {
+            double llr = sprtLogLikelihoodRatio(match->wins, match->draws, match->losses, settings->elo0,
+                                                settings->elo1);
+            if(llr >= log((1 - SPRT_BETA) / SPRT_ALPHA)) {
+                printf("SPRT: H1 accepted, %s is at least %.1f Elo stronger.\n", settings->engines[0].name,
+                       settings->elo1);
+                match->stop = 1;
+            }
+            else if(llr <= log(SPRT_BETA / (1 - SPRT_ALPHA))) {
+                printf("SPRT: H0 accepted, %s is not %.1f Elo stronger.\n", settings->engines[0].name,
+                       settings->elo1);
+                match->stop = 1;
+            }
+        }
+        pthread_mutex_unlock(&match->lock);
+    }
+
+    pthread_mutex_lock(&match->lock);
+    for(int i = 0; i < 2; i++) {
+        if(states[i]) {
+            match->pawnProbes += states[i]->pawnTable.probes;
+            match->pawnHits += states[i]->pawnTable.hits;
+        }
+    }
+    pthread_mutex_unlock(&match->lock);
+
+    for(int i = 0; i < 2; i++) {
+        if(states[i]) {
+            freeSearchState(states[i]);
+            free(states[i]);
+        }
+    }
+    return NULL;
+}
+
+// OPENINGS ------------------------------------------------------------------------------------------------------------
+static int loadOpenings(struct matchState * match, const char * fileName) {
+    // One FEN / EPD position per line. Without a file, every game starts from the standard setup.
+    match->openingCount = 0;
+    match->openings = NULL;
+
+    if(!fileName) {
+        match->openings = (struct position *) malloc(sizeof(struct position));
+        if(!match->openings) {
+            return 0;
+        }
+        setInitialPosition(&match->openings[0]);
+        match->openingCount = 1;
+        return 1;
+    }
+
+    size_t size = 0;
+    const char * data = mapFile(fileName, &size);
+    if(!data) {
+        printf("Failed to open openings file %s.\n", fileName);
+        return 0;
+    }
+
+    int capacity = 0;
+    size_t offset = 0;
+    while(offset < size) {
+        // Copy the line, FEN parser wants a null terminated string.
+        char line[FEN_MAX_LENGTH * 2];
+        size_t length = 0;
+        while(offset < size && data[offset] != '\n') {
+            if(length < sizeof(line) - 1) {
+                line[length++] = data[offset];
+            }
+            offset++;
+        }
+        offset++;
+        line[length] = '\0';
+
+        if(length == 0 || line[0] == '#') {
+            continue;
+        }
+
+        if(match->openingCount == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            struct position * tempPointer = realloc(match->openings, capacity * sizeof(struct position));
+            if(!tempPointer) {
+                break;
+            }
+            match->openings = tempPointer;
+        }
+        if(setPositionFromFen(&match->openings[match->openingCount], line)) {
+            match->openingCount++;
+        }
+    }
+    unmapFile(data, size);
+
+    if(match->openingCount == 0) {
+        printf("No valid openings in %s.\n", fileName);
+        free(match->openings);
+        match->openings = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+// MATCH ---------------------------------------------------------------------------------------------------------------
+int runMatch(const struct matchSettings * settings) {
+    // Play a match between engines[0] (A) and engines[1] (B). Returns 0 on failure.
+    struct matchState match;
+    match.settings = settings;
+    match.nextGame = 0;
+    match.finishedGames = 0;
+    match.wins = 0;
+    match.draws = 0;
+    match.losses = 0;
+    match.stop = 0;
+    match.pawnProbes = 0;
+    match.pawnHits = 0;
+    for(int i = 0; i < GAME_END_COUNT; i++) {
+        match.gameEnds[i] = 0;
+    }
+
+    if(!loadOpenings(&match, settings->openingsFile)) {
+        return 0;
+    }
+
+    int threadCount = settings->threads;
+    pthread_t * threads = (pthread_t *) malloc(threadCount * sizeof(pthread_t));
+    if(!threads) {
+        free(match.openings);
+        return 0;
+    }
+
+    printf("%s vs %s: %d games from %d openings on %d threads.\n", settings->engines[0].name,
+           settings->engines[1].name, settings->games, match.openingCount, threadCount);
+
+    pthread_mutex_init(&match.lock, NULL);
+    match.startTime = getTimeSeconds();
+
+    for(int i = 0; i < threadCount; i++) {
+        if(pthread_create(&threads[i], NULL, matchWorker, &match) != 0) {
+            fprintf(stderr, "Failed to start match thread %d.\n", i);
+            threadCount = i;
+            break;
+        }
+    }
+    for(int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double seconds = getTimeSeconds() - match.startTime;
+
+    printf("\nFinal result:\n");
+    printMatchStatus(&match);
+    printf("Game ends:\n");
+    for(int i = 0; i < GAME_END_COUNT; i++) {
+        if(match.gameEnds[i]) {
+            printf("  %-45s %d\n", gameEndNames[i], match.gameEnds[i]);
+        }
+    }
+    printf("%d games in %.1f s, %.2f games/second.\n", match.finishedGames, seconds,
+           seconds > 0 ? match.finishedGames / seconds : 0.0);
+    printf("Pawn hash: %ld probes, %.1f%% hits.\n", match.pawnProbes,
+           match.pawnProbes ? 100.0 * match.pawnHits / match.pawnProbes : 0.0);
+
+    pthread_mutex_destroy(&match.lock);
+    free(threads);
+    free(match.openings);
+
+    return 1;
+}
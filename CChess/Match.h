@@ -0,0 +1,39 @@
+/*
+File:           Match.h
+Author:         Toni Lindeman
+Description:    Engine versus engine matches for measuring strength changes.
+*/
+
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "Book.h"
+
+// Search settings for one side of a match. 0 means no limit.
+struct matchEngine {
+    const char * name;
+    int depth;
+    long nodes;
+    int hashMegabytes;
+    // Probed before searching, NULL for no book.
+    const struct openingBook * book;
+};
+
+struct matchSettings {
+    const char * openingsFile;
+    int games;
+    int threads;
+    // Time control per game, base + increment per move. 0 base means no clock.
+    double baseSeconds;
+    double incrementSeconds;
+    // Games reaching this many plies are adjudicated by material.
+    int maxPlies;
+    // SPRT hypotheses in Elo, SPRT is off when they are equal.
+    double elo0;
+    double elo1;
+    struct matchEngine engines[2];
+};
+
+int runMatch(const struct matchSettings * settings);
+
+#endif /* MATCH_H */
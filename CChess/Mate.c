@@ -0,0 +1,543 @@
+/*
+File:           Mate.c
+Author:         Toni Lindeman
+Description:    Forced mate solver for scenario files and mating puzzles.
+
+A depth-first AND/OR search: the attacker needs one move after which every defence still loses, the defender
+needs one move that escapes. Unlike the normal search there is no evaluation and no pruning by score, so a
+result is a proof: either a forced mate in N moves or no mate in N moves exists.
+
+The limit is raised one move at a time, so the first mate found is the shortest. Attacker positions are stored
+in a transposition table, as "mate in at most N" (TT_EXACT, score N) or "no mate in N" (TT_UPPER, depth N), so
+every iteration reuses the proofs of the previous ones. The attacker's last move must give check, so only
+checking moves are tried there, and checking moves are always tried first.
+
+A directory of scenario files is solved on all cores, one file per thread at a time, printed as JSON lines in
+file name order.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "OSSpecific.h"
+#include "ChessPiece.h"
+#include "Chessboard.h"
+#include "MoveGen.h"
+#include "Notation.h"
+#include "Validate.h"
+#include "Mate.h"
+
+#define MATE_RESULT_LENGTH 1024
+#define MATE_FILE_NAME_LENGTH 512
+
+struct mateBatch {
+    pthread_mutex_t lock;
+    pthread_cond_t resultReady;
+
+    char (* fileNames)[MATE_FILE_NAME_LENGTH];
+    int fileCount;
+    int nextFile;
+
+    char (* results)[MATE_RESULT_LENGTH];
+    int * ready;
+    int runningWorkers;
+
+    int maxMoves;
+    int hashMegabytes;
+    int checksOnly;
+    long nodeLimit;
+    long mates;
+};
+
+int initMateSolver(struct mateSolver * solver, size_t hashMegabytes) {
+    // Returns 0 if out of memory.
+    solver->nodes = 0;
+    solver->nodeLimit = 0;
+    solver->aborted = 0;
+    solver->checksOnly = 0;
+    return initTranspositionTable(&solver->table, hashMegabytes);
+}
+
+void freeMateSolver(struct mateSolver * solver) {
+    freeTranspositionTable(&solver->table);
+}
+
+// SEARCH --------------------------------------------------------------------------------------------------------------
+static int defenderLoses(struct mateSolver * solver, struct position * pos, int moves);
+
+static int attackerWins(struct mateSolver * solver, struct position * pos, int moves, int * outMove) {
+    // Can the player in turn mate in at most moves moves? outMove gets the mating move.
+    struct ttEntry entry;
+    int hashMove = MOVE_NONE;
+
+    solver->nodes++;
+    if(solver->nodeLimit && solver->nodes > solver->nodeLimit) {
+        solver->aborted = 1;
+    }
+    if(solver->aborted) {
+        return 0;
+    }
+
+    if(probeTransposition(&solver->table, pos->key, &entry)) {
+        if(entry.flag == TT_EXACT && entry.score <= moves) {
+            *outMove = entry.move;
+            return 1;
+        }
+        if(entry.flag == TT_UPPER && entry.depth >= moves) {
+            return 0;
+        }
+        hashMove = entry.move;
+    }
+
+    struct moveList list;
+    generateLegalMoves(pos, &list);
+    int defender = (pos->turn % 2) + 1;
+
+    // Pass 0: the hash move, 1: checks, 2: other moves, unless this is the last move or only checks are allowed.
+    int lastPass = (moves > 1 && !solver->checksOnly) ? 2 : 1;
+    for(int pass = 0; pass <= lastPass; pass++) {
+        for(int i = 0; i < list.count; i++) {
+            int move = list.moves[i];
+            if((pass == 0) != (move == hashMove)) {
+                continue;
+            }
+
+            struct undoRecord undo;
+            makeMove(pos, move, &undo);
+            int givesCheck = isPlayerInCheck(pos, defender);
+            int wins = 0;
+            if((pass == 0 && (givesCheck || lastPass == 2)) || (pass == 1 && givesCheck) || (pass == 2 && !givesCheck)) {
+                wins = defenderLoses(solver, pos, moves);
+            }
+            unmakeMove(pos, move, &undo);
+
+            if(wins) {
+                storeTransposition(&solver->table, pos->key, move, moves, moves, TT_EXACT);
+                *outMove = move;
+                return 1;
+            }
+            if(solver->aborted) {
+                return 0;
+            }
+        }
+    }
+
+    storeTransposition(&solver->table, pos->key, hashMove, 0, moves, TT_UPPER);
+    return 0;
+}
+
+static int defenderLoses(struct mateSolver * solver, struct position * pos, int moves) {
+    // Attacker has just moved with moves moves, this one included. Is every defence mated within them?
+    struct moveList list;
+    int move = MOVE_NONE;
+
+    solver->nodes++;
+    generateLegalMoves(pos, &list);
+    if(list.count == 0) {
+        // Mate, or stalemate which is no win.
+        return isPlayerInCheck(pos, pos->turn);
+    }
+    if(moves == 1) {
+        return 0;
+    }
+
+    for(int i = 0; i < list.count; i++) {
+        struct undoRecord undo;
+        makeMove(pos, list.moves[i], &undo);
+        int wins = attackerWins(solver, pos, moves - 1, &move);
+        unmakeMove(pos, list.moves[i], &undo);
+        if(!wins) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int shortestMate(struct mateSolver * solver, struct position * pos, int maxMoves, int * outMove) {
+    // Smallest number of moves the player in turn mates in, 0 if not within maxMoves.
+    for(int moves = 1; moves <= maxMoves && !solver->aborted; moves++) {
+        if(attackerWins(solver, pos, moves, outMove)) {
+            return moves;
+        }
+    }
+    return 0;
+}
+
+static void buildMateLine(struct mateSolver * solver, struct position * pos, int mateIn, struct mateResult * result) {
+    // Follow the mate, the defender always picking the reply that lasts longest.
+    struct position line = *pos;
+    int moves = mateIn;
+
+    result->pvLength = 0;
+    while(moves > 0 && !solver->aborted) {
+        int move = MOVE_NONE;
+        struct undoRecord undo;
+        if(!attackerWins(solver, &line, moves, &move) || move == MOVE_NONE) {
+            break;
+        }
+        makeMove(&line, move, &undo);
+        result->pv[result->pvLength++] = move;
+
+        struct moveList replies;
+        generateLegalMoves(&line, &replies);
+        int longestReply = MOVE_NONE;
+        int longest = 0;
+        for(int i = 0; i < replies.count; i++) {
+            int reply = MOVE_NONE;
+            makeMove(&line, replies.moves[i], &undo);
+            int remaining = shortestMate(solver, &line, moves - 1, &reply);
+            unmakeMove(&line, replies.moves[i], &undo);
+            if(remaining > longest) {
+                longest = remaining;
+                longestReply = replies.moves[i];
+            }
+        }
+        if(longestReply == MOVE_NONE) {
+            break;
+        }
+        makeMove(&line, longestReply, &undo);
+        result->pv[result->pvLength++] = longestReply;
+        moves = longest;
+    }
+}
+
+int solveMate(struct mateSolver * solver, struct position * pos, int maxMoves, struct mateResult * outResult) {
+    // Find the shortest forced mate for the player in turn, up to maxMoves (at most MATE_MAX_MOVES).
+    // Returns outResult->mateIn.
+    double startTime = getTimeSeconds();
+    int move = MOVE_NONE;
+
+    if(maxMoves > MATE_MAX_MOVES) {
+        maxMoves = MATE_MAX_MOVES;
+    }
+    clearTranspositionTable(&solver->table);
+    solver->nodes = 0;
+    solver->aborted = 0;
+
+    outResult->mateIn = shortestMate(solver, pos, maxMoves, &move);
+    outResult->pvLength = 0;
+    if(outResult->mateIn) {
+        buildMateLine(solver, pos, outResult->mateIn, outResult);
+    }
+    if(solver->aborted) {
+        outResult->mateIn = MATE_ABORTED;
+    }
+    outResult->nodes = solver->nodes;
+    outResult->seconds = getTimeSeconds() - startTime;
+    return outResult->mateIn;
+}
+
+// OUTPUT --------------------------------------------------------------------------------------------------------------
+static int writeMateLine(const struct position * pos, const struct mateResult * result, int json, char * out) {
+    // The mating line in SAN, "1. Qh7+ Kf8 2. Qh8#" or a JSON array. Returns the length written.
+    struct position line = *pos;
+    int length = 0;
+
+    if(json) {
+        out[length++] = '[';
+    }
+    for(int i = 0; i < result->pvLength; i++) {
+        char san[SAN_MAX_LENGTH];
+        struct undoRecord undo;
+        moveToSan(&line, result->pv[i], san);
+        makeMove(&line, result->pv[i], &undo);
+
+        if(json) {
+            length += sprintf(out + length, "%s\"%s\"", i ? "," : "", san);
+        }
+        else if(i % 2 == 0) {
+            length += sprintf(out + length, "%s%d. %s", i ? " " : "", i / 2 + 1, san);
+        }
+        else {
+            length += sprintf(out + length, " %s", san);
+        }
+    }
+    if(json) {
+        out[length++] = ']';
+    }
+    out[length] = '\0';
+    return length;
+}
+
+static int loadMatePosition(const char * fileName, struct position * outPos) {
+    // Load a scenario / game state file. Returns 0 if it can't be loaded, -1 if the position is illegal.
+    struct chessPiece * chessboard = getEmptyChessboard();
+    int turn = 1;
+    int success = chessboard && loadGameStateFile(chessboard, &turn, fileName) && (turn == 1 || turn == 2);
+
+    if(success) {
+        setPositionFromChessboard(outPos, chessboard, turn);
+        if(validatePosition(outPos)) {
+            success = -1;
+        }
+    }
+    freeChessboardMemory(chessboard);
+    return success;
+}
+
+static int solveMateFile(struct mateSolver * solver, const char * fileName, int maxMoves, char * outResult) {
+    // Solve one file and write the result as a JSON object. Returns the moves to mate, 0 if none was found.
+    struct position pos;
+    struct mateResult result;
+    int length = sprintf(outResult, "{\"file\":\"");
+
+    for(int i = 0; fileName[i] != '\0' && length < MATE_FILE_NAME_LENGTH; i++) {
+        if(fileName[i] == '"' || fileName[i] == '\\') {
+            outResult[length++] = '\\';
+        }
+        outResult[length++] = fileName[i];
+    }
+    length += sprintf(outResult + length, "\"");
+
+    int loaded = loadMatePosition(fileName, &pos);
+    if(loaded != 1) {
+        sprintf(outResult + length, ",\"error\":\"%s\"}", loaded ? "illegal position" : "failed to load");
+        return 0;
+    }
+
+    char fen[FEN_MAX_LENGTH];
+    writeFen(&pos, fen);
+    length += sprintf(outResult + length, ",\"fen\":\"%s\"", fen);
+
+    solveMate(solver, &pos, maxMoves, &result);
+    if(result.mateIn > 0) {
+        length += sprintf(outResult + length, ",\"mate\":%d,\"pv\":", result.mateIn);
+        length += writeMateLine(&pos, &result, 1, outResult + length);
+    }
+    else {
+        length += sprintf(outResult + length, ",\"mate\":null,\"status\":\"%s\"",
+                          result.mateIn == MATE_ABORTED ? "aborted" : "no mate");
+    }
+    sprintf(outResult + length, ",\"nodes\":%ld,\"seconds\":%.3f}", result.nodes, result.seconds);
+    return (result.mateIn > 0) ? result.mateIn : 0;
+}
+
+// BATCH MODE ----------------------------------------------------------------------------------------------------------
+static int compareFileNames(const void * a, const void * b) {
+    return strcmp((const char *) a, (const char *) b);
+}
+
+static int listScenarioFiles(const char * directory, char (** outNames)[MATE_FILE_NAME_LENGTH]) {
+    // Paths of the .scn and .gst files in a directory, sorted. Returns the count, -1 on failure.
+    DIR * dir = opendir(directory);
+    if(!dir) {
+        return -1;
+    }
+
+    int count = 0;
+    int capacity = 0;
+    char (* names)[MATE_FILE_NAME_LENGTH] = NULL;
+    struct dirent * entry;
+    while((entry = readdir(dir))) {
+        size_t length = strlen(entry->d_name);
+        if(length < 5 || (strcmp(entry->d_name + length - 4, ".scn") && strcmp(entry->d_name + length - 4, ".gst"))) {
+            continue;
+        }
+        if(count == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            char (* grown)[MATE_FILE_NAME_LENGTH] = realloc(names, capacity * sizeof(*names));
+            if(!grown) {
+                free(names);
+                closedir(dir);
+                return -1;
+            }
+            names = grown;
+        }
+        snprintf(names[count++], MATE_FILE_NAME_LENGTH, "%s/%s", directory, entry->d_name);
+    }
+    closedir(dir);
+
+    qsort(names, count, sizeof(*names), compareFileNames);
+    *outNames = names;
+    return count;
+}
+
+static void * mateWorker(void * argument) {
+    struct mateBatch * batch = (struct mateBatch *) argument;
+
+    struct mateSolver solver;
+    int hasSolver = initMateSolver(&solver, (size_t)batch->hashMegabytes);
+    if(!hasSolver) {
+        fprintf(stderr, "Mate solver thread failed to allocate its hash table.\n");
+    }
+    solver.checksOnly = batch->checksOnly;
+    solver.nodeLimit = batch->nodeLimit;
+
+    while(hasSolver) {
+        pthread_mutex_lock(&batch->lock);
+        int index = (batch->nextFile < batch->fileCount) ? batch->nextFile++ : -1;
+        pthread_mutex_unlock(&batch->lock);
+        if(index == -1) {
+            break;
+        }
+
+        char result[MATE_RESULT_LENGTH];
+        int mateIn = solveMateFile(&solver, batch->fileNames[index], batch->maxMoves, result);
+
+        pthread_mutex_lock(&batch->lock);
+        strcpy(batch->results[index], result);
+        batch->ready[index] = 1;
+        batch->mates += mateIn > 0;
+        pthread_cond_signal(&batch->resultReady);
+        pthread_mutex_unlock(&batch->lock);
+    }
+
+    if(hasSolver) {
+        freeMateSolver(&solver);
+    }
+
+    pthread_mutex_lock(&batch->lock);
+    batch->runningWorkers--;
+    pthread_cond_signal(&batch->resultReady);
+    pthread_mutex_unlock(&batch->lock);
+    return NULL;
+}
+
+static int runMateBatch(struct mateBatch * batch, int threadCount) {
+    // Solve every file of the batch, printing results in order as they are ready. Returns 0 on failure.
+    batch->results = malloc(batch->fileCount * sizeof(*batch->results));
+    batch->ready = (int *) calloc(batch->fileCount, sizeof(int));
+    pthread_t * threads = (pthread_t *) malloc(threadCount * sizeof(pthread_t));
+    if(!batch->results || !batch->ready || !threads) {
+        fprintf(stderr, "Failed to allocate memory for the mate solver.\n");
+        free(batch->results);
+        free(batch->ready);
+        free(threads);
+        return 0;
+    }
+
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->resultReady, NULL);
+    batch->nextFile = 0;
+    batch->mates = 0;
+    batch->runningWorkers = 0;
+    double startTime = getTimeSeconds();
+
+    for(int i = 0; i < threadCount; i++) {
+        if(pthread_create(&threads[i], NULL, mateWorker, batch) == 0) {
+            batch->runningWorkers++;
+        }
+        else {
+            fprintf(stderr, "Failed to start mate solver thread %d.\n", i);
+            threadCount = i;
+            break;
+        }
+    }
+
+    int printed = 0;
+    pthread_mutex_lock(&batch->lock);
+    while(printed < batch->fileCount) {
+        if(batch->ready[printed]) {
+            // Results are never written again, print outside the lock.
+            pthread_mutex_unlock(&batch->lock);
+            printf("%s\n", batch->results[printed]);
+            pthread_mutex_lock(&batch->lock);
+            printed++;
+        }
+        else if(batch->runningWorkers == 0) {
+            break;
+        }
+        else {
+            pthread_cond_wait(&batch->resultReady, &batch->lock);
+        }
+    }
+    pthread_mutex_unlock(&batch->lock);
+
+    for(int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double seconds = getTimeSeconds() - startTime;
+    fflush(stdout);
+    fprintf(stderr, "Solved %d scenarios in %.2f s with %d threads, %ld forced mates within %d moves.\n", printed,
+            seconds, threadCount, batch->mates, batch->maxMoves);
+
+    pthread_cond_destroy(&batch->resultReady);
+    pthread_mutex_destroy(&batch->lock);
+    free(batch->results);
+    free(batch->ready);
+    free(threads);
+    return printed == batch->fileCount;
+}
+
+int runMateSolver(const char * path, int maxMoves, int threadCount, int hashMegabytes, int checksOnly, long nodeLimit) {
+    // path is a scenario slot 1-3 (0 is the saved game), a scenario file or a directory of them. nodeLimit is per
+    // position, 0 for no limit. Returns 0 on failure.
+    struct stat info;
+
+    if(stat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+        struct mateBatch batch;
+        batch.fileCount = listScenarioFiles(path, &batch.fileNames);
+        if(batch.fileCount < 0) {
+            fprintf(stderr, "Failed to read directory %s.\n", path);
+            return 0;
+        }
+        batch.maxMoves = maxMoves;
+        batch.hashMegabytes = hashMegabytes;
+        batch.checksOnly = checksOnly;
+        batch.nodeLimit = nodeLimit;
+        int success = runMateBatch(&batch, threadCount);
+        free(batch.fileNames);
+        return success;
+    }
+
+    struct position pos;
+    struct chessPiece * chessboard = getEmptyChessboard();
+    int turn = 1;
+    int loaded = 0;
+    if(chessboard && strlen(path) == 1 && path[0] >= '0' && path[0] <= '3') {
+        loaded = loadGameState(chessboard, &turn, path[0] - '0') && (turn == 1 || turn == 2);
+    }
+    else if(chessboard) {
+        loaded = loadGameStateFile(chessboard, &turn, path) && (turn == 1 || turn == 2);
+    }
+    if(loaded) {
+        setPositionFromChessboard(&pos, chessboard, turn);
+        printChessboard(chessboard);
+    }
+    freeChessboardMemory(chessboard);
+
+    if(!loaded) {
+        printf("Failed to load scenario %s.\n", path);
+        return 0;
+    }
+    int reasons = validatePosition(&pos);
+    if(reasons) {
+        printf("Scenario %s is not a legal position:\n", path);
+        for(int reason = 1; reason < (1 << INVALID_REASON_COUNT); reason <<= 1) {
+            if(reasons & reason) {
+                printf("  %s\n", getInvalidReasonText(reason));
+            }
+        }
+        return 0;
+    }
+
+    struct mateSolver solver;
+    struct mateResult result;
+    if(!initMateSolver(&solver, (size_t)hashMegabytes)) {
+        printf("Failed to allocate memory for the mate solver.\n");
+        return 0;
+    }
+    solver.checksOnly = checksOnly;
+    solver.nodeLimit = nodeLimit;
+    solveMate(&solver, &pos, maxMoves, &result);
+    freeMateSolver(&solver);
+
+    if(result.mateIn > 0) {
+        char line[MATE_RESULT_LENGTH];
+        writeMateLine(&pos, &result, 0, line);
+        printf("Player %d mates in %d: %s\n", pos.turn, result.mateIn, line);
+    }
+    else if(result.mateIn == MATE_ABORTED) {
+        printf("Gave up after %ld nodes, no mate found yet.\n", nodeLimit);
+    }
+    else {
+        printf("No forced mate for player %d in %d moves%s.\n", pos.turn, maxMoves,
+               checksOnly ? " with checks only" : "");
+    }
+    printf("%ld nodes in %.2f s.\n", result.nodes, result.seconds);
+    return 1;
+}
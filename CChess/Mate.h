@@ -0,0 +1,47 @@
+/*
+File:           Mate.h
+Author:         Toni Lindeman
+Description:    Forced mate solver for scenario files and mating puzzles.
+*/
+
+#ifndef MATE_H
+#define MATE_H
+
+#include <stddef.h>
+#include "Position.h"
+#include "Transposition.h"
+
+#define MATE_MAX_MOVES 32
+#define MATE_DEFAULT_MOVES 5
+
+// mateIn values when no mate was found.
+#define MATE_NOT_FOUND 0
+#define MATE_ABORTED -1
+
+struct mateSolver {
+    struct transpositionTable table;
+    long nodes;
+    // 0 means no limit. The search gives up with MATE_ABORTED when it is reached.
+    long nodeLimit;
+    int aborted;
+    // Only try checking moves for the attacker, like in "checks only" puzzles. The last move always has to be a
+    // check anyway.
+    int checksOnly;
+};
+
+struct mateResult {
+    // Shortest forced mate in moves, or MATE_NOT_FOUND / MATE_ABORTED.
+    int mateIn;
+    // Attacker's moves and the longest defence, ending in mate.
+    int pv[2 * MATE_MAX_MOVES];
+    int pvLength;
+    long nodes;
+    double seconds;
+};
+
+int initMateSolver(struct mateSolver * solver, size_t hashMegabytes);
+void freeMateSolver(struct mateSolver * solver);
+int solveMate(struct mateSolver * solver, struct position * pos, int maxMoves, struct mateResult * outResult);
+int runMateSolver(const char * path, int maxMoves, int threadCount, int hashMegabytes, int checksOnly, long nodeLimit);
+
+#endif /* MATE_H */
@@ -1,15 +1,15 @@
-/*
-File         Menu.h
-Author       Toni Lindeman
-Description  Functionality for the menu.
-*/
-
-#ifndef MENU_H
-#define MENU_H
-
-int menu();
-int scenarioMenu();
-int saveScenarioMenu();
-void printInfo(char * whichInfo);
-
-#endif /* MENU_H */
+/*
+File         Menu.h
+Author       Toni Lindeman
+Description  Functionality for the menu.
+*/
+
+#ifndef MENU_H
+#define MENU_H
+
+int menu();
+int scenarioMenu();
+int saveScenarioMenu();
+void printInfo(char * whichInfo);
+
+#endif /* MENU_H */
@@ -0,0 +1,290 @@
+/*
+File:           MoveGen.c
+Author:         Toni Lindeman
+Description:    Move generation for positions.
+
+Generated moves follow the full rules of chess: pawns move two steps from their starting row, capture en passant
+and promote to rook, knight, bishop or queen on the last row, and kings castle if the rights remain, the squares
+between king and rook are empty and the king doesn't start from, pass through or land on an attacked square.
+
+perft counts the leaf nodes of the legal move tree. The counts of well known positions are published, so
+comparing against them tests the generator (and make / unmake) on every rule at once.
+*/
+
+#include "MoveGen.h"
+
+static const int knightJumps[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+static const int kingSteps[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+static void addMove(struct moveList * list, int from, int to) {
+    list->moves[list->count++] = MOVE_ENCODE(from, to, 0);
+}
+
+static void addFlaggedMove(struct moveList * list, int from, int to, int flag) {
+    list->moves[list->count++] = MOVE_ENCODE(from, to, 0) | flag;
+}
+
+static void addPawnMove(struct moveList * list, int from, int to, int promotionRow) {
+    // Pawn reaching the last row must promote, queen first since it is nearly always the best.
+    if(SQUARE_ROW(to) == promotionRow) {
+        for(int rank = 5; rank >= 2; rank--) {
+            list->moves[list->count++] = MOVE_ENCODE(from, to, rank);
+        }
+    }
+    else {
+        addMove(list, from, to);
+    }
+}
+
+static void generatePawnMoves(const struct position * pos, struct moveList * list, int from) {
+    int player = pos->turn;
+    int row = SQUARE_ROW(from);
+    int column = SQUARE_COLUMN(from);
+    int direction = (player == 1) ? 1 : -1;
+    int startRow = (player == 1) ? 1 : 6;
+    int promotionRow = (player == 1) ? 7 : 0;
+    int nextRow = row + direction;
+
+    // A pawn on the last row cannot move (it can only get there in a hand built scenario).
+    if(nextRow < 0 || nextRow > 7) {
+        return;
+    }
+
+    // Forward moves
+    if(pos->board[SQUARE(nextRow, column)].rank == 0) {
+        addPawnMove(list, from, SQUARE(nextRow, column), promotionRow);
+
+        if(row == startRow && pos->board[SQUARE(nextRow + direction, column)].rank == 0) {
+            addMove(list, from, SQUARE(nextRow + direction, column));
+        }
+    }
+
+    // Captures
+    for(int side = -1; side <= 1; side += 2) {
+        if(column + side < 0 || column + side > 7) {
+            continue;
+        }
+        struct chessPiece target = pos->board[SQUARE(nextRow, column + side)];
+        if(target.rank != 0 && target.owner != player) {
+            addPawnMove(list, from, SQUARE(nextRow, column + side), promotionRow);
+        }
+        else if(SQUARE(nextRow, column + side) == pos->enPassantSquare) {
+            addFlaggedMove(list, from, pos->enPassantSquare, MOVE_EN_PASSANT);
+        }
+    }
+}
+
+static void generateStepMoves(const struct position * pos, struct moveList * list, int from,
+                              const int steps[8][2]) {
+    // Knight and king moves.
+    int row = SQUARE_ROW(from);
+    int column = SQUARE_COLUMN(from);
+
+    for(int i = 0; i < 8; i++) {
+        int toRow = row + steps[i][0];
+        int toColumn = column + steps[i][1];
+        if(toRow < 0 || toRow > 7 || toColumn < 0 || toColumn > 7) {
+            continue;
+        }
+        if(pos->board[SQUARE(toRow, toColumn)].owner != pos->turn) {
+            addMove(list, from, SQUARE(toRow, toColumn));
+        }
+    }
+}
+
+static void generateSliderMoves(const struct position * pos, struct moveList * list, int from,
+                                int firstDirection, int lastDirection) {
+    // Rook, bishop and queen moves. Directions index kingSteps: 0-3 straight, 4-7 diagonal.
+    for(int i = firstDirection; i <= lastDirection; i++) {
+        int toRow = SQUARE_ROW(from) + kingSteps[i][0];
+        int toColumn = SQUARE_COLUMN(from) + kingSteps[i][1];
+
+        while(toRow >= 0 && toRow <= 7 && toColumn >= 0 && toColumn <= 7) {
+            struct chessPiece target = pos->board[SQUARE(toRow, toColumn)];
+            if(target.owner != pos->turn) {
+                addMove(list, from, SQUARE(toRow, toColumn));
+            }
+            // Path is blocked by any piece.
+            if(target.rank != 0) {
+                break;
+            }
+            toRow += kingSteps[i][0];
+            toColumn += kingSteps[i][1];
+        }
+    }
+}
+
+static void generateCastlingMoves(const struct position * pos, struct moveList * list, int from) {
+    // The king's two step move towards a rook. Whether the king lands in check is left to the legality check like
+    // for any other move, the start and the square it passes are checked here.
+    int player = pos->turn;
+    int opponent = (player % 2) + 1;
+    int row = (player == 1) ? 0 : 7;
+    int shortRight = (player == 1) ? CASTLING_PLAYER1_SHORT : CASTLING_PLAYER2_SHORT;
+    int longRight = (player == 1) ? CASTLING_PLAYER1_LONG : CASTLING_PLAYER2_LONG;
+
+    if(from != SQUARE(row, 4) || !(pos->castlingRights & (shortRight | longRight)) ||
+       isSquareAttacked(pos, from, opponent)) {
+        return;
+    }
+
+    if((pos->castlingRights & shortRight) && pos->board[SQUARE(row, 5)].rank == 0 &&
+       pos->board[SQUARE(row, 6)].rank == 0 && !isSquareAttacked(pos, SQUARE(row, 5), opponent)) {
+        addFlaggedMove(list, from, SQUARE(row, 6), MOVE_CASTLING);
+    }
+    if((pos->castlingRights & longRight) && pos->board[SQUARE(row, 3)].rank == 0 &&
+       pos->board[SQUARE(row, 2)].rank == 0 && pos->board[SQUARE(row, 1)].rank == 0 &&
+       !isSquareAttacked(pos, SQUARE(row, 3), opponent)) {
+        addFlaggedMove(list, from, SQUARE(row, 2), MOVE_CASTLING);
+    }
+}
+
+void generatePseudoLegalMoves(const struct position * pos, struct moveList * list) {
+    // Generate all moves for the player in turn, ignoring whether their own king is left in check.
+    list->count = 0;
+
+    for(int i = 0; i < pos->pieceListCount[pos->turn]; i++) {
+        int square = pos->pieceSquares[pos->turn][i];
+
+        switch(pos->board[square].rank) {
+            // Pawn
+            case 1:
+                generatePawnMoves(pos, list, square);
+                break;
+            // Rook
+            case 2:
+                generateSliderMoves(pos, list, square, 0, 3);
+                break;
+            // Knight
+            case 3:
+                generateStepMoves(pos, list, square, knightJumps);
+                break;
+            // Bishop
+            case 4:
+                generateSliderMoves(pos, list, square, 4, 7);
+                break;
+            // Queen
+            case 5:
+                generateSliderMoves(pos, list, square, 0, 7);
+                break;
+            // King
+            case 6:
+                generateStepMoves(pos, list, square, kingSteps);
+                generateCastlingMoves(pos, list, square);
+                break;
+        }
+    }
+}
+
+void generateLegalMoves(struct position * pos, struct moveList * list) {
+    // Pseudo-legal moves filtered by make / unmake. The position is left unchanged.
+    struct moveList pseudoLegal;
+    struct undoRecord undo;
+    int player = pos->turn;
+
+    generatePseudoLegalMoves(pos, &pseudoLegal);
+
+    list->count = 0;
+    for(int i = 0; i < pseudoLegal.count; i++) {
+        makeMove(pos, pseudoLegal.moves[i], &undo);
+        if(!isPlayerInCheck(pos, player)) {
+            list->moves[list->count++] = pseudoLegal.moves[i];
+        }
+        unmakeMove(pos, pseudoLegal.moves[i], &undo);
+    }
+}
+
+int isLegalMove(struct position * pos, int move) {
+    // Check a move against the generated legal moves.
+    struct moveList list;
+    generateLegalMoves(pos, &list);
+
+    for(int i = 0; i < list.count; i++) {
+        if(list.moves[i] == move) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int findLegalMove(struct position * pos, int move) {
+    // The legal move with the same from, to and promotion, flags included. Moves read from text or a chessboard
+    // don't know if they castle or capture en passant. Returns MOVE_NONE if there is no such move.
+    struct moveList list;
+    generateLegalMoves(pos, &list);
+
+    int wanted = MOVE_ENCODE(MOVE_FROM(move), MOVE_TO(move), MOVE_PROMOTION(move));
+    for(int i = 0; i < list.count; i++) {
+        if(MOVE_ENCODE(MOVE_FROM(list.moves[i]), MOVE_TO(list.moves[i]), MOVE_PROMOTION(list.moves[i])) == wanted) {
+            return list.moves[i];
+        }
+    }
+    return MOVE_NONE;
+}
+
+// LEGAL MOVE CACHE ----------------------------------------------------------------------------------------------------
+void clearLegalMoveCache(struct legalMoveCache * cache) {
+    cache->key = 0;
+    cache->valid = 0;
+    cache->moves.count = 0;
+}
+
+const struct moveList * getCachedLegalMoves(struct legalMoveCache * cache, struct position * pos) {
+    // Legal moves of pos, generated only if the cache holds another position.
+    if(!cache->valid || cache->key != pos->key) {
+        generateLegalMoves(pos, &cache->moves);
+        cache->key = pos->key;
+        cache->valid = 1;
+    }
+    return &cache->moves;
+}
+
+int getLegalDestinations(struct legalMoveCache * cache, struct position * pos, int from, int * outSquares) {
+    // Squares the piece on from can legally move to, each once (a promotion is 4 moves to the same square).
+    // outSquares must hold 64 squares. Returns the number of squares.
+    const struct moveList * list = getCachedLegalMoves(cache, pos);
+    uint64_t seen = 0;
+    int count = 0;
+
+    for(int i = 0; i < list->count; i++) {
+        int to = MOVE_TO(list->moves[i]);
+        if(MOVE_FROM(list->moves[i]) == from && !(seen & ((uint64_t)1 << to))) {
+            seen |= (uint64_t)1 << to;
+            outSquares[count++] = to;
+        }
+    }
+    return count;
+}
+
+int findCachedMove(struct legalMoveCache * cache, struct position * pos, int from, int to, int promotion) {
+    // The legal move from -> to, flags included. With promotion 0 any promotion matches, so the caller can see if
+    // the move promotes before asking what to. Returns MOVE_NONE if there is no such move.
+    const struct moveList * list = getCachedLegalMoves(cache, pos);
+
+    for(int i = 0; i < list->count; i++) {
+        int move = list->moves[i];
+        if(MOVE_FROM(move) == from && MOVE_TO(move) == to && (promotion == 0 || MOVE_PROMOTION(move) == promotion)) {
+            return move;
+        }
+    }
+    return MOVE_NONE;
+}
+
+// PERFT ---------------------------------------------------------------------------------------------------------------
+long long perft(struct position * pos, int depth) {
+    // Number of legal move sequences of length depth. The last ply is counted without making the moves.
+    struct moveList list;
+    struct undoRecord undo;
+    long long nodes = 0;
+
+    generateLegalMoves(pos, &list);
+    if(depth <= 1) {
+        return (depth == 1) ? list.count : 1;
+    }
+    for(int i = 0; i < list.count; i++) {
+        makeMove(pos, list.moves[i], &undo);
+        nodes += perft(pos, depth - 1);
+        unmakeMove(pos, list.moves[i], &undo);
+    }
+    return nodes;
+}
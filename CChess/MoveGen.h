@@ -0,0 +1,38 @@
+/*
+File:           MoveGen.h
+Author:         Toni Lindeman
+Description:    Move generation for positions.
+*/
+
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "Position.h"
+
+// No legal chess position has more than 218 moves.
+#define MAX_MOVES 256
+
+struct moveList {
+    int moves[MAX_MOVES];
+    int count;
+};
+
+// Legal moves of the last position asked for, by its key. A player trying piece after piece in the same position
+// only costs one generation.
+struct legalMoveCache {
+    uint64_t key;
+    int valid;
+    struct moveList moves;
+};
+
+void generatePseudoLegalMoves(const struct position * pos, struct moveList * list);
+void generateLegalMoves(struct position * pos, struct moveList * list);
+int isLegalMove(struct position * pos, int move);
+int findLegalMove(struct position * pos, int move);
+void clearLegalMoveCache(struct legalMoveCache * cache);
+const struct moveList * getCachedLegalMoves(struct legalMoveCache * cache, struct position * pos);
+int getLegalDestinations(struct legalMoveCache * cache, struct position * pos, int from, int * outSquares);
+int findCachedMove(struct legalMoveCache * cache, struct position * pos, int from, int to, int promotion);
+long long perft(struct position * pos, int depth);
+
+#endif /* MOVEGEN_H */
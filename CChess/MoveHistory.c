@@ -0,0 +1,99 @@
+/*
+File:           MoveHistory.c
+Author:         Toni Lindeman
+Description:    The moves of a game with their undo records, for takeback, redo, draw rules and export.
+
+The history is the game: the position on the board is the start position with the played moves made on it. Every
+move keeps the undo record makeMove filled, so taking a move back is one unmakeMove and redoing it one makeMove,
+however long the game is. A new move drops the moves that could have been redone.
+*/
+
+#include <stdlib.h>
+#include "MoveHistory.h"
+
+static void refillKeys(struct moveHistory * history) {
+    // The keys only keep the newer half of a long game (see pushPositionHistory). Once takebacks have used them up,
+    // take the keys of older positions from the undo records, which know the key before every move.
+    int first = history->count - (POSITION_HISTORY_MAX / 2);
+    if(first < 0) {
+        first = 0;
+    }
+    clearPositionHistory(&history->keys);
+    for(int i = first; i < history->count; i++) {
+        pushPositionHistory(&history->keys, history->undos[i].key);
+    }
+}
+
+void initMoveHistory(struct moveHistory * history, const struct position * start) {
+    history->start = *start;
+    history->current = *start;
+    history->moves = NULL;
+    history->undos = NULL;
+    history->count = 0;
+    history->redoCount = 0;
+    history->capacity = 0;
+    clearPositionHistory(&history->keys);
+}
+
+void freeMoveHistory(struct moveHistory * history) {
+    free(history->moves);
+    free(history->undos);
+    history->moves = NULL;
+    history->undos = NULL;
+    history->count = 0;
+    history->redoCount = 0;
+    history->capacity = 0;
+}
+
+int playHistoryMove(struct moveHistory * history, int move) {
+    // Make a legal move on the current position and record it. Returns 0 if the history couldn't grow, the move is
+    // not made then.
+    if(history->count == history->capacity) {
+        int newCapacity = (history->capacity == 0) ? 64 : 2 * history->capacity;
+        int * newMoves = realloc(history->moves, newCapacity * sizeof(int));
+        if(!newMoves) {
+            return 0;
+        }
+        history->moves = newMoves;
+        struct undoRecord * newUndos = realloc(history->undos, newCapacity * sizeof(struct undoRecord));
+        if(!newUndos) {
+            return 0;
+        }
+        history->undos = newUndos;
+        history->capacity = newCapacity;
+    }
+
+    pushPositionHistory(&history->keys, history->current.key);
+    makeMove(&history->current, move, &history->undos[history->count]);
+    history->moves[history->count++] = move;
+    history->redoCount = 0;
+    return 1;
+}
+
+int takeBackMove(struct moveHistory * history) {
+    // Take back the last move played, it can be redone until a new move is played. Returns 0 if there is none.
+    if(history->count == 0) {
+        return 0;
+    }
+    history->count--;
+    unmakeMove(&history->current, history->moves[history->count], &history->undos[history->count]);
+    history->redoCount++;
+
+    popPositionHistory(&history->keys);
+    if(history->keys.count == 0 && history->count > 0) {
+        refillKeys(history);
+    }
+    return 1;
+}
+
+int redoMove(struct moveHistory * history) {
+    // Play the last move taken back again. Returns 0 if there is none.
+    if(history->redoCount == 0) {
+        return 0;
+    }
+    pushPositionHistory(&history->keys, history->current.key);
+    makeMove(&history->current, history->moves[history->count], &history->undos[history->count]);
+    history->count++;
+    history->redoCount--;
+    return 1;
+}
@@ -0,0 +1,33 @@
+/*
+File:           MoveHistory.h
+Author:         Toni Lindeman
+Description:    The moves of a game with their undo records, for takeback, redo, draw rules and export.
+*/
+
+#ifndef MOVEHISTORY_H
+#define MOVEHISTORY_H
+
+#include "Position.h"
+
+struct moveHistory {
+    // Position the game started from, and the position on the board now.
+    struct position start;
+    struct position current;
+    // Moves played, followed by the moves taken back that can still be redone. undos[i] takes back moves[i].
+    int * moves;
+    struct undoRecord * undos;
+    int count;
+    int redoCount;
+    int capacity;
+    // Keys of the positions before the moves played, for the draw rules and the search. Taken from the undo
+    // records, see takeBackMove.
+    struct positionHistory keys;
+};
+
+void initMoveHistory(struct moveHistory * history, const struct position * start);
+void freeMoveHistory(struct moveHistory * history);
+int playHistoryMove(struct moveHistory * history, int move);
+int takeBackMove(struct moveHistory * history);
+int redoMove(struct moveHistory * history);
+
+#endif /* MOVEHISTORY_H */
@@ -0,0 +1,369 @@
+/*
+File:           Network.c
+Author:         Toni Lindeman
+Description:    Efficiently updatable neural network evaluation (NNUE style).
+
+The network has four layers:
+- 768 -> 256 feature transformer. Every piece on a square is one input feature, seen from each player's side
+  (own / opponent piece, squares mirrored for player 2). Its output, the accumulator, is the sum of the weight rows
+  of the pieces on the board, so a move only adds and subtracts a couple of rows instead of recomputing it.
+- 512 -> 32 and 32 -> 32 dense layers with int8 weights. Input is both accumulators clamped to 0-127, the player
+  in turn's first.
+- 32 -> 1 output, in units of outputDivisor per centipawn.
+
+Training happens elsewhere. The file is a fixed header and the arrays exactly as they are used (see Network.h),
+so it is memory mapped and used in place, with no parsing. Numbers are little endian, like every machine this
+runs on.
+
+The accumulator and dense layer loops have AVX2 and SSE2 versions, picked at compile time. "make NATIVE=1" builds
+for the machine's own instruction set, so AVX2 is used where the CPU has it.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "OSSpecific.h"
+#include "Network.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NETWORK_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NETWORK_SSE2
+#endif
+
+#define NETWORK_PADDED(bytes) ((((bytes) + NETWORK_ALIGNMENT - 1) / NETWORK_ALIGNMENT) * NETWORK_ALIGNMENT)
+
+// The network opened with openNetwork, shared read only by every search thread.
+static struct network loadedNetwork = {NULL, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0};
+
+// FILE ----------------------------------------------------------------------------------------------------------------
+static size_t getNetworkArrays(const char * data, struct network * net) {
+    // Point the arrays of net into the file data, or just count the bytes if data is NULL. Returns the file size.
+    // The layout is worked out in offsets, pointers are only made when there is data to point into.
+    const size_t sizes[9] = {
+        sizeof(struct networkHeader),
+        NETWORK_FEATURES * NETWORK_HIDDEN * sizeof(int16_t),
+        NETWORK_HIDDEN * sizeof(int16_t),
+        NETWORK_LAYER1 * 2 * NETWORK_HIDDEN,
+        NETWORK_LAYER1 * sizeof(int32_t),
+        NETWORK_LAYER2 * NETWORK_LAYER1,
+        NETWORK_LAYER2 * sizeof(int32_t),
+        NETWORK_LAYER2,
+        // Output bias is read with memcpy, it's only one number.
+        sizeof(int32_t)
+    };
+    size_t offsets[9];
+    size_t offset = 0;
+    for(int i = 0; i < 9; i++) {
+        offsets[i] = offset;
+        offset += NETWORK_PADDED(sizes[i]);
+    }
+
+    if(data) {
+        net->featureWeights = (const int16_t *)(data + offsets[1]);
+        net->featureBiases = (const int16_t *)(data + offsets[2]);
+        net->layer1Weights = (const int8_t *)(data + offsets[3]);
+        net->layer1Biases = (const int32_t *)(data + offsets[4]);
+        net->layer2Weights = (const int8_t *)(data + offsets[5]);
+        net->layer2Biases = (const int32_t *)(data + offsets[6]);
+        net->outputWeights = (const int8_t *)(data + offsets[7]);
+    }
+    return offset;
+}
+
+int openNetwork(const char * fileName) {
+    // Map a network file for evaluation. Returns 0 if there is no valid network in the file.
+    struct network net;
+    struct networkHeader header;
+
+    closeNetwork();
+    net.data = mapFile(fileName, &net.size);
+    if(!net.data) {
+        return 0;
+    }
+
+    size_t expectedSize = getNetworkArrays(NULL, &net);
+    memset(&header, 0, sizeof(header));
+    if(net.size >= expectedSize) {
+        memcpy(&header, net.data, sizeof(header));
+    }
+    if(header.magic != NETWORK_MAGIC || header.version != NETWORK_VERSION ||
+       header.features != NETWORK_FEATURES || header.hidden != NETWORK_HIDDEN || header.layer1 != NETWORK_LAYER1 ||
+       header.layer2 != NETWORK_LAYER2 || header.outputDivisor <= 0) {
+        fprintf(stderr, "%s is not a %d-%d-%d-%d-1 network of version %d.\n", fileName, NETWORK_FEATURES,
+                NETWORK_HIDDEN * 2, NETWORK_LAYER1, NETWORK_LAYER2, NETWORK_VERSION);
+        unmapFile(net.data, net.size);
+        return 0;
+    }
+
+    getNetworkArrays(net.data, &net);
+    memcpy(&net.outputBias, net.data + expectedSize - NETWORK_PADDED(sizeof(int32_t)), sizeof(int32_t));
+    net.outputDivisor = header.outputDivisor;
+    loadedNetwork = net;
+    return 1;
+}
+
+void closeNetwork() {
+    // Must not be called while a search is running.
+    unmapFile(loadedNetwork.data, loadedNetwork.size);
+    loadedNetwork.data = NULL;
+    loadedNetwork.size = 0;
+}
+
+const struct network * getNetwork() {
+    // The open network, NULL if there is none and the handwritten evaluation is used.
+    return loadedNetwork.data ? &loadedNetwork : NULL;
+}
+
+const char * getNetworkInstructionSet() {
+#if defined(NETWORK_AVX2)
+    return "AVX2";
+#elif defined(NETWORK_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+int writeMaterialNetwork(const char * fileName) {
+    // Write a network that counts material with the usual piece values. It is a correct starting point for
+    // training, and a reference to check the inference against the handwritten evaluation. Returns 0 on failure.
+    static const int pieceWeights[6] = {10, 50, 32, 33, 90, 0};
+    struct network layout;
+    size_t size = getNetworkArrays(NULL, &layout);
+    char * data = (char *) calloc(1, size);
+    if(!data) {
+        return 0;
+    }
+    getNetworkArrays(data, &layout);
+
+    struct networkHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = NETWORK_MAGIC;
+    header.version = NETWORK_VERSION;
+    header.features = NETWORK_FEATURES;
+    header.hidden = NETWORK_HIDDEN;
+    header.layer1 = NETWORK_LAYER1;
+    header.layer2 = NETWORK_LAYER2;
+    header.outputDivisor = 1;
+    memcpy(data, &header, sizeof(header));
+
+    // Hidden neuron r - 1 counts own pieces of rank r, 10 (0.08) per piece.
+    int16_t * featureWeights = (int16_t *) layout.featureWeights;
+    int8_t * layer1Weights = (int8_t *) layout.layer1Weights;
+    int8_t * layer2Weights = (int8_t *) layout.layer2Weights;
+    int8_t * outputWeights = (int8_t *) layout.outputWeights;
+    for(int rank = 1; rank <= 5; rank++) {
+        for(int square = 0; square < 64; square++) {
+            featureWeights[((rank - 1) * 64 + square) * NETWORK_HIDDEN + rank - 1] = 10;
+        }
+        // Own counts to layer 1 neurons 0-4, opponent counts to 5-9, passed through layer 2 as they are.
+        layer1Weights[(rank - 1) * 2 * NETWORK_HIDDEN + rank - 1] = 1 << NETWORK_WEIGHT_SHIFT;
+        layer1Weights[(rank + 4) * 2 * NETWORK_HIDDEN + NETWORK_HIDDEN + rank - 1] = 1 << NETWORK_WEIGHT_SHIFT;
+        layer2Weights[(rank - 1) * NETWORK_LAYER1 + rank - 1] = 1 << NETWORK_WEIGHT_SHIFT;
+        layer2Weights[(rank + 4) * NETWORK_LAYER1 + rank + 4] = 1 << NETWORK_WEIGHT_SHIFT;
+        outputWeights[rank - 1] = (int8_t) pieceWeights[rank - 1];
+        outputWeights[rank + 4] = (int8_t) -pieceWeights[rank - 1];
+    }
+
+    FILE * file = fopen(fileName, "wb");
+    int success = file && fwrite(data, 1, size, file) == size;
+    if(file) {
+        success = (fclose(file) == 0) && success;
+    }
+    free(data);
+    return success;
+}
+
+// ACCUMULATOR ---------------------------------------------------------------------------------------------------------
+static int getFeatureIndex(int perspective, struct chessPiece piece, int square) {
+    // Own pieces first, squares from the perspective player's side of the board.
+    int side = (piece.owner == perspective) ? 0 : 6;
+    int relativeSquare = (perspective == 1) ? square : (square ^ 56);
+    return ((side + piece.rank - 1) * 64) + relativeSquare;
+}
+
+static void applyChanges(const struct network * net, const int16_t * from, int16_t * to, int perspective,
+                         const struct featureChange * changes, int changeCount) {
+    // to = from plus the weight rows of added pieces, minus those of removed pieces. to and from may be the same.
+    const int16_t * rows[4];
+    for(int i = 0; i < changeCount; i++) {
+        rows[i] = net->featureWeights +
+                  (getFeatureIndex(perspective, changes[i].piece, changes[i].square) * NETWORK_HIDDEN);
+    }
+
+#if defined(NETWORK_AVX2)
+    for(int i = 0; i < NETWORK_HIDDEN; i += 16) {
+        __m256i values = _mm256_load_si256((const __m256i *)(from + i));
+        for(int change = 0; change < changeCount; change++) {
+            __m256i row = _mm256_load_si256((const __m256i *)(rows[change] + i));
+            values = changes[change].added ? _mm256_add_epi16(values, row) : _mm256_sub_epi16(values, row);
+        }
+        _mm256_store_si256((__m256i *)(to + i), values);
+    }
+#elif defined(NETWORK_SSE2)
+    for(int i = 0; i < NETWORK_HIDDEN; i += 8) {
+        __m128i values = _mm_load_si128((const __m128i *)(from + i));
+        for(int change = 0; change < changeCount; change++) {
+            __m128i row = _mm_load_si128((const __m128i *)(rows[change] + i));
+            values = changes[change].added ? _mm_add_epi16(values, row) : _mm_sub_epi16(values, row);
+        }
+        _mm_store_si128((__m128i *)(to + i), values);
+    }
+#else
+    for(int i = 0; i < NETWORK_HIDDEN; i++) {
+        int value = from[i];
+        for(int change = 0; change < changeCount; change++) {
+            value += changes[change].added ? rows[change][i] : -rows[change][i];
+        }
+        to[i] = (int16_t) value;
+    }
+#endif
+}
+
+void refreshAccumulator(const struct network * net, const struct position * pos, struct accumulator * acc) {
+    // Compute an accumulator from scratch: biases plus the rows of every piece on the board.
+    for(int perspective = 1; perspective <= 2; perspective++) {
+        int16_t * values = acc->values[perspective - 1];
+        memcpy(values, net->featureBiases, NETWORK_HIDDEN * sizeof(int16_t));
+
+        for(int square = 0; square < 64; square++) {
+            if(pos->board[square].rank != 0) {
+                struct featureChange change = {square, pos->board[square], 1};
+                applyChanges(net, values, values, perspective, &change, 1);
+            }
+        }
+    }
+    acc->computed = 1;
+    acc->changeCount = 0;
+}
+
+void recordMoveChanges(const struct position * pos, int move, struct accumulator * acc) {
+    // Remember what move (MOVE_NONE for a null move) changes, before it is made on pos. acc is the accumulator of
+    // the position after the move, it is computed later with updateAccumulator if it's needed.
+    acc->computed = 0;
+    acc->changeCount = 0;
+    if(move == MOVE_NONE) {
+        return;
+    }
+
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int capturedSquare = MOVE_IS_EN_PASSANT(move) ? EN_PASSANT_CAPTURE_SQUARE(move) : to;
+    struct chessPiece moved = pos->board[from];
+
+    acc->changes[acc->changeCount++] = (struct featureChange) {from, moved, 0};
+    if(pos->board[capturedSquare].rank != 0) {
+        acc->changes[acc->changeCount++] = (struct featureChange) {capturedSquare, pos->board[capturedSquare], 0};
+    }
+    if(MOVE_PROMOTION(move)) {
+        moved.rank = MOVE_PROMOTION(move);
+    }
+    acc->changes[acc->changeCount++] = (struct featureChange) {to, moved, 1};
+
+    if(MOVE_IS_CASTLING(move)) {
+        int rookFrom;
+        int rookTo;
+        getCastlingRookMove(move, &rookFrom, &rookTo);
+        acc->changes[acc->changeCount++] = (struct featureChange) {rookFrom, pos->board[rookFrom], 0};
+        acc->changes[acc->changeCount++] = (struct featureChange) {rookTo, pos->board[rookFrom], 1};
+    }
+}
+
+void updateAccumulator(const struct network * net, const struct accumulator * previous, struct accumulator * acc) {
+    // acc = previous with the recorded changes applied. previous must be computed.
+    applyChanges(net, previous->values[0], acc->values[0], 1, acc->changes, acc->changeCount);
+    applyChanges(net, previous->values[1], acc->values[1], 2, acc->changes, acc->changeCount);
+    acc->computed = 1;
+}
+
+// DENSE LAYERS --------------------------------------------------------------------------------------------------------
+static void clampAccumulator(const int16_t * values, uint8_t * out) {
+    // Clipped ReLU to 0-127 and narrow to bytes.
+#if defined(NETWORK_AVX2)
+    const __m256i maximum = _mm256_set1_epi16(NETWORK_ACTIVATION_MAX);
+    for(int i = 0; i < NETWORK_HIDDEN; i += 32) {
+        __m256i low = _mm256_min_epi16(_mm256_load_si256((const __m256i *)(values + i)), maximum);
+        __m256i high = _mm256_min_epi16(_mm256_load_si256((const __m256i *)(values + i + 16)), maximum);
+        // packus clamps negatives to 0, but interleaves the 128 bit lanes. The permute puts them back in order.
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        _mm256_store_si256((__m256i *)(out + i), packed);
+    }
+#elif defined(NETWORK_SSE2)
+    const __m128i maximum = _mm_set1_epi16(NETWORK_ACTIVATION_MAX);
+    for(int i = 0; i < NETWORK_HIDDEN; i += 16) {
+        __m128i low = _mm_min_epi16(_mm_load_si128((const __m128i *)(values + i)), maximum);
+        __m128i high = _mm_min_epi16(_mm_load_si128((const __m128i *)(values + i + 8)), maximum);
+        _mm_store_si128((__m128i *)(out + i), _mm_packus_epi16(low, high));
+    }
+#else
+    for(int i = 0; i < NETWORK_HIDDEN; i++) {
+        int value = values[i];
+        out[i] = (uint8_t)((value < 0) ? 0 : (value > NETWORK_ACTIVATION_MAX) ? NETWORK_ACTIVATION_MAX : value);
+    }
+#endif
+}
+
+static int32_t dotProduct(const uint8_t * input, const int8_t * weights, int count) {
+    // count must be a multiple of 32. Inputs are at most 127, so the pairwise sums can't saturate.
+#if defined(NETWORK_AVX2)
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for(int i = 0; i < count; i += 32) {
+        __m256i products = _mm256_maddubs_epi16(_mm256_load_si256((const __m256i *)(input + i)),
+                                                _mm256_load_si256((const __m256i *)(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+    return _mm_cvtsi128_si32(sum128);
+#elif defined(NETWORK_SSE2)
+    // No byte multiply before SSSE3: widen both to 16 bits, weights with their sign.
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = _mm_setzero_si128();
+    for(int i = 0; i < count; i += 16) {
+        __m128i in = _mm_load_si128((const __m128i *)(input + i));
+        __m128i weight = _mm_load_si128((const __m128i *)(weights + i));
+        __m128i weightLow = _mm_srai_epi16(_mm_unpacklo_epi8(weight, weight), 8);
+        __m128i weightHigh = _mm_srai_epi16(_mm_unpackhi_epi8(weight, weight), 8);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(in, zero), weightLow));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(in, zero), weightHigh));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int32_t sum = 0;
+    for(int i = 0; i < count; i++) {
+        sum += input[i] * weights[i];
+    }
+    return sum;
+#endif
+}
+
+static void denseLayer(const uint8_t * input, int inputCount, const int8_t * weights, const int32_t * biases,
+                       int outputCount, uint8_t * output) {
+    // output = clamp((biases + weights * input) / 64, 0, 127)
+    for(int i = 0; i < outputCount; i++) {
+        int32_t value = (biases[i] + dotProduct(input, weights + (i * inputCount), inputCount)) >> NETWORK_WEIGHT_SHIFT;
+        output[i] = (uint8_t)((value < 0) ? 0 : (value > NETWORK_ACTIVATION_MAX) ? NETWORK_ACTIVATION_MAX : value);
+    }
+}
+
+int evaluateNetwork(const struct network * net, const struct accumulator * acc, int turn) {
+    // Score in centipawns for the player in turn. acc must be computed.
+    alignas(NETWORK_ALIGNMENT) uint8_t input[2 * NETWORK_HIDDEN];
+    alignas(NETWORK_ALIGNMENT) uint8_t hidden1[NETWORK_LAYER1];
+    alignas(NETWORK_ALIGNMENT) uint8_t hidden2[NETWORK_LAYER2];
+
+    clampAccumulator(acc->values[turn - 1], input);
+    clampAccumulator(acc->values[2 - turn], input + NETWORK_HIDDEN);
+    denseLayer(input, 2 * NETWORK_HIDDEN, net->layer1Weights, net->layer1Biases, NETWORK_LAYER1, hidden1);
+    denseLayer(hidden1, NETWORK_LAYER1, net->layer2Weights, net->layer2Biases, NETWORK_LAYER2, hidden2);
+
+    int32_t output = net->outputBias + dotProduct(hidden2, net->outputWeights, NETWORK_LAYER2);
+    return output / net->outputDivisor;
+}
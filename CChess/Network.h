@@ -0,0 +1,92 @@
+/*
+File:           Network.h
+Author:         Toni Lindeman
+Description:    Efficiently updatable neural network evaluation (NNUE style).
+*/
+
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdalign.h>
+#include "Position.h"
+
+// Used if it exists, like the tablebases.
+#define NETWORK_DEFAULT_FILE "cchess.nnue"
+
+// "CCNN" read as a little endian number.
+#define NETWORK_MAGIC 0x4E4E4343
+#define NETWORK_VERSION 1
+
+// Piece (owner relative to the perspective, rank) times square.
+#define NETWORK_FEATURES 768
+#define NETWORK_HIDDEN 256
+#define NETWORK_LAYER1 32
+#define NETWORK_LAYER2 32
+
+// Fixed point scales: accumulator and layer outputs use 127 for 1.0, dense layer weights 64.
+#define NETWORK_ACTIVATION_MAX 127
+#define NETWORK_WEIGHT_SHIFT 6
+
+// Every array in the file starts at a multiple of this, so the mapped arrays can be used with aligned loads.
+#define NETWORK_ALIGNMENT 64
+
+// File layout: this header, then featureWeights int16[FEATURES][HIDDEN], featureBiases int16[HIDDEN],
+// layer1Weights int8[LAYER1][2 * HIDDEN], layer1Biases int32[LAYER1], layer2Weights int8[LAYER2][LAYER1],
+// layer2Biases int32[LAYER2], outputWeights int8[LAYER2] and outputBias int32, all little endian and each padded
+// to NETWORK_ALIGNMENT bytes.
+struct networkHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t features;
+    uint32_t hidden;
+    uint32_t layer1;
+    uint32_t layer2;
+    // Output units per centipawn.
+    int32_t outputDivisor;
+    uint32_t reserved[9];
+};
+
+struct network {
+    const char * data;
+    size_t size;
+    const int16_t * featureWeights;
+    const int16_t * featureBiases;
+    const int8_t * layer1Weights;
+    const int32_t * layer1Biases;
+    const int8_t * layer2Weights;
+    const int32_t * layer2Biases;
+    const int8_t * outputWeights;
+    int32_t outputBias;
+    int32_t outputDivisor;
+};
+
+// One piece put on or taken off a square.
+struct featureChange {
+    int square;
+    struct chessPiece piece;
+    int added;
+};
+
+// First layer output of one position, from both players' point of view. Search keeps one per ply and brings it
+// up to date from the previous ply's with the changes of the move in between.
+struct accumulator {
+    alignas(NETWORK_ALIGNMENT) int16_t values[2][NETWORK_HIDDEN];
+    int computed;
+    int changeCount;
+    // Castling moves two pieces, so at most 4.
+    struct featureChange changes[4];
+};
+
+int openNetwork(const char * fileName);
+void closeNetwork();
+const struct network * getNetwork();
+const char * getNetworkInstructionSet();
+int writeMaterialNetwork(const char * fileName);
+void refreshAccumulator(const struct network * net, const struct position * pos, struct accumulator * acc);
+void recordMoveChanges(const struct position * pos, int move, struct accumulator * acc);
+void updateAccumulator(const struct network * net, const struct accumulator * previous, struct accumulator * acc);
+int evaluateNetwork(const struct network * net, const struct accumulator * acc, int turn);
+
+#endif /* NETWORK_H */
@@ -0,0 +1,496 @@
+/*
+File:           Notation.c
+Author:         Toni Lindeman
+Description:    Text notations for positions and moves (FEN, SAN and coordinate notation).
+
+Player 1 is white and player 2 is black. Chessboard row 0 is rank 1 and column 0 is file a, so the square
+names match the letters and numbers printed around the chessboard.
+*/
+
+#include <stdio.h>
+#include "MoveGen.h"
+#include "Notation.h"
+
+// Piece letters indexed by chess piece rank.
+static const char pieceLetters[] = " PRNBQK";
+
+static int rankFromLetter(char letter) {
+    // Accepts both upper and lower case letters, returns 0 for unknown letters.
+    switch(letter) {
+        case 'P':
+        case 'p':
+            return 1;
+        case 'R':
+        case 'r':
+            return 2;
+        case 'N':
+        case 'n':
+            return 3;
+        case 'B':
+        case 'b':
+            return 4;
+        case 'Q':
+        case 'q':
+            return 5;
+        case 'K':
+        case 'k':
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+// FEN -----------------------------------------------------------------------------------------------------------------
+static int readFenStateFields(struct position * pos, const char * fen, int i) {
+    // Optional castling, en passant and clock fields after the side to move. Reading stops at the first field
+    // that is missing. Returns the index after the last field read.
+    for(int field = 0; field < 2; field++) {
+        int fieldStart = i;
+        while(fen[i] == ' ') {
+            i++;
+        }
+        if(fen[i] == '-') {
+            i++;
+        }
+        else if(field == 0 && (fen[i] == 'K' || fen[i] == 'Q' || fen[i] == 'k' || fen[i] == 'q')) {
+            while(fen[i] == 'K' || fen[i] == 'Q' || fen[i] == 'k' || fen[i] == 'q') {
+                pos->castlingRights |= (fen[i] == 'K') ? CASTLING_PLAYER1_SHORT : (fen[i] == 'Q') ?
+                                       CASTLING_PLAYER1_LONG : (fen[i] == 'k') ? CASTLING_PLAYER2_SHORT :
+                                       CASTLING_PLAYER2_LONG;
+                i++;
+            }
+        }
+        else if(field == 1 && fen[i] >= 'a' && fen[i] <= 'h' && fen[i + 1] >= '1' && fen[i + 1] <= '8') {
+            pos->enPassantSquare = SQUARE(fen[i + 1] - '1', fen[i] - 'a');
+            i += 2;
+        }
+        else {
+            return fieldStart;
+        }
+    }
+
+    // Halfmove and fullmove clocks
+    for(int field = 0; field < 2; field++) {
+        int fieldStart = i;
+        while(fen[i] == ' ') {
+            i++;
+        }
+        if(fen[i] < '0' || fen[i] > '9') {
+            return fieldStart;
+        }
+        int value = 0;
+        while(fen[i] >= '0' && fen[i] <= '9') {
+            value = (value < 10000) ? (10 * value) + (fen[i] - '0') : value;
+            i++;
+        }
+        if(field == 0) {
+            pos->halfmoveClock = value;
+        }
+        else if(value > 0) {
+            pos->fullmoveNumber = value;
+        }
+    }
+    return i;
+}
+
+static int isEnPassantPossible(const struct position * pos) {
+    // FENs often give the en passant square after every two step move, positions only keep it if the player in
+    // turn has a pawn next to the pawn that moved (see Position.h).
+    int square = pos->enPassantSquare;
+    int player = pos->turn;
+    int pawnRow = (player == 1) ? 4 : 3;
+    if(square == NO_SQUARE || SQUARE_ROW(square) != ((player == 1) ? 5 : 2) ||
+       pos->board[square].rank != 0) {
+        return 0;
+    }
+
+    int column = SQUARE_COLUMN(square);
+    struct chessPiece moved = pos->board[SQUARE(pawnRow, column)];
+    if(moved.rank != 1 || moved.owner == player) {
+        return 0;
+    }
+    for(int side = -1; side <= 1; side += 2) {
+        if(column + side >= 0 && column + side <= 7) {
+            struct chessPiece piece = pos->board[SQUARE(pawnRow, column + side)];
+            if(piece.rank == 1 && piece.owner == player) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int readFen(struct position * pos, const char * fen, int strict) {
+    // Reads all FEN fields. Fields after the side to move are optional.
+    // Unless strict, castling rights without the king and rook on their starting squares are dropped, and so is an
+    // en passant square no pawn can capture on. Returns number of characters read, 0 if the FEN is invalid.
+
+    int i = 0;
+    int row = 7;
+    int column = 0;
+
+    for(int square = 0; square < 64; square++) {
+        pos->board[square].rank = 0;
+        pos->board[square].owner = 0;
+    }
+
+    // Piece placement, from row 8 down to row 1.
+    while(fen[i] != ' ' && fen[i] != '\0') {
+        if(fen[i] == '/') {
+            if(column != 8 || row == 0) {
+                return 0;
+            }
+            row--;
+            column = 0;
+        }
+        else if(fen[i] >= '1' && fen[i] <= '8') {
+            column += fen[i] - '0';
+        }
+        else if(rankFromLetter(fen[i]) && column < 8) {
+            pos->board[SQUARE(row, column)].rank = rankFromLetter(fen[i]);
+            // Upper case letters are white (player 1).
+            pos->board[SQUARE(row, column)].owner = (fen[i] >= 'A' && fen[i] <= 'Z') ? 1 : 2;
+            column++;
+        }
+        else {
+            return 0;
+        }
+
+        if(column > 8) {
+            return 0;
+        }
+        i++;
+    }
+    if(row != 0 || column != 8) {
+        return 0;
+    }
+
+    // Side to move
+    while(fen[i] == ' ') {
+        i++;
+    }
+    if(fen[i] == 'w') {
+        pos->turn = 1;
+    }
+    else if(fen[i] == 'b') {
+        pos->turn = 2;
+    }
+    else {
+        return 0;
+    }
+    i++;
+
+    pos->halfmoveClock = 0;
+    pos->fullmoveNumber = 1;
+    pos->castlingRights = 0;
+    pos->enPassantSquare = NO_SQUARE;
+    i = readFenStateFields(pos, fen, i);
+    if(!strict) {
+        pos->castlingRights &= inferCastlingRights(pos);
+        if(!isEnPassantPossible(pos)) {
+            pos->enPassantSquare = NO_SQUARE;
+        }
+    }
+
+    pos->key = computePositionKey(pos);
+    pos->pawnKey = computePawnKey(pos);
+    computePieceCounts(pos);
+
+    return i;
+}
+
+int setPositionFromFen(struct position * pos, const char * fen) {
+    // Position from a FEN, ready to be played. Returns number of characters read, 0 if the FEN is invalid.
+    return readFen(pos, fen, 0);
+}
+
+int setPositionFromFenStrict(struct position * pos, const char * fen) {
+    // Position exactly as the FEN gives it, for checking the FEN itself (see validatePosition). The castling
+    // rights and en passant square may not fit the board, don't search or play the position.
+    return readFen(pos, fen, 1);
+}
+
+void writeFen(const struct position * pos, char * outFen) {
+    // outFen must hold at least FEN_MAX_LENGTH chars.
+    int length = 0;
+
+    for(int row = 7; row >= 0; row--) {
+        int emptyCount = 0;
+
+        for(int column = 0; column < 8; column++) {
+            struct chessPiece piece = pos->board[SQUARE(row, column)];
+
+            if(piece.rank == 0) {
+                emptyCount++;
+                continue;
+            }
+            if(emptyCount) {
+                outFen[length++] = (char)('0' + emptyCount);
+                emptyCount = 0;
+            }
+            // Lower case for black (player 2).
+            outFen[length++] = (char)(pieceLetters[piece.rank] + (piece.owner == 2 ? 'a' - 'A' : 0));
+        }
+        if(emptyCount) {
+            outFen[length++] = (char)('0' + emptyCount);
+        }
+        if(row > 0) {
+            outFen[length++] = '/';
+        }
+    }
+
+    outFen[length++] = ' ';
+    outFen[length++] = (pos->turn == 1) ? 'w' : 'b';
+    outFen[length++] = ' ';
+
+    // Castling rights in KQkq order
+    static const char castlingLetters[4] = {'K', 'Q', 'k', 'q'};
+    for(int i = 0; i < 4; i++) {
+        if(pos->castlingRights & (1 << i)) {
+            outFen[length++] = castlingLetters[i];
+        }
+    }
+    if(!pos->castlingRights) {
+        outFen[length++] = '-';
+    }
+    outFen[length++] = ' ';
+
+    if(pos->enPassantSquare != NO_SQUARE) {
+        outFen[length++] = (char)('a' + SQUARE_COLUMN(pos->enPassantSquare));
+        outFen[length++] = (char)('1' + SQUARE_ROW(pos->enPassantSquare));
+    }
+    else {
+        outFen[length++] = '-';
+    }
+
+    sprintf(outFen + length, " %d %d", pos->halfmoveClock, pos->fullmoveNumber);
+}
+
+// SAN -----------------------------------------------------------------------------------------------------------------
+int moveToSan(struct position * pos, int move, char * outSan) {
+    // Write a legal move in standard algebraic notation, returns length of the string.
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    struct chessPiece piece = pos->board[from];
+    int isCapture = pos->board[to].rank != 0 || MOVE_IS_EN_PASSANT(move);
+    int length = 0;
+
+    struct moveList legalMoves;
+    generateLegalMoves(pos, &legalMoves);
+
+    if(MOVE_IS_CASTLING(move)) {
+        length = sprintf(outSan, (SQUARE_COLUMN(to) == 6) ? "O-O" : "O-O-O");
+    }
+    else if(piece.rank == 1) {
+        // Pawn captures are named after the file the pawn came from.
+        if(isCapture) {
+            outSan[length++] = (char)('a' + SQUARE_COLUMN(from));
+            outSan[length++] = 'x';
+        }
+    }
+    else {
+        outSan[length++] = pieceLetters[piece.rank];
+
+        // Disambiguate if another piece of the same rank can move to the same square.
+        int isAmbiguous = 0;
+        int sameColumn = 0;
+        int sameRow = 0;
+        for(int i = 0; i < legalMoves.count; i++) {
+            int otherFrom = MOVE_FROM(legalMoves.moves[i]);
+            if(MOVE_TO(legalMoves.moves[i]) != to || otherFrom == from || pos->board[otherFrom].rank != piece.rank) {
+                continue;
+            }
+            isAmbiguous = 1;
+            if(SQUARE_COLUMN(otherFrom) == SQUARE_COLUMN(from)) {
+                sameColumn = 1;
+            }
+            if(SQUARE_ROW(otherFrom) == SQUARE_ROW(from)) {
+                sameRow = 1;
+            }
+        }
+        if(isAmbiguous) {
+            if(!sameColumn) {
+                outSan[length++] = (char)('a' + SQUARE_COLUMN(from));
+            }
+            else if(!sameRow) {
+                outSan[length++] = (char)('1' + SQUARE_ROW(from));
+            }
+            else {
+                outSan[length++] = (char)('a' + SQUARE_COLUMN(from));
+                outSan[length++] = (char)('1' + SQUARE_ROW(from));
+            }
+        }
+
+        if(isCapture) {
+            outSan[length++] = 'x';
+        }
+    }
+
+    if(!MOVE_IS_CASTLING(move)) {
+        outSan[length++] = (char)('a' + SQUARE_COLUMN(to));
+        outSan[length++] = (char)('1' + SQUARE_ROW(to));
+    }
+
+    if(MOVE_PROMOTION(move)) {
+        outSan[length++] = '=';
+        outSan[length++] = pieceLetters[MOVE_PROMOTION(move)];
+    }
+
+    // Check or checkmate suffix
+    struct undoRecord undo;
+    makeMove(pos, move, &undo);
+    if(isPlayerInCheck(pos, pos->turn)) {
+        struct moveList replies;
+        generateLegalMoves(pos, &replies);
+        outSan[length++] = replies.count ? '+' : '#';
+    }
+    unmakeMove(pos, move, &undo);
+
+    outSan[length] = '\0';
+    return length;
+}
+
+int sanToMove(struct position * pos, const char * san, int length) {
+    // Resolve a SAN move against the legal moves of the position.
+    // san does not need to be null terminated. Returns MOVE_NONE if the move is illegal or ambiguous.
+
+    // Strip check marks and annotations.
+    while(length > 0 && (san[length - 1] == '+' || san[length - 1] == '#' ||
+                         san[length - 1] == '!' || san[length - 1] == '?')) {
+        length--;
+    }
+
+    if(length < 2) {
+        return MOVE_NONE;
+    }
+
+    // Castling, "O-O" or "O-O-O", also written with zeros.
+    if(san[0] == 'O' || san[0] == '0') {
+        int isLong = (length == 5 && (san[4] == 'O' || san[4] == '0'));
+        if((length != 3 && !isLong) || san[1] != '-' || (san[2] != 'O' && san[2] != '0') ||
+           (isLong && san[3] != '-')) {
+            return MOVE_NONE;
+        }
+        int row = (pos->turn == 1) ? 0 : 7;
+        int move = findLegalMove(pos, MOVE_ENCODE(SQUARE(row, 4), SQUARE(row, isLong ? 2 : 6), 0));
+        return MOVE_IS_CASTLING(move) ? move : MOVE_NONE;
+    }
+
+    int rank = 1;
+    int start = 0;
+    if(san[0] == 'K' || san[0] == 'Q' || san[0] == 'R' || san[0] == 'B' || san[0] == 'N') {
+        rank = rankFromLetter(san[0]);
+        start = 1;
+    }
+
+    // Promotion, "e8=Q" or "e8Q".
+    int promotion = 0;
+    if(rank == 1 && length >= 3 && rankFromLetter(san[length - 1]) >= 2 && rankFromLetter(san[length - 1]) <= 5 &&
+       (san[length - 2] == '=' || (san[length - 1] >= 'A' && san[length - 1] <= 'Z'))) {
+        promotion = rankFromLetter(san[length - 1]);
+        length--;
+        if(san[length - 1] == '=') {
+            length--;
+        }
+    }
+
+    // Target square
+    if(length - start < 2) {
+        return MOVE_NONE;
+    }
+    char targetFile = san[length - 2];
+    char targetRank = san[length - 1];
+    if(targetFile < 'a' || targetFile > 'h' || targetRank < '1' || targetRank > '8') {
+        return MOVE_NONE;
+    }
+    int to = SQUARE(targetRank - '1', targetFile - 'a');
+
+    // Disambiguation, capture mark and long algebraic dash.
+    int fromColumn = -1;
+    int fromRow = -1;
+    for(int i = start; i < length - 2; i++) {
+        if(san[i] >= 'a' && san[i] <= 'h') {
+            fromColumn = san[i] - 'a';
+        }
+        else if(san[i] >= '1' && san[i] <= '8') {
+            fromRow = san[i] - '1';
+        }
+        else if(san[i] != 'x' && san[i] != ':' && san[i] != '-') {
+            return MOVE_NONE;
+        }
+    }
+
+    // Pawn moves without a file letter are straight moves.
+    if(rank == 1 && fromColumn == -1) {
+        fromColumn = targetFile - 'a';
+    }
+
+    // Find the one legal move that fits.
+    struct moveList legalMoves;
+    generateLegalMoves(pos, &legalMoves);
+
+    int found = MOVE_NONE;
+    for(int i = 0; i < legalMoves.count; i++) {
+        int move = legalMoves.moves[i];
+        int from = MOVE_FROM(move);
+
+        if(MOVE_TO(move) != to || MOVE_PROMOTION(move) != promotion || pos->board[from].rank != rank ||
+           MOVE_IS_CASTLING(move)) {
+            continue;
+        }
+        if((fromColumn != -1 && SQUARE_COLUMN(from) != fromColumn) || (fromRow != -1 && SQUARE_ROW(from) != fromRow)) {
+            continue;
+        }
+        // Ambiguous
+        if(found != MOVE_NONE) {
+            return MOVE_NONE;
+        }
+        found = move;
+    }
+
+    return found;
+}
+
+// COORDINATE NOTATION -------------------------------------------------------------------------------------------------
+void moveToCoordinate(int move, char * outText) {
+    // e.g. "e2e4" or "e7e8q". outText must hold at least 6 chars.
+    int length = 0;
+
+    outText[length++] = (char)('a' + SQUARE_COLUMN(MOVE_FROM(move)));
+    outText[length++] = (char)('1' + SQUARE_ROW(MOVE_FROM(move)));
+    outText[length++] = (char)('a' + SQUARE_COLUMN(MOVE_TO(move)));
+    outText[length++] = (char)('1' + SQUARE_ROW(MOVE_TO(move)));
+    if(MOVE_PROMOTION(move)) {
+        outText[length++] = (char)(pieceLetters[MOVE_PROMOTION(move)] + ('a' - 'A'));
+    }
+    outText[length] = '\0';
+}
+
+int coordinateToMove(const char * text, int length) {
+    // Parse e.g. "e2e4" or "e7e8q". Only checks the syntax, legality is up to the caller. Castling and en passant
+    // flags aren't known without the position, findLegalMove adds them.
+    // text does not need to be null terminated. Returns MOVE_NONE if the text is not a move.
+    if(length != 4 && length != 5) {
+        return MOVE_NONE;
+    }
+    for(int i = 0; i < 4; i += 2) {
+        if(text[i] < 'a' || text[i] > 'h' || text[i + 1] < '1' || text[i + 1] > '8') {
+            return MOVE_NONE;
+        }
+    }
+
+    int promotion = 0;
+    if(length == 5) {
+        promotion = rankFromLetter(text[4]);
+        if(promotion < 2 || promotion > 5) {
+            return MOVE_NONE;
+        }
+    }
+
+    int from = SQUARE(text[1] - '1', text[0] - 'a');
+    int to = SQUARE(text[3] - '1', text[2] - 'a');
+    if(from == to) {
+        return MOVE_NONE;
+    }
+    return MOVE_ENCODE(from, to, promotion);
+}
@@ -0,0 +1,25 @@
+/*
+File:           Notation.h
+Author:         Toni Lindeman
+Description:    Text notations for positions and moves (FEN, SAN and coordinate notation).
+*/
+
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include "Position.h"
+
+// Longest SAN move is e.g. "Qa1xb2=Q#" plus terminator, leave some room.
+#define SAN_MAX_LENGTH 16
+// Board (max 71) + side + castling + en passant + clocks.
+#define FEN_MAX_LENGTH 100
+
+int setPositionFromFen(struct position * pos, const char * fen);
+int setPositionFromFenStrict(struct position * pos, const char * fen);
+void writeFen(const struct position * pos, char * outFen);
+int moveToSan(struct position * pos, int move, char * outSan);
+int sanToMove(struct position * pos, const char * san, int length);
+void moveToCoordinate(int move, char * outText);
+int coordinateToMove(const char * text, int length);
+
+#endif /* NOTATION_H */
@@ -1,15 +1,88 @@
-/*
-File:           OSSpecific.c
-Author:         Toni Lindeman
-Description:    Contains system calls that may be OS specific. Check at least these if building for
-                a different system.
- */
-
-#include <stdlib.h>
-
-void clearConsole() {
-    // Call to clear console.
-    system("clear");
-}
-
-
+/*
+File:           OSSpecific.c
+Author:         Toni Lindeman
+Description:    Contains system calls that may be OS specific. Check at least these if building for
+                a different system.
+ */
+
+// mmap and clock_gettime are POSIX, not part of C11.
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+void clearConsole() {
+    // Call to clear console.
+    system("clear");
+}
+
+const char * mapFile(const char * fileName, size_t * outSize) {
+    // Map a whole file read-only into memory. Pages are loaded by the OS on first access, so even huge files
+    // "open" instantly.
+    // Returns NULL on failure. Empty files also return NULL, since they cannot be mapped.
+
+    *outSize = 0;
+
+    int fileDescriptor = open(fileName, O_RDONLY);
+    if(fileDescriptor == -1) {
+        return NULL;
+    }
+
+    struct stat fileInfo;
+    if(fstat(fileDescriptor, &fileInfo) == -1 || fileInfo.st_size == 0) {
+        close(fileDescriptor);
+        return NULL;
+    }
+
+    void * data = mmap(NULL, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+    // The mapping stays valid after closing the file.
+    close(fileDescriptor);
+
+    if(data == MAP_FAILED) {
+        return NULL;
+    }
+
+    *outSize = (size_t)fileInfo.st_size;
+    return (const char *)data;
+}
+
+void unmapFile(const char * data, size_t size) {
+    if(data) {
+        munmap((void *)data, size);
+    }
+}
+
+double getTimeSeconds() {
+    // Monotonic wall clock time in seconds, for measuring durations.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+void sleepSeconds(double seconds) {
+    // Sleep the calling thread, nanosleep may wake early on a signal which is fine for our uses.
+    struct timespec duration;
+    duration.tv_sec = (time_t)seconds;
+    duration.tv_nsec = (long)((seconds - (double)duration.tv_sec) * 1e9);
+    nanosleep(&duration, NULL);
+}
+
+int getCoreCount() {
+    // Number of online processor cores, at least 1.
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (int)count : 1;
+}
+
+int makeDirectory(const char * path) {
+    // Create a directory if it doesn't exist yet. Returns 0 on failure.
+    struct stat info;
+    if(stat(path, &info) == 0) {
+        return S_ISDIR(info.st_mode);
+    }
+    return mkdir(path, 0755) == 0;
+}
@@ -1,13 +1,21 @@
-/*
-File:           OSSpecific.h
-Author:         Toni Lindeman
-Description:    Contains system calls that may be OS specific. Check at least these if building for
-                a different system.
-*/
-
-#ifndef OSSPECIFIC_H
-#define OSSPECIFIC_H
-
-void clearConsole();
-
-#endif /* OSSPECIFIC_H */
+/*
+File:           OSSpecific.h
+Author:         Toni Lindeman
+Description:    Contains system calls that may be OS specific. Check at least these if building for
+                a different system.
+*/
+
+#ifndef OSSPECIFIC_H
+#define OSSPECIFIC_H
+
+#include <stddef.h>
+
+void clearConsole();
+const char * mapFile(const char * fileName, size_t * outSize);
+void unmapFile(const char * data, size_t size);
+double getTimeSeconds();
+void sleepSeconds(double seconds);
+int getCoreCount();
+int makeDirectory(const char * path);
+
+#endif /* OSSPECIFIC_H */
@@ -0,0 +1,411 @@
+/*
+File:           PGN.c
+Author:         Toni Lindeman
+Description:    Streaming PGN reader and PGN writer.
+
+The reader works directly on a memory mapped file. Tags are stored as pointers into the mapping and moves are
+resolved with the move generator as they are read, so reading a game does no heap allocation at all.
+Comments, NAGs and variations are skipped, only the main line is kept.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "OSSpecific.h"
+#include "MoveGen.h"
+#include "Notation.h"
+#include "PGN.h"
+
+// Writer wraps move text before this column.
+#define PGN_LINE_LENGTH 79
+
+// READER --------------------------------------------------------------------------------------------------------------
+int openPgnReader(struct pgnReader * reader, const char * fileName) {
+    reader->data = mapFile(fileName, &reader->size);
+    reader->offset = 0;
+
+    if(!reader->data) {
+        printf("Failed to open PGN file %s.\n", fileName);
+        return 0;
+    }
+    return 1;
+}
+
+void closePgnReader(struct pgnReader * reader) {
+    unmapFile(reader->data, reader->size);
+    reader->data = NULL;
+    reader->size = 0;
+}
+
+static int isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static int isDelimiter(char c) {
+    // Characters that end a move text token.
+    return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == '[' || c == ']' || c == ';';
+}
+
+static int isToken(const char * token, int length, const char * text) {
+    return (int)strlen(text) == length && !strncmp(token, text, (size_t)length);
+}
+
+static size_t skipLine(const char * data, size_t size, size_t i) {
+    while(i < size && data[i] != '\n') {
+        i++;
+    }
+    return i;
+}
+
+static size_t readTag(const char * data, size_t size, size_t i, struct pgnGame * game) {
+    // Reads '[Name "Value"]' starting at '['. Returns offset after the tag.
+    struct pgnTag tag = {NULL, 0, NULL, 0};
+
+    i++;
+    while(i < size && data[i] == ' ') {
+        i++;
+    }
+    tag.name = data + i;
+    while(i < size && !isSpace(data[i]) && data[i] != '"' && data[i] != ']') {
+        i++;
+    }
+    tag.nameLength = (int)(data + i - tag.name);
+
+    while(i < size && data[i] == ' ') {
+        i++;
+    }
+    if(i < size && data[i] == '"') {
+        i++;
+        tag.value = data + i;
+        while(i < size && data[i] != '"' && data[i] != '\n') {
+            // Skip escaped characters.
+            if(data[i] == '\\' && i + 1 < size) {
+                i++;
+            }
+            i++;
+        }
+        tag.valueLength = (int)(data + i - tag.value);
+    }
+
+    // Skip to the end of the tag.
+    while(i < size && data[i] != ']' && data[i] != '\n') {
+        i++;
+    }
+    if(i < size && data[i] == ']') {
+        i++;
+    }
+
+    // Tags beyond the limit are dropped, they are not needed for replaying the game.
+    if(game->tagCount < PGN_MAX_TAGS) {
+        game->tags[game->tagCount++] = tag;
+    }
+    return i;
+}
+
+static void setStartPosition(struct pgnGame * game) {
+    // Standard start unless the game has a FEN tag.
+    setInitialPosition(&game->start);
+
+    for(int i = 0; i < game->tagCount; i++) {
+        if(isToken(game->tags[i].name, game->tags[i].nameLength, "FEN")) {
+            // FEN parser wants a null terminated string.
+            char fen[FEN_MAX_LENGTH];
+            int length = game->tags[i].valueLength < FEN_MAX_LENGTH - 1 ? game->tags[i].valueLength :
+                         FEN_MAX_LENGTH - 1;
+            memcpy(fen, game->tags[i].value, (size_t)length);
+            fen[length] = '\0';
+
+            if(!setPositionFromFen(&game->start, fen)) {
+                game->errorPly = 0;
+            }
+        }
+    }
+}
+
+int readPgnGame(struct pgnReader * reader, struct pgnGame * outGame) {
+    // Reads the next game from the file into outGame.
+    // Returns 1 if a game was read (check errorPly for unresolved moves), 0 at the end of the file.
+
+    const char * data = reader->data;
+    size_t size = reader->size;
+    size_t i = reader->offset;
+    int hasContent = 0;
+
+    outGame->tagCount = 0;
+    outGame->moveCount = 0;
+    outGame->errorPly = -1;
+    strcpy(outGame->result, "*");
+
+    // Tag pair section
+    while(i < size) {
+        if(isSpace(data[i])) {
+            i++;
+        }
+        // Escape lines
+        else if(data[i] == '%') {
+            i = skipLine(data, size, i);
+        }
+        else if(data[i] == '[') {
+            i = readTag(data, size, i, outGame);
+            hasContent = 1;
+        }
+        else {
+            break;
+        }
+    }
+
+    setStartPosition(outGame);
+    struct position pos = outGame->start;
+    struct undoRecord undo;
+    int variationDepth = 0;
+
+    // Move text section, ends at the result or at the next game's tags.
+    while(i < size) {
+        char c = data[i];
+
+        if(isSpace(c)) {
+            i++;
+            continue;
+        }
+
+        // Comments
+        if(c == '{') {
+            while(i < size && data[i] != '}') {
+                i++;
+            }
+            if(i < size) {
+                i++;
+            }
+            continue;
+        }
+        if(c == ';' || (c == '%' && (i == 0 || data[i - 1] == '\n'))) {
+            i = skipLine(data, size, i);
+            continue;
+        }
+
+        // Variations, skipped since only the main line is kept.
+        if(c == '(') {
+            variationDepth++;
+            i++;
+            continue;
+        }
+        if(c == ')') {
+            if(variationDepth > 0) {
+                variationDepth--;
+            }
+            i++;
+            continue;
+        }
+
+        // Next game started without a result.
+        if(c == '[' && variationDepth == 0) {
+            break;
+        }
+
+        // Anything else is a token.
+        hasContent = 1;
+        const char * token = data + i;
+        while(i < size && !isDelimiter(data[i])) {
+            i++;
+        }
+        int length = (int)(data + i - token);
+
+        // A stray closing bracket or brace.
+        if(length == 0) {
+            i++;
+            continue;
+        }
+
+        // Game termination
+        if(isToken(token, length, "1-0") || isToken(token, length, "0-1") ||
+           isToken(token, length, "1/2-1/2") || isToken(token, length, "*")) {
+            if(variationDepth == 0) {
+                memcpy(outGame->result, token, (size_t)length);
+                outGame->result[length] = '\0';
+                break;
+            }
+            continue;
+        }
+
+        // NAG
+        if(token[0] == '$') {
+            continue;
+        }
+
+        // Move number, possibly glued to the move ("12.e4", "12...Nf6"). Digits not followed by a dot are castling
+        // written with zeros ("0-0", "12.0-0-0").
+        int digitCount = 0;
+        while(digitCount < length && token[digitCount] >= '0' && token[digitCount] <= '9') {
+            digitCount++;
+        }
+        if(digitCount == length || token[digitCount] == '.') {
+            token += digitCount;
+            length -= digitCount;
+        }
+        while(length > 0 && token[0] == '.') {
+            token++;
+            length--;
+        }
+
+        if(length == 0 || variationDepth > 0 || outGame->errorPly != -1) {
+            continue;
+        }
+
+        // Main line move
+        int move = MOVE_NONE;
+        if(outGame->moveCount < PGN_MAX_MOVES) {
+            move = sanToMove(&pos, token, length);
+        }
+        if(move == MOVE_NONE) {
+            outGame->errorPly = outGame->moveCount;
+            continue;
+        }
+        makeMove(&pos, move, &undo);
+        outGame->moves[outGame->moveCount++] = move;
+    }
+
+    reader->offset = i;
+    return hasContent;
+}
+
+// WRITER --------------------------------------------------------------------------------------------------------------
+void setPgnTag(struct pgnTag * tag, const char * name, const char * value) {
+    tag->name = name;
+    tag->nameLength = (int)strlen(name);
+    tag->value = value;
+    tag->valueLength = (int)strlen(value);
+}
+
+static int isInitialPosition(const struct position * pos) {
+    struct position initial;
+    setInitialPosition(&initial);
+
+    if(pos->turn != initial.turn) {
+        return 0;
+    }
+    for(int i = 0; i < 64; i++) {
+        if(pos->board[i].rank != initial.board[i].rank || pos->board[i].owner != initial.board[i].owner) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void writeMoveText(FILE * file, const char * text, int * lineLength) {
+    // Write a token, wrapping the line if it would get too long.
+    int length = (int)strlen(text);
+
+    if(*lineLength > 0 && *lineLength + 1 + length > PGN_LINE_LENGTH) {
+        fprintf(file, "\n");
+        *lineLength = 0;
+    }
+    if(*lineLength > 0) {
+        fprintf(file, " ");
+        (*lineLength)++;
+    }
+    fprintf(file, "%s", text);
+    *lineLength += length;
+}
+
+int writePgnGame(FILE * file, const struct pgnTag * tags, int tagCount, const struct position * start,
+                 const int * moves, int moveCount, const char * result) {
+    // Writes one game. SetUp and FEN tags are written from the start position, so they are ignored in tags.
+    // Moves must be legal, returns 0 if one is not.
+
+    struct position pos = *start;
+    struct undoRecord undo;
+
+    for(int i = 0; i < tagCount; i++) {
+        if(isToken(tags[i].name, tags[i].nameLength, "FEN") || isToken(tags[i].name, tags[i].nameLength, "SetUp")) {
+            continue;
+        }
+        fprintf(file, "[%.*s \"%.*s\"]\n", tags[i].nameLength, tags[i].name, tags[i].valueLength, tags[i].value);
+    }
+    if(!isInitialPosition(start)) {
+        char fen[FEN_MAX_LENGTH];
+        writeFen(start, fen);
+        fprintf(file, "[SetUp \"1\"]\n[FEN \"%s\"]\n", fen);
+    }
+    fprintf(file, "\n");
+
+    int lineLength = 0;
+    char text[SAN_MAX_LENGTH + 16];
+
+    for(int i = 0; i < moveCount; i++) {
+        if(!isLegalMove(&pos, moves[i])) {
+            printf("writePgnGame error: illegal move at ply %d.\n", i);
+            return 0;
+        }
+
+        // Move number before white moves, and before the first move if black starts. Numbering goes on from the
+        // FEN's move number.
+        if(pos.turn == 1) {
+            sprintf(text, "%d.", pos.fullmoveNumber);
+            writeMoveText(file, text, &lineLength);
+        }
+        else if(i == 0) {
+            sprintf(text, "%d...", pos.fullmoveNumber);
+            writeMoveText(file, text, &lineLength);
+        }
+
+        moveToSan(&pos, moves[i], text);
+        writeMoveText(file, text, &lineLength);
+        makeMove(&pos, moves[i], &undo);
+    }
+
+    writeMoveText(file, result, &lineLength);
+    fprintf(file, "\n\n");
+
+    return 1;
+}
+
+// BULK PROCESSING -----------------------------------------------------------------------------------------------------
+int runPgnStats(const char * inFileName, const char * outFileName) {
+    // Read every game of a PGN file and report reading speed.
+    // If outFileName is given, games that were read without errors are written there.
+
+    struct pgnReader reader;
+    if(!openPgnReader(&reader, inFileName)) {
+        return 0;
+    }
+
+    FILE * outFile = NULL;
+    if(outFileName) {
+        outFile = fopen(outFileName, "w");
+        if(!outFile) {
+            printf("Failed to open %s for writing.\n", outFileName);
+            closePgnReader(&reader);
+            return 0;
+        }
+    }
+
+    // pgnGame is a few kilobytes, keep it off the stack.
+    static struct pgnGame game;
+    long gameCount = 0;
+    long errorCount = 0;
+    long plyCount = 0;
+    double startTime = getTimeSeconds();
+
+    while(readPgnGame(&reader, &game)) {
+        gameCount++;
+        plyCount += game.moveCount;
+
+        if(game.errorPly != -1) {
+            errorCount++;
+        }
+        else if(outFile) {
+            writePgnGame(outFile, game.tags, game.tagCount, &game.start, game.moves, game.moveCount, game.result);
+        }
+    }
+
+    double seconds = getTimeSeconds() - startTime;
+
+    printf("Games: %ld (%ld could not be read), plies: %ld\n", gameCount, errorCount, plyCount);
+    printf("Time: %.3f s, %.0f games/second\n", seconds, seconds > 0 ? gameCount / seconds : 0.0);
+
+    if(outFile) {
+        fclose(outFile);
+    }
+    closePgnReader(&reader);
+
+    return 1;
+}
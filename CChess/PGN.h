@@ -0,0 +1,51 @@
+/*
+File:           PGN.h
+Author:         Toni Lindeman
+Description:    Streaming PGN reader and PGN writer.
+*/
+
+#ifndef PGN_H
+#define PGN_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "Position.h"
+
+#define PGN_MAX_TAGS 32
+#define PGN_MAX_MOVES 1024
+#define FILE_PGN_EXPORT "games.pgn"
+
+struct pgnReader {
+    const char * data;
+    size_t size;
+    size_t offset;
+};
+
+// Tags point into the mapped file (or to string literals), they are not null terminated.
+struct pgnTag {
+    const char * name;
+    int nameLength;
+    const char * value;
+    int valueLength;
+};
+
+struct pgnGame {
+    struct pgnTag tags[PGN_MAX_TAGS];
+    int tagCount;
+    struct position start;
+    int moves[PGN_MAX_MOVES];
+    int moveCount;
+    char result[8];
+    // -1 if all moves were resolved, else the ply where reading the game failed.
+    int errorPly;
+};
+
+int openPgnReader(struct pgnReader * reader, const char * fileName);
+void closePgnReader(struct pgnReader * reader);
+int readPgnGame(struct pgnReader * reader, struct pgnGame * outGame);
+void setPgnTag(struct pgnTag * tag, const char * name, const char * value);
+int writePgnGame(FILE * file, const struct pgnTag * tags, int tagCount, const struct position * start,
+                 const int * moves, int moveCount, const char * result);
+int runPgnStats(const char * inFileName, const char * outFileName);
+
+#endif /* PGN_H */
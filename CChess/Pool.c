@@ -0,0 +1,291 @@
+/*
+File:           Pool.c
+Author:         Toni Lindeman
+Description:    Fixed size object pools for boards and game sessions, with per-thread caches.
+
+A pool hands out objects of one size. Memory is taken from malloc a slab (many objects) at a time and is never
+given back, so once a pool has grown to its working size acquiring and releasing objects doesn't touch the
+general allocator at all, and the heap doesn't get fragmented by thousands of small board allocations.
+
+Free objects are kept in singly linked lists through their first bytes. Each thread has its own cache list per
+pool and only goes to the pool's shared list, under its lock, to fetch or return POOL_CACHE_BATCH objects at a
+time. Acquire and release are O(1) and usually take no lock. When a thread exits its cached objects go back to
+the pool.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "Pool.h"
+
+// Keeps the objects after the slab header 16 byte aligned.
+#define POOL_SLAB_HEADER 16
+
+// Free objects one thread holds for each pool.
+struct poolThreadCache {
+    void * head[POOL_MAX_POOLS];
+    // Only written by the owning thread, atomic so printPoolStats can read them.
+    atomic_int count[POOL_MAX_POOLS];
+    struct objectPool * pools[POOL_MAX_POOLS];
+    struct poolThreadCache * previous;
+    struct poolThreadCache * next;
+};
+
+static _Thread_local struct poolThreadCache * poolThreadCache = NULL;
+
+// Pools and thread caches, for statistics and for cleaning up after threads.
+static pthread_mutex_t poolRegistryLock = PTHREAD_MUTEX_INITIALIZER;
+static struct objectPool * poolList = NULL;
+static struct poolThreadCache * poolThreadCaches = NULL;
+static pthread_once_t poolKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t poolThreadKey;
+
+// SHARED FREE LIST ----------------------------------------------------------------------------------------------------
+static int addSlab(struct objectPool * pool) {
+    // Pool lock must be held. Returns 0 if malloc fails.
+    char * slab = (char *) malloc(POOL_SLAB_HEADER + (pool->objectSize * (size_t) pool->objectsPerSlab));
+    if(!slab) {
+        return 0;
+    }
+    *(void **) slab = pool->slabs;
+    pool->slabs = slab;
+    pool->slabCount++;
+    pool->capacity += pool->objectsPerSlab;
+
+    // Push the new objects last to first, so they are handed out in address order.
+    for(int i = pool->objectsPerSlab - 1; i >= 0; i--) {
+        void * object = slab + POOL_SLAB_HEADER + (pool->objectSize * (size_t) i);
+        *(void **) object = pool->freeList;
+        pool->freeList = object;
+    }
+    pool->freeCount += pool->objectsPerSlab;
+    return 1;
+}
+
+static void returnObjects(struct objectPool * pool, struct poolThreadCache * cache, int count) {
+    // Move count objects from the thread's cache back to the shared list.
+    pthread_mutex_lock(&pool->lock);
+    for(int i = 0; i < count; i++) {
+        void * object = cache->head[pool->id];
+        cache->head[pool->id] = *(void **) object;
+        *(void **) object = pool->freeList;
+        pool->freeList = object;
+    }
+    pool->freeCount += count;
+    pool->outstanding -= count;
+    pthread_mutex_unlock(&pool->lock);
+
+    int cached = atomic_load_explicit(&cache->count[pool->id], memory_order_relaxed);
+    atomic_store_explicit(&cache->count[pool->id], cached - count, memory_order_relaxed);
+}
+
+static int fetchObjects(struct objectPool * pool, struct poolThreadCache * cache) {
+    // Fill an empty thread cache with a batch from the shared list. Returns 0 if out of memory.
+    int count = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    if(pool->freeCount < POOL_CACHE_BATCH) {
+        addSlab(pool);
+    }
+    while(count < POOL_CACHE_BATCH && pool->freeList) {
+        void * object = pool->freeList;
+        pool->freeList = *(void **) object;
+        *(void **) object = cache->head[pool->id];
+        cache->head[pool->id] = object;
+        count++;
+    }
+    pool->freeCount -= count;
+    pool->outstanding += count;
+    if(pool->outstanding > pool->peakOutstanding) {
+        pool->peakOutstanding = pool->outstanding;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    atomic_store_explicit(&cache->count[pool->id], count, memory_order_relaxed);
+    cache->pools[pool->id] = pool;
+    return count > 0;
+}
+
+// THREAD CACHES -------------------------------------------------------------------------------------------------------
+static void releaseThreadCache(void * pointer) {
+    // Thread exit: give every cached object back and forget the cache.
+    struct poolThreadCache * cache = (struct poolThreadCache *) pointer;
+
+    for(int id = 0; id < POOL_MAX_POOLS; id++) {
+        if(cache->pools[id]) {
+            returnObjects(cache->pools[id], cache, atomic_load_explicit(&cache->count[id], memory_order_relaxed));
+        }
+    }
+
+    pthread_mutex_lock(&poolRegistryLock);
+    if(cache->previous) {
+        cache->previous->next = cache->next;
+    }
+    else {
+        poolThreadCaches = cache->next;
+    }
+    if(cache->next) {
+        cache->next->previous = cache->previous;
+    }
+    pthread_mutex_unlock(&poolRegistryLock);
+
+    free(cache);
+    poolThreadCache = NULL;
+}
+
+static void makePoolThreadKey() {
+    pthread_key_create(&poolThreadKey, releaseThreadCache);
+}
+
+static struct poolThreadCache * registerPoolThread() {
+    // Called on the first pool use of every thread. Returns NULL if out of memory.
+    struct poolThreadCache * cache = (struct poolThreadCache *) calloc(1, sizeof(struct poolThreadCache));
+    if(!cache) {
+        return NULL;
+    }
+
+    pthread_once(&poolKeyOnce, makePoolThreadKey);
+    pthread_setspecific(poolThreadKey, cache);
+
+    pthread_mutex_lock(&poolRegistryLock);
+    cache->next = poolThreadCaches;
+    if(poolThreadCaches) {
+        poolThreadCaches->previous = cache;
+    }
+    poolThreadCaches = cache;
+    pthread_mutex_unlock(&poolRegistryLock);
+
+    poolThreadCache = cache;
+    return cache;
+}
+
+static void registerPool(struct objectPool * pool) {
+    pthread_mutex_lock(&poolRegistryLock);
+    if(!atomic_load(&pool->registered)) {
+        pool->nextPool = poolList;
+        poolList = pool;
+        atomic_store(&pool->registered, 1);
+    }
+    pthread_mutex_unlock(&poolRegistryLock);
+}
+
+// PUBLIC FUNCTIONS ----------------------------------------------------------------------------------------------------
+void * acquirePoolObject(struct objectPool * pool) {
+    // Get an object, contents undefined. Returns NULL if out of memory.
+    struct poolThreadCache * cache = poolThreadCache ? poolThreadCache : registerPoolThread();
+    if(!cache) {
+        return NULL;
+    }
+
+    int id = pool->id;
+    if(!cache->head[id]) {
+        if(!atomic_load_explicit(&pool->registered, memory_order_relaxed)) {
+            registerPool(pool);
+        }
+        if(!fetchObjects(pool, cache)) {
+            return NULL;
+        }
+    }
+
+    void * object = cache->head[id];
+    cache->head[id] = *(void **) object;
+    int cached = atomic_load_explicit(&cache->count[id], memory_order_relaxed);
+    atomic_store_explicit(&cache->count[id], cached - 1, memory_order_relaxed);
+    return object;
+}
+
+void releasePoolObject(struct objectPool * pool, void * object) {
+    // Give an object back to the pool. Any thread may release any object, NULL is ignored.
+    if(!object) {
+        return;
+    }
+
+    struct poolThreadCache * cache = poolThreadCache ? poolThreadCache : registerPoolThread();
+    if(!cache) {
+        // Can't cache it, hand it straight to the shared list.
+        pthread_mutex_lock(&pool->lock);
+        *(void **) object = pool->freeList;
+        pool->freeList = object;
+        pool->freeCount++;
+        pool->outstanding--;
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+
+    int id = pool->id;
+    *(void **) object = cache->head[id];
+    cache->head[id] = object;
+    cache->pools[id] = pool;
+    int cached = atomic_load_explicit(&cache->count[id], memory_order_relaxed) + 1;
+    atomic_store_explicit(&cache->count[id], cached, memory_order_relaxed);
+
+    // Don't let one thread hoard what another thread may be allocating.
+    if(cached > 2 * POOL_CACHE_BATCH) {
+        returnObjects(pool, cache, POOL_CACHE_BATCH);
+    }
+}
+
+int reservePoolObjects(struct objectPool * pool, long count) {
+    // Grow the pool to at least count objects up front. Returns 0 if out of memory.
+    int success = 1;
+
+    if(!atomic_load(&pool->registered)) {
+        registerPool(pool);
+    }
+    pthread_mutex_lock(&pool->lock);
+    while(pool->capacity < count && success) {
+        success = addSlab(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return success;
+}
+
+void getPoolStats(struct objectPool * pool, struct poolStats * outStats) {
+    // Occupancy right now. Cached counts of other threads may be a moment behind.
+    long cached = 0;
+
+    pthread_mutex_lock(&poolRegistryLock);
+    for(struct poolThreadCache * cache = poolThreadCaches; cache; cache = cache->next) {
+        cached += atomic_load_explicit(&cache->count[pool->id], memory_order_relaxed);
+    }
+    pthread_mutex_lock(&pool->lock);
+    outStats->name = pool->name;
+    outStats->objectSize = pool->objectSize;
+    outStats->slabs = pool->slabCount;
+    outStats->capacity = pool->capacity;
+    outStats->inUse = pool->outstanding - cached;
+    outStats->cached = cached;
+    outStats->peakOutstanding = pool->peakOutstanding;
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&poolRegistryLock);
+}
+
+int getAllPoolStats(struct poolStats * outStats, int maxCount) {
+    // Stats of every pool that has been used. Returns the number of pools.
+    pthread_mutex_lock(&poolRegistryLock);
+    struct objectPool * pools[POOL_MAX_POOLS];
+    int poolCount = 0;
+    for(struct objectPool * pool = poolList; pool && poolCount < POOL_MAX_POOLS; pool = pool->nextPool) {
+        pools[poolCount++] = pool;
+    }
+    pthread_mutex_unlock(&poolRegistryLock);
+
+    if(poolCount > maxCount) {
+        poolCount = maxCount;
+    }
+    for(int i = 0; i < poolCount; i++) {
+        getPoolStats(pools[i], &outStats[i]);
+    }
+    return poolCount;
+}
+
+void printPoolStats(FILE * file) {
+    struct poolStats stats[POOL_MAX_POOLS];
+    int poolCount = getAllPoolStats(stats, POOL_MAX_POOLS);
+
+    fprintf(file, "%-14s %8s %8s %10s %10s %10s %10s\n", "Pool", "Size", "Slabs", "Capacity", "In use", "Cached",
+            "Peak");
+    for(int i = 0; i < poolCount; i++) {
+        fprintf(file, "%-14s %8zu %8ld %10ld %10ld %10ld %10ld\n", stats[i].name, stats[i].objectSize, stats[i].slabs,
+                stats[i].capacity, stats[i].inUse, stats[i].cached, stats[i].peakOutstanding);
+    }
+}
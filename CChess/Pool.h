@@ -0,0 +1,67 @@
+/*
+File:           Pool.h
+Author:         Toni Lindeman
+Description:    Fixed size object pools for boards and game sessions, with per-thread caches.
+*/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Every pool has its own id, it indexes the per-thread caches.
+#define POOL_ID_BOARDS 0
+#define POOL_ID_SESSIONS 1
+#define POOL_ID_MOVE_RECORDS 2
+#define POOL_MAX_POOLS 8
+
+// Objects moved between a thread's cache and the shared free list at a time.
+#define POOL_CACHE_BATCH 32
+
+struct objectPool {
+    const char * name;
+    int id;
+    size_t objectSize;
+    int objectsPerSlab;
+    // Everything below is guarded by lock.
+    pthread_mutex_t lock;
+    void * freeList;
+    long freeCount;
+    void * slabs;
+    long slabCount;
+    long capacity;
+    // Objects handed to threads, in use or sitting in a thread's cache.
+    long outstanding;
+    long peakOutstanding;
+    // Set once the pool is in the list printPoolStats goes through.
+    atomic_int registered;
+    struct objectPool * nextPool;
+};
+
+// objectSize is rounded up to keep objects 16 byte aligned.
+#define POOL_INITIALIZER(name, id, objectSize, objectsPerSlab) \
+    {(name), (id), (((objectSize) + 15) & ~(size_t)15), (objectsPerSlab), PTHREAD_MUTEX_INITIALIZER, NULL, 0, NULL, 0, \
+     0, 0, 0, 0, NULL}
+
+struct poolStats {
+    const char * name;
+    size_t objectSize;
+    long slabs;
+    long capacity;
+    long inUse;
+    // Free objects in thread caches
+    long cached;
+    long peakOutstanding;
+};
+
+void * acquirePoolObject(struct objectPool * pool);
+void releasePoolObject(struct objectPool * pool, void * object);
+int reservePoolObjects(struct objectPool * pool, long count);
+void getPoolStats(struct objectPool * pool, struct poolStats * outStats);
+int getAllPoolStats(struct poolStats * outStats, int maxCount);
+void printPoolStats(FILE * file);
+
+#endif /* POOL_H */
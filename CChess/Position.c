@@ -0,0 +1,597 @@
+/*
+File:           Position.c
+Author:         Toni Lindeman
+Description:    Compact position state and fast make / unmake of encoded moves.
+
+Position definition:
+A position is a chessboard (same layout as in Chessboard.c) plus the player whose turn it is, the castling rights
+and the en passant square. Unlike validateAndMakeMove, the functions here never print or prompt, so they are safe
+to call in tight loops.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "Zobrist.h"
+#include "Position.h"
+
+// Knight and king jump offsets as (row, column) pairs.
+static const int knightJumps[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+static const int kingSteps[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+// Castling rights that stay after a move from or to the square. Moving the king or a rook, or capturing a rook on
+// its starting square, loses the right for good.
+static const int castlingMasks[64] = {
+    CASTLING_ALL & ~CASTLING_PLAYER1_LONG, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL & ~(CASTLING_PLAYER1_SHORT | CASTLING_PLAYER1_LONG), CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL & ~CASTLING_PLAYER1_SHORT,
+    CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL & ~CASTLING_PLAYER2_LONG, CASTLING_ALL, CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL & ~(CASTLING_PLAYER2_SHORT | CASTLING_PLAYER2_LONG), CASTLING_ALL, CASTLING_ALL,
+    CASTLING_ALL & ~CASTLING_PLAYER2_SHORT
+};
+
+void setPositionFromChessboard(struct position * pos, struct chessPiece * chessboard, int turn) {
+    // Copy a game chessboard into a position. A chessboard doesn't remember if kings and rooks have moved, so
+    // castling is allowed if they stand on their starting squares.
+    for(int i = 0; i < 64; i++) {
+        pos->board[i] = chessboard[i];
+    }
+    pos->turn = turn;
+    pos->halfmoveClock = 0;
+    pos->fullmoveNumber = 1;
+    pos->castlingRights = inferCastlingRights(pos);
+    pos->enPassantSquare = NO_SQUARE;
+    pos->key = computePositionKey(pos);
+    pos->pawnKey = computePawnKey(pos);
+    computePieceCounts(pos);
+}
+
+void setInitialPosition(struct position * pos) {
+    // Standard setup, same as getInitChessboard but without allocating.
+    static const int backRank[8] = {2, 3, 4, 5, 6, 4, 3, 2};
+
+    for(int i = 0; i < 64; i++) {
+        pos->board[i].rank = 0;
+        pos->board[i].owner = 0;
+    }
+    for(int column = 0; column < 8; column++) {
+        pos->board[SQUARE(0, column)].rank = backRank[column];
+        pos->board[SQUARE(0, column)].owner = 1;
+        pos->board[SQUARE(1, column)].rank = 1;
+        pos->board[SQUARE(1, column)].owner = 1;
+        pos->board[SQUARE(6, column)].rank = 1;
+        pos->board[SQUARE(6, column)].owner = 2;
+        pos->board[SQUARE(7, column)].rank = backRank[column];
+        pos->board[SQUARE(7, column)].owner = 2;
+    }
+    pos->turn = 1;
+    pos->halfmoveClock = 0;
+    pos->fullmoveNumber = 1;
+    pos->castlingRights = CASTLING_ALL;
+    pos->enPassantSquare = NO_SQUARE;
+    pos->key = computePositionKey(pos);
+    pos->pawnKey = computePawnKey(pos);
+    computePieceCounts(pos);
+}
+
+uint64_t computePositionKey(const struct position * pos) {
+    // Full key computation. Only needed when a position is set up, moves update the key incrementally.
+    uint64_t key = 0;
+
+    for(int square = 0; square < 64; square++) {
+        if(pos->board[square].rank != 0) {
+            key ^= zobristPieceKeys[pos->board[square].owner - 1][pos->board[square].rank - 1][square];
+        }
+    }
+    if(pos->turn == 2) {
+        key ^= zobristTurnKey;
+    }
+    key ^= zobristCastlingKeys[pos->castlingRights];
+    if(pos->enPassantSquare != NO_SQUARE) {
+        key ^= zobristEnPassantKeys[SQUARE_COLUMN(pos->enPassantSquare)];
+    }
+    return key;
+}
+
+uint64_t computePawnKey(const struct position * pos) {
+    // Key of the pawns only, 0 if there are none.
+    uint64_t key = 0;
+
+    for(int square = 0; square < 64; square++) {
+        if(pos->board[square].rank == 1) {
+            key ^= zobristPieceKeys[pos->board[square].owner - 1][0][square];
+        }
+    }
+    return key;
+}
+
+void computePieceCounts(struct position * pos) {
+    // Full count, material key, piece lists and king squares. Like the keys only needed when a position is set up.
+    memset(pos->pieceCounts, 0, sizeof(pos->pieceCounts));
+    pos->materialKey = 0;
+    pos->pieceListCount[1] = 0;
+    pos->pieceListCount[2] = 0;
+    pos->kingSquares[1] = NO_SQUARE;
+    pos->kingSquares[2] = NO_SQUARE;
+    for(int square = 0; square < 64; square++) {
+        struct chessPiece piece = pos->board[square];
+        if(piece.rank != 0) {
+            pos->pieceCounts[piece.owner][piece.rank]++;
+            pos->materialKey += MATERIAL_ONE(piece.owner, piece.rank);
+            pos->pieceListIndex[square] = (unsigned char)pos->pieceListCount[piece.owner];
+            pos->pieceSquares[piece.owner][pos->pieceListCount[piece.owner]++] = (unsigned char)square;
+            if(piece.rank == 6) {
+                pos->kingSquares[piece.owner] = square;
+            }
+        }
+    }
+}
+
+int countPromotedPieces(const int * counts) {
+    // Pieces of one player (counts indexed by rank) above the starting set. They can only be promoted pawns, so
+    // pawns and promoted pieces together are at most 8 in a legal position.
+    int promoted = (counts[5] > 1) ? counts[5] - 1 : 0;
+    for(int rank = 2; rank <= 4; rank++) {
+        promoted += (counts[rank] > 2) ? counts[rank] - 2 : 0;
+    }
+    return promoted;
+}
+
+// PIECE LISTS ---------------------------------------------------------------------------------------------------------
+static void addListedPiece(struct position * pos, int owner, int square) {
+    pos->pieceListIndex[square] = (unsigned char)pos->pieceListCount[owner];
+    pos->pieceSquares[owner][pos->pieceListCount[owner]++] = (unsigned char)square;
+}
+
+static int removeListedPiece(struct position * pos, int owner, int square) {
+    // The last piece of the list takes the removed one's place. Returns that place.
+    int index = pos->pieceListIndex[square];
+    int last = pos->pieceSquares[owner][--pos->pieceListCount[owner]];
+    pos->pieceSquares[owner][index] = (unsigned char)last;
+    pos->pieceListIndex[last] = (unsigned char)index;
+    return index;
+}
+
+static void restoreListedPiece(struct position * pos, int owner, int square, int index) {
+    // Undo removeListedPiece: the piece that took the place goes back to the end.
+    int moved = pos->pieceSquares[owner][index];
+    pos->pieceSquares[owner][pos->pieceListCount[owner]] = (unsigned char)moved;
+    pos->pieceListIndex[moved] = (unsigned char)pos->pieceListCount[owner];
+    pos->pieceListCount[owner]++;
+    pos->pieceSquares[owner][index] = (unsigned char)square;
+    pos->pieceListIndex[square] = (unsigned char)index;
+}
+
+static void moveListedPiece(struct position * pos, int owner, int from, int to) {
+    int index = pos->pieceListIndex[from];
+    pos->pieceSquares[owner][index] = (unsigned char)to;
+    pos->pieceListIndex[to] = (unsigned char)index;
+}
+
+void placePiece(struct position * pos, int square, struct chessPiece piece) {
+    // Put piece on square, or empty it with rank 0, replacing whatever was there. For editors: keys, counts and piece
+    // lists stay up to date, castling rights and the en passant square are left as they are.
+    struct chessPiece old = pos->board[square];
+
+    if(old.rank != 0) {
+        pos->key ^= zobristPieceKeys[old.owner - 1][old.rank - 1][square];
+        if(old.rank == 1) {
+            pos->pawnKey ^= zobristPieceKeys[old.owner - 1][0][square];
+        }
+        pos->pieceCounts[old.owner][old.rank]--;
+        pos->materialKey -= MATERIAL_ONE(old.owner, old.rank);
+        removeListedPiece(pos, old.owner, square);
+        if(old.rank == 6 && pos->kingSquares[old.owner] == square) {
+            pos->kingSquares[old.owner] = NO_SQUARE;
+        }
+    }
+
+    pos->board[square] = piece;
+    if(piece.rank == 0) {
+        pos->board[square].owner = 0;
+        return;
+    }
+    pos->key ^= zobristPieceKeys[piece.owner - 1][piece.rank - 1][square];
+    if(piece.rank == 1) {
+        pos->pawnKey ^= zobristPieceKeys[piece.owner - 1][0][square];
+    }
+    pos->pieceCounts[piece.owner][piece.rank]++;
+    pos->materialKey += MATERIAL_ONE(piece.owner, piece.rank);
+    addListedPiece(pos, piece.owner, square);
+    if(piece.rank == 6) {
+        pos->kingSquares[piece.owner] = square;
+    }
+}
+
+int inferCastlingRights(const struct position * pos) {
+    // Every right whose king and rook stand on their starting squares.
+    static const int rights[4] = {CASTLING_PLAYER1_SHORT, CASTLING_PLAYER1_LONG, CASTLING_PLAYER2_SHORT,
+                                  CASTLING_PLAYER2_LONG};
+    int castlingRights = 0;
+
+    for(int i = 0; i < 4; i++) {
+        int player = (i < 2) ? 1 : 2;
+        int row = (player == 1) ? 0 : 7;
+        struct chessPiece king = pos->board[SQUARE(row, 4)];
+        struct chessPiece rook = pos->board[SQUARE(row, (i % 2) ? 0 : 7)];
+        if(king.rank == 6 && king.owner == player && rook.rank == 2 && rook.owner == player) {
+            castlingRights |= rights[i];
+        }
+    }
+    return castlingRights;
+}
+
+void getCastlingRookMove(int move, int * outFrom, int * outTo) {
+    // The rook's part of a castling move: h column to f column, or a column to d column.
+    int row = SQUARE_ROW(MOVE_TO(move));
+    if(SQUARE_COLUMN(MOVE_TO(move)) == 6) {
+        *outFrom = SQUARE(row, 7);
+        *outTo = SQUARE(row, 5);
+    }
+    else {
+        *outFrom = SQUARE(row, 0);
+        *outTo = SQUARE(row, 3);
+    }
+}
+
+static int canCaptureEnPassant(const struct position * pos, int to, int player) {
+    // Is there a pawn of player next to a pawn that just moved two steps to square to.
+    int row = SQUARE_ROW(to);
+    int column = SQUARE_COLUMN(to);
+    for(int side = -1; side <= 1; side += 2) {
+        if(column + side >= 0 && column + side <= 7) {
+            struct chessPiece piece = pos->board[SQUARE(row, column + side)];
+            if(piece.rank == 1 && piece.owner == player) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+void makeMove(struct position * pos, int move, struct undoRecord * undo) {
+    // Make a move that is known to be pseudo-legal. No validation is done here.
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    // Only different from to for en passant.
+    int capturedSquare = MOVE_IS_EN_PASSANT(move) ? EN_PASSANT_CAPTURE_SQUARE(move) : to;
+
+    undo->moved = pos->board[from];
+    undo->captured = pos->board[capturedSquare];
+    undo->key = pos->key;
+    undo->pawnKey = pos->pawnKey;
+    undo->materialKey = pos->materialKey;
+    undo->halfmoveClock = pos->halfmoveClock;
+    undo->castlingRights = pos->castlingRights;
+    undo->enPassantSquare = pos->enPassantSquare;
+
+    // Piece lists: the captured piece leaves its list before the moving piece takes over its square.
+    if(undo->captured.rank != 0) {
+        undo->capturedListIndex = removeListedPiece(pos, undo->captured.owner, capturedSquare);
+    }
+    moveListedPiece(pos, undo->moved.owner, from, to);
+    if(undo->moved.rank == 6) {
+        pos->kingSquares[undo->moved.owner] = to;
+    }
+
+    pos->board[capturedSquare].rank = 0;
+    pos->board[capturedSquare].owner = 0;
+    pos->board[to] = pos->board[from];
+    if(MOVE_PROMOTION(move)) {
+        pos->board[to].rank = MOVE_PROMOTION(move);
+    }
+    pos->board[from].rank = 0;
+    pos->board[from].owner = 0;
+
+    // Update key: moving piece off from, captured piece off its square, (possibly promoted) piece on to.
+    pos->key ^= zobristPieceKeys[undo->moved.owner - 1][undo->moved.rank - 1][from];
+    if(undo->captured.rank != 0) {
+        pos->key ^= zobristPieceKeys[undo->captured.owner - 1][undo->captured.rank - 1][capturedSquare];
+    }
+    pos->key ^= zobristPieceKeys[pos->board[to].owner - 1][pos->board[to].rank - 1][to];
+    pos->key ^= zobristTurnKey;
+
+    // The rook's part of castling.
+    if(MOVE_IS_CASTLING(move)) {
+        int rookFrom;
+        int rookTo;
+        getCastlingRookMove(move, &rookFrom, &rookTo);
+        pos->board[rookTo] = pos->board[rookFrom];
+        pos->board[rookFrom].rank = 0;
+        pos->board[rookFrom].owner = 0;
+        moveListedPiece(pos, undo->moved.owner, rookFrom, rookTo);
+        pos->key ^= zobristPieceKeys[undo->moved.owner - 1][1][rookFrom];
+        pos->key ^= zobristPieceKeys[undo->moved.owner - 1][1][rookTo];
+    }
+
+    // Castling rights and en passant square
+    pos->castlingRights &= castlingMasks[from] & castlingMasks[to];
+    pos->enPassantSquare = NO_SQUARE;
+    if(undo->moved.rank == 1 && abs(to - from) == 16 && canCaptureEnPassant(pos, to, (pos->turn % 2) + 1)) {
+        pos->enPassantSquare = (from + to) / 2;
+    }
+    if(pos->castlingRights != undo->castlingRights) {
+        pos->key ^= zobristCastlingKeys[undo->castlingRights] ^ zobristCastlingKeys[pos->castlingRights];
+    }
+    if(undo->enPassantSquare != NO_SQUARE) {
+        pos->key ^= zobristEnPassantKeys[SQUARE_COLUMN(undo->enPassantSquare)];
+    }
+    if(pos->enPassantSquare != NO_SQUARE) {
+        pos->key ^= zobristEnPassantKeys[SQUARE_COLUMN(pos->enPassantSquare)];
+    }
+
+    // Pawn key: only pawn moves, pawn captures and promotions change it.
+    if(undo->moved.rank == 1) {
+        pos->pawnKey ^= zobristPieceKeys[undo->moved.owner - 1][0][from];
+        if(pos->board[to].rank == 1) {
+            pos->pawnKey ^= zobristPieceKeys[undo->moved.owner - 1][0][to];
+        }
+    }
+    if(undo->captured.rank == 1) {
+        pos->pawnKey ^= zobristPieceKeys[undo->captured.owner - 1][0][capturedSquare];
+    }
+
+    // Counts and material key: captured piece gone, promoted pawn changes rank.
+    if(undo->captured.rank != 0) {
+        pos->pieceCounts[undo->captured.owner][undo->captured.rank]--;
+        pos->materialKey -= MATERIAL_ONE(undo->captured.owner, undo->captured.rank);
+    }
+    if(MOVE_PROMOTION(move)) {
+        pos->pieceCounts[undo->moved.owner][1]--;
+        pos->pieceCounts[undo->moved.owner][MOVE_PROMOTION(move)]++;
+        pos->materialKey += MATERIAL_ONE(undo->moved.owner, MOVE_PROMOTION(move)) - MATERIAL_ONE(undo->moved.owner, 1);
+    }
+
+    // Captures and pawn moves can't be undone in a game, so they reset the clock.
+    pos->halfmoveClock = (undo->captured.rank != 0 || undo->moved.rank == 1) ? 0 : pos->halfmoveClock + 1;
+    if(pos->turn == 2) {
+        pos->fullmoveNumber++;
+    }
+
+    pos->turn = (pos->turn % 2) + 1;
+}
+
+void unmakeMove(struct position * pos, int move, struct undoRecord * undo) {
+    // Take back a move made with makeMove.
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+
+    pos->board[from] = undo->moved;
+    if(MOVE_IS_EN_PASSANT(move)) {
+        pos->board[to].rank = 0;
+        pos->board[to].owner = 0;
+        pos->board[EN_PASSANT_CAPTURE_SQUARE(move)] = undo->captured;
+    }
+    else {
+        pos->board[to] = undo->captured;
+    }
+    if(MOVE_IS_CASTLING(move)) {
+        int rookFrom;
+        int rookTo;
+        getCastlingRookMove(move, &rookFrom, &rookTo);
+        pos->board[rookFrom] = pos->board[rookTo];
+        pos->board[rookTo].rank = 0;
+        pos->board[rookTo].owner = 0;
+        moveListedPiece(pos, undo->moved.owner, rookTo, rookFrom);
+    }
+
+    // Piece lists back in the same order as before the move.
+    moveListedPiece(pos, undo->moved.owner, to, from);
+    if(undo->moved.rank == 6) {
+        pos->kingSquares[undo->moved.owner] = from;
+    }
+    if(undo->captured.rank != 0) {
+        restoreListedPiece(pos, undo->captured.owner, MOVE_IS_EN_PASSANT(move) ? EN_PASSANT_CAPTURE_SQUARE(move) : to,
+                           undo->capturedListIndex);
+    }
+
+    pos->key = undo->key;
+    pos->pawnKey = undo->pawnKey;
+    pos->materialKey = undo->materialKey;
+    pos->halfmoveClock = undo->halfmoveClock;
+    pos->castlingRights = undo->castlingRights;
+    pos->enPassantSquare = undo->enPassantSquare;
+
+    if(undo->captured.rank != 0) {
+        pos->pieceCounts[undo->captured.owner][undo->captured.rank]++;
+    }
+    if(MOVE_PROMOTION(move)) {
+        pos->pieceCounts[undo->moved.owner][1]++;
+        pos->pieceCounts[undo->moved.owner][MOVE_PROMOTION(move)]--;
+    }
+
+    pos->turn = (pos->turn % 2) + 1;
+    if(pos->turn == 2) {
+        pos->fullmoveNumber--;
+    }
+}
+
+void makeNullMove(struct position * pos, struct undoRecord * undo) {
+    // Pass the turn without moving. Used by search pruning, never legal in a game.
+    // Repetitions through a null move aren't real, so it resets the clock like an irreversible move. The en passant
+    // chance is gone after it.
+    undo->key = pos->key;
+    undo->halfmoveClock = pos->halfmoveClock;
+    undo->enPassantSquare = pos->enPassantSquare;
+    pos->key ^= zobristTurnKey;
+    if(pos->enPassantSquare != NO_SQUARE) {
+        pos->key ^= zobristEnPassantKeys[SQUARE_COLUMN(pos->enPassantSquare)];
+        pos->enPassantSquare = NO_SQUARE;
+    }
+    pos->halfmoveClock = 0;
+    pos->turn = (pos->turn % 2) + 1;
+}
+
+void unmakeNullMove(struct position * pos, struct undoRecord * undo) {
+    pos->key = undo->key;
+    pos->halfmoveClock = undo->halfmoveClock;
+    pos->enPassantSquare = undo->enPassantSquare;
+    pos->turn = (pos->turn % 2) + 1;
+}
+
+int findKingSquare(const struct position * pos, int player) {
+    // Returns -1 (NO_SQUARE) if the player has no king (possible in half built scenarios).
+    return pos->kingSquares[player];
+}
+
+static int isOnBoard(int row, int column) {
+    return row >= 0 && row <= 7 && column >= 0 && column <= 7;
+}
+
+static int isSliderAttack(const struct position * pos, int row, int column, int directionY, int directionX,
+                          int byPlayer, int straight) {
+    // Walk along a ray until the first piece and check if it is a matching slider.
+    // straight: rook type ray (rook and queen), else bishop type ray (bishop and queen).
+    int sliderRank = straight ? 2 : 4;
+
+    row += directionY;
+    column += directionX;
+    while(isOnBoard(row, column)) {
+        struct chessPiece piece = pos->board[SQUARE(row, column)];
+        if(piece.rank != 0) {
+            return piece.owner == byPlayer && (piece.rank == sliderRank || piece.rank == 5);
+        }
+        row += directionY;
+        column += directionX;
+    }
+    return 0;
+}
+
+int isSquareAttacked(const struct position * pos, int square, int byPlayer) {
+    // Check if any piece of byPlayer could capture on square.
+    // Gives the same answer as probing validateAndMakeMove with every opponent piece, but without the 64 calls.
+    int row = SQUARE_ROW(square);
+    int column = SQUARE_COLUMN(square);
+
+    // Pawns. Player 1 pawns move up the board, so they attack from the row below.
+    int pawnRow = (byPlayer == 1) ? row - 1 : row + 1;
+    for(int side = -1; side <= 1; side += 2) {
+        if(isOnBoard(pawnRow, column + side)) {
+            struct chessPiece piece = pos->board[SQUARE(pawnRow, column + side)];
+            if(piece.rank == 1 && piece.owner == byPlayer) {
+                return 1;
+            }
+        }
+    }
+
+    // Knights and kings
+    for(int i = 0; i < 8; i++) {
+        if(isOnBoard(row + knightJumps[i][0], column + knightJumps[i][1])) {
+            struct chessPiece piece = pos->board[SQUARE(row + knightJumps[i][0], column + knightJumps[i][1])];
+            if(piece.rank == 3 && piece.owner == byPlayer) {
+                return 1;
+            }
+        }
+        if(isOnBoard(row + kingSteps[i][0], column + kingSteps[i][1])) {
+            struct chessPiece piece = pos->board[SQUARE(row + kingSteps[i][0], column + kingSteps[i][1])];
+            if(piece.rank == 6 && piece.owner == byPlayer) {
+                return 1;
+            }
+        }
+    }
+
+    // Sliders. The first four king steps are straight, the last four diagonal.
+    for(int i = 0; i < 8; i++) {
+        if(isSliderAttack(pos, row, column, kingSteps[i][0], kingSteps[i][1], byPlayer, i < 4)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int isPlayerInCheck(const struct position * pos, int player) {
+    int kingSquare = findKingSquare(pos, player);
+
+    // No king, no check.
+    if(kingSquare == -1) {
+        return 0;
+    }
+    return isSquareAttacked(pos, kingSquare, (player % 2) + 1);
+}
+
+// DRAW RULES ----------------------------------------------------------------------------------------------------------
+void clearPositionHistory(struct positionHistory * history) {
+    history->count = 0;
+}
+
+void pushPositionHistory(struct positionHistory * history, uint64_t key) {
+    // Add the key of a position that is about to be left. When full, the older half is dropped: the fifty move rule
+    // ends a game long before repetition checks would need it.
+    if(history->count == POSITION_HISTORY_MAX) {
+        memmove(history->keys, history->keys + (POSITION_HISTORY_MAX / 2),
+                (POSITION_HISTORY_MAX / 2) * sizeof(uint64_t));
+        history->count = POSITION_HISTORY_MAX / 2;
+    }
+    history->keys[history->count++] = key;
+}
+
+void popPositionHistory(struct positionHistory * history) {
+    if(history->count > 0) {
+        history->count--;
+    }
+}
+
+int countRepetitions(const struct positionHistory * history, const struct position * pos) {
+    // How many times pos occurred before. Only positions with the same player in turn and since the last capture or
+    // pawn move are compared: 4 plies back is the first one that can be the same.
+    int repetitions = 0;
+    int oldest = history->count - pos->halfmoveClock;
+    if(oldest < 0) {
+        oldest = 0;
+    }
+
+    for(int i = history->count - 4; i >= oldest; i -= 2) {
+        if(history->keys[i] == pos->key) {
+            repetitions++;
+        }
+    }
+    return repetitions;
+}
+
+int isInsufficientMaterial(const struct position * pos) {
+    // Neither player can ever mate: kings only, a single minor piece, or only bishops that all move on the same
+    // color of squares.
+    for(int owner = 1; owner <= 2; owner++) {
+        if(pos->pieceCounts[owner][1] || pos->pieceCounts[owner][2] || pos->pieceCounts[owner][5]) {
+            return 0;
+        }
+    }
+    int knights = pos->pieceCounts[1][3] + pos->pieceCounts[2][3];
+    int bishops = pos->pieceCounts[1][4] + pos->pieceCounts[2][4];
+    if(knights + bishops <= 1) {
+        return 1;
+    }
+    if(knights) {
+        return 0;
+    }
+
+    // Only bishops left, a square's color is the parity of row + column.
+    int colors[2] = {0, 0};
+    for(int square = 0; square < 64; square++) {
+        if(pos->board[square].rank == 4) {
+            colors[(SQUARE_ROW(square) + SQUARE_COLUMN(square)) & 1] = 1;
+        }
+    }
+    return !(colors[0] && colors[1]);
+}
+
+int getDrawReason(const struct positionHistory * history, const struct position * pos) {
+    // Draw rules of a game: the third occurrence of a position, fifty moves without a capture or a pawn move, or
+    // material that can't mate. Checkmate must be checked first, it wins even on the hundredth ply.
+    if(isInsufficientMaterial(pos)) {
+        return DRAW_INSUFFICIENT_MATERIAL;
+    }
+    if(pos->halfmoveClock >= FIFTY_MOVE_PLIES) {
+        return DRAW_FIFTY_MOVES;
+    }
+    if(countRepetitions(history, pos) >= 2) {
+        return DRAW_REPETITION;
+    }
+    return DRAW_NONE;
+}
@@ -0,0 +1,140 @@
+/*
+File:           Position.h
+Author:         Toni Lindeman
+Description:    Compact position state and fast make / unmake of encoded moves.
+*/
+
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <stdint.h>
+#include "ChessPiece.h"
+
+// Square helpers. Squares use the same indexing as the chessboard: (8 * row) + column.
+#define SQUARE(row, column) ((8 * (row)) + (column))
+#define SQUARE_ROW(square) ((square) >> 3)
+#define SQUARE_COLUMN(square) ((square) & 7)
+
+// Move encoding: from square (6 bits), to square (6 bits), promotion rank (3 bits, 0 = none), flags (2 bits).
+#define MOVE_ENCODE(from, to, promotion) ((from) | ((to) << 6) | ((promotion) << 12))
+#define MOVE_FROM(move) ((move) & 63)
+#define MOVE_TO(move) (((move) >> 6) & 63)
+#define MOVE_PROMOTION(move) (((move) >> 12) & 7)
+// Castling is encoded as the king's move, e.g. e1g1. The rook moves along.
+#define MOVE_CASTLING (1 << 15)
+// The captured pawn is not on the to square but next to the from square.
+#define MOVE_EN_PASSANT (1 << 16)
+#define MOVE_IS_CASTLING(move) (((move) & MOVE_CASTLING) != 0)
+#define MOVE_IS_EN_PASSANT(move) (((move) & MOVE_EN_PASSANT) != 0)
+#define EN_PASSANT_CAPTURE_SQUARE(move) SQUARE(SQUARE_ROW(MOVE_FROM(move)), SQUARE_COLUMN(MOVE_TO(move)))
+// A1 -> A1 can never be a move, so 0 works as "no move".
+#define MOVE_NONE 0
+
+// Castling rights, as bits. Short castling is towards the h column.
+#define CASTLING_PLAYER1_SHORT 1
+#define CASTLING_PLAYER1_LONG 2
+#define CASTLING_PLAYER2_SHORT 4
+#define CASTLING_PLAYER2_LONG 8
+#define CASTLING_ALL 15
+#define NO_SQUARE -1
+
+// Material key: the number of each piece type in 4 bits, player 1's pawns in the lowest bits and player 2's king in
+// the highest. Positions with the same material have the same key, and the counts can be read back from it. Only
+// invalid positions have more than 15 of a piece, their counts spill over to the next type.
+#define MATERIAL_SHIFT(owner, rank) (4 * ((6 * ((owner) - 1)) + (rank) - 1))
+#define MATERIAL_ONE(owner, rank) ((uint64_t)1 << MATERIAL_SHIFT(owner, rank))
+#define MATERIAL_COUNT(materialKey, owner, rank) ((int)(((materialKey) >> MATERIAL_SHIFT(owner, rank)) & 15))
+// The same material with the players swapped.
+#define MATERIAL_FLIP(materialKey) ((((materialKey) & 0xFFFFFFULL) << 24) | ((materialKey) >> 24))
+
+// Piece list size per player. Legal positions need 16, but a player can't have more pieces than there are squares,
+// so invalid positions read from files fit too.
+#define PIECE_LIST_MAX 64
+
+// Fifty moves by both players without a capture or a pawn move is a draw.
+#define FIFTY_MOVE_PLIES 100
+// Keys kept for repetition checks. Only the ones since the last capture or pawn move matter, older ones are dropped
+// when this fills up.
+#define POSITION_HISTORY_MAX 1024
+
+// Game ending draws, from getDrawReason.
+#define DRAW_NONE 0
+#define DRAW_REPETITION 1
+#define DRAW_FIFTY_MOVES 2
+#define DRAW_INSUFFICIENT_MATERIAL 3
+
+struct position {
+    struct chessPiece board[64];
+    int turn;
+    // Zobrist key, kept up to date by make / unmake.
+    uint64_t key;
+    // Same, but of the pawns only. Keys the pawn structure evaluation cache.
+    uint64_t pawnKey;
+    // Plies since the last capture or pawn move. Positions before that can't repeat.
+    int halfmoveClock;
+    // Move number as in FEN, starts from 1 and goes up after every move of player 2.
+    int fullmoveNumber;
+    // CASTLING_ bits. A right is lost for good when the king or that rook moves or the rook is captured.
+    int castlingRights;
+    // Square a pawn skipped with its two step move, if a pawn of the player in turn stands next to it.
+    // NO_SQUARE otherwise, so positions only differ by en passant when a capture is really possible.
+    int enPassantSquare;
+    // Number of pieces, indexed [owner][rank] like the chessboard. Kept up to date by make / unmake.
+    int pieceCounts[3][7];
+    // The same counts as one number, see MATERIAL_SHIFT. Kept up to date by make / unmake.
+    uint64_t materialKey;
+    // Squares of each player's pieces (index 1 and 2), king included, in no particular order. Looping over a
+    // player's pieces takes as many steps as they have pieces. Kept up to date by make / unmake.
+    unsigned char pieceSquares[3][PIECE_LIST_MAX];
+    int pieceListCount[3];
+    // Where the piece on each occupied square is in its owner's list.
+    unsigned char pieceListIndex[64];
+    // NO_SQUARE for a player without a king.
+    int kingSquares[3];
+};
+
+// Everything unmakeMove needs to restore the position.
+struct undoRecord {
+    struct chessPiece moved;
+    struct chessPiece captured;
+    uint64_t key;
+    uint64_t pawnKey;
+    uint64_t materialKey;
+    int halfmoveClock;
+    int castlingRights;
+    int enPassantSquare;
+    // Where the captured piece was in its owner's list, so the list is restored in the same order.
+    int capturedListIndex;
+};
+
+// Keys of the positions a game (and a search on top of it) went through, oldest first. The current position is not
+// included.
+struct positionHistory {
+    uint64_t keys[POSITION_HISTORY_MAX];
+    int count;
+};
+
+void setPositionFromChessboard(struct position * pos, struct chessPiece * chessboard, int turn);
+void setInitialPosition(struct position * pos);
+uint64_t computePositionKey(const struct position * pos);
+uint64_t computePawnKey(const struct position * pos);
+void computePieceCounts(struct position * pos);
+int countPromotedPieces(const int * counts);
+void placePiece(struct position * pos, int square, struct chessPiece piece);
+int inferCastlingRights(const struct position * pos);
+void getCastlingRookMove(int move, int * outFrom, int * outTo);
+void makeMove(struct position * pos, int move, struct undoRecord * undo);
+void unmakeMove(struct position * pos, int move, struct undoRecord * undo);
+void makeNullMove(struct position * pos, struct undoRecord * undo);
+void unmakeNullMove(struct position * pos, struct undoRecord * undo);
+int findKingSquare(const struct position * pos, int player);
+int isSquareAttacked(const struct position * pos, int square, int byPlayer);
+int isPlayerInCheck(const struct position * pos, int player);
+void clearPositionHistory(struct positionHistory * history);
+void pushPositionHistory(struct positionHistory * history, uint64_t key);
+void popPositionHistory(struct positionHistory * history);
+int countRepetitions(const struct positionHistory * history, const struct position * pos);
+int isInsufficientMaterial(const struct position * pos);
+int getDrawReason(const struct positionHistory * history, const struct position * pos);
+
+#endif /* POSITION_H */
@@ -0,0 +1,595 @@
+/*
+File:           Search.c
+Author:         Toni Lindeman
+Description:    Alpha-beta search for the computer player.
+
+Search is iterative deepening negamax with principal variation search, a transposition table, null move pruning,
+late move reductions and a capture-only quiescence search. Scores are centipawns from the point of view of the
+player in turn. Mates are scored as MATE_SCORE minus the distance in plies.
+
+A MultiPV search finds the best N lines. Every iteration searches the root N times, each time leaving out the first
+moves of the lines already found. The searches share the transposition table, and each line starts from the move
+that was next best in the previous iteration, so the lines after the first cost less than searches of their own.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "OSSpecific.h"
+#include "MoveGen.h"
+#include "Evaluate.h"
+#include "Tablebase.h"
+#include "Search.h"
+
+// How often (in nodes) the clock is checked.
+#define CHECK_LIMITS_INTERVAL 2048
+
+int initSearchState(struct searchState * state, size_t hashMegabytes) {
+    // Returns 0 if the hash tables couldn't be allocated.
+    memset(state->killers, 0, sizeof(state->killers));
+    memset(state->history, 0, sizeof(state->history));
+    state->nodes = 0;
+    state->nodeLimit = 0;
+    state->deadline = 0;
+    state->rootDepth = 0;
+    state->excludedCount = 0;
+    state->previousLineCount = 0;
+    atomic_init(&state->stop, 0);
+    state->onIteration = NULL;
+    state->iterationContext = NULL;
+    clearPositionHistory(&state->keyHistory);
+
+    state->network = NULL;
+    state->accumulators = (struct accumulator *) aligned_alloc(NETWORK_ALIGNMENT,
+                                                               (MAX_PLY + 1) * sizeof(struct accumulator));
+    if(!state->accumulators) {
+        return 0;
+    }
+    if(!initPawnHashTable(&state->pawnTable)) {
+        free(state->accumulators);
+        return 0;
+    }
+    if(!initTranspositionTable(&state->table, hashMegabytes)) {
+        freePawnHashTable(&state->pawnTable);
+        free(state->accumulators);
+        return 0;
+    }
+    return 1;
+}
+
+void freeSearchState(struct searchState * state) {
+    freeTranspositionTable(&state->table);
+    freePawnHashTable(&state->pawnTable);
+    free(state->accumulators);
+}
+
+void setSearchHistory(struct searchState * state, const struct positionHistory * history) {
+    // Positions played before the root, so the search sees repetitions of them. NULL for none.
+    clearPositionHistory(&state->keyHistory);
+    if(history) {
+        memcpy(state->keyHistory.keys, history->keys, history->count * sizeof(uint64_t));
+        state->keyHistory.count = history->count;
+    }
+}
+
+void stopSearch(struct searchState * state) {
+    // Can be called from another thread. The search returns the result of the last finished iteration.
+    atomic_store(&state->stop, 1);
+}
+
+int scoreToMateMoves(int score) {
+    // Mate distance in moves, negative if the player in turn gets mated. 0 if score is not a mate.
+    if(score > MATE_BOUND) {
+        return (MATE_SCORE - score + 1) / 2;
+    }
+    if(score < -MATE_BOUND) {
+        return -(MATE_SCORE + score) / 2;
+    }
+    return 0;
+}
+
+// HELPERS -------------------------------------------------------------------------------------------------------------
+static int isStopped(struct searchState * state) {
+    // The first iteration always finishes, so there is always a move to play.
+    return state->rootDepth > 1 && atomic_load_explicit(&state->stop, memory_order_relaxed);
+}
+
+static void checkLimits(struct searchState * state) {
+    if((state->nodeLimit && state->nodes >= state->nodeLimit) ||
+       (state->deadline > 0 && getTimeSeconds() >= state->deadline)) {
+        atomic_store_explicit(&state->stop, 1, memory_order_relaxed);
+    }
+}
+
+static int scoreToTable(int score, int ply) {
+    // Mate scores are stored relative to the stored position, not the root.
+    if(score > MATE_BOUND) {
+        return score + ply;
+    }
+    if(score < -MATE_BOUND) {
+        return score - ply;
+    }
+    return score;
+}
+
+static int scoreFromTable(int score, int ply) {
+    if(score > MATE_BOUND) {
+        return score - ply;
+    }
+    if(score < -MATE_BOUND) {
+        return score + ply;
+    }
+    return score;
+}
+
+static int tablebaseScore(const struct tablebaseResult * result, int ply) {
+    // Tablebase results are exact, score them as mates found by the search.
+    if(result->wdl == 1) {
+        return MATE_SCORE - ply - ((2 * result->movesToMate) - 1);
+    }
+    if(result->wdl == -1) {
+        return -MATE_SCORE + ply + (2 * result->movesToMate);
+    }
+    return 0;
+}
+
+static int hasNonPawnMaterial(const struct position * pos, int player) {
+    // Null move pruning is unsafe in pawn endings (zugzwang).
+    return pos->pieceCounts[player][6] + pos->pieceCounts[player][1] != pos->pieceListCount[player];
+}
+
+static int evaluate(struct searchState * state, const struct position * pos, int ply) {
+    // Network evaluation if there is a network, otherwise the handwritten one.
+    if(!state->network) {
+        return evaluatePosition(pos, &state->pawnTable);
+    }
+
+    // Bring the accumulators up to date from the last computed one. The root's is always computed.
+    int computed = ply;
+    while(!state->accumulators[computed].computed) {
+        computed--;
+    }
+    for(int i = computed + 1; i <= ply; i++) {
+        updateAccumulator(state->network, &state->accumulators[i - 1], &state->accumulators[i]);
+    }
+    return evaluateNetwork(state->network, &state->accumulators[ply], pos->turn);
+}
+
+static int isDraw(struct searchState * state, const struct position * pos) {
+    // Repeating a position once is enough in the search: if it was worth repeating, it's worth repeating again.
+    return pos->halfmoveClock >= FIFTY_MOVE_PLIES || isInsufficientMaterial(pos) ||
+           countRepetitions(&state->keyHistory, pos) > 0;
+}
+
+static void makeSearchMove(struct searchState * state, struct position * pos, int move, struct undoRecord * undo,
+                           int ply) {
+    // makeMove, plus the network changes and the key history of the move. The accumulator is only updated if it's
+    // evaluated.
+    if(state->network) {
+        recordMoveChanges(pos, move, &state->accumulators[ply + 1]);
+    }
+    pushPositionHistory(&state->keyHistory, pos->key);
+    makeMove(pos, move, undo);
+}
+
+static void unmakeSearchMove(struct searchState * state, struct position * pos, int move, struct undoRecord * undo) {
+    unmakeMove(pos, move, undo);
+    popPositionHistory(&state->keyHistory);
+}
+
+static int isExcludedMove(const struct searchState * state, int move) {
+    for(int i = 0; i < state->excludedCount; i++) {
+        if(state->excludedMoves[i] == move) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int isQuietMove(const struct position * pos, int move) {
+    return pos->board[MOVE_TO(move)].rank == 0 && !MOVE_PROMOTION(move) && !MOVE_IS_EN_PASSANT(move);
+}
+
+// MOVE ORDERING -------------------------------------------------------------------------------------------------------
+static void scoreMoves(struct searchState * state, const struct position * pos, struct moveList * list,
+                       int * scores, int ttMove, int ply) {
+    // Order: transposition table move, captures (most valuable victim, least valuable attacker), promotions,
+    // killer moves, then quiet moves by history.
+    for(int i = 0; i < list->count; i++) {
+        int move = list->moves[i];
+        struct chessPiece victim = pos->board[MOVE_TO(move)];
+
+        if(move == ttMove) {
+            scores[i] = 1000000;
+        }
+        else if(victim.rank != 0) {
+            scores[i] = 100000 + (pieceValues[victim.rank] * 8) - pos->board[MOVE_FROM(move)].rank;
+        }
+        else if(MOVE_IS_EN_PASSANT(move)) {
+            scores[i] = 100000 + (pieceValues[1] * 8) - 1;
+        }
+        else if(MOVE_PROMOTION(move)) {
+            scores[i] = 90000 + MOVE_PROMOTION(move);
+        }
+        else if(move == state->killers[ply][0]) {
+            scores[i] = 80000;
+        }
+        else if(move == state->killers[ply][1]) {
+            scores[i] = 79000;
+        }
+        else {
+            scores[i] = state->history[MOVE_FROM(move)][MOVE_TO(move)];
+        }
+    }
+}
+
+static int pickMove(struct moveList * list, int * scores, int index) {
+    // Selection sort one step at a time. Cutoffs usually come early, so sorting the whole list is wasted work.
+    int best = index;
+    for(int i = index + 1; i < list->count; i++) {
+        if(scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+
+    int tempMove = list->moves[index];
+    int tempScore = scores[index];
+    list->moves[index] = list->moves[best];
+    scores[index] = scores[best];
+    list->moves[best] = tempMove;
+    scores[best] = tempScore;
+
+    return list->moves[index];
+}
+
+// SEARCH --------------------------------------------------------------------------------------------------------------
+static int quiescence(struct searchState * state, struct position * pos, int alpha, int beta, int ply) {
+    // Search captures only, until the position is quiet enough to trust the static evaluation.
+    state->nodes++;
+    if((state->nodes % CHECK_LIMITS_INTERVAL) == 0) {
+        checkLimits(state);
+    }
+    if(isStopped(state)) {
+        return 0;
+    }
+
+    int standPat = evaluate(state, pos, ply);
+    if(ply >= MAX_PLY - 1 || standPat >= beta) {
+        return standPat;
+    }
+    if(standPat > alpha) {
+        alpha = standPat;
+    }
+
+    struct moveList list;
+    int scores[MAX_MOVES];
+    struct undoRecord undo;
+    int player = pos->turn;
+
+    generatePseudoLegalMoves(pos, &list);
+
+    // Drop quiet moves.
+    int captureCount = 0;
+    for(int i = 0; i < list.count; i++) {
+        if(!isQuietMove(pos, list.moves[i])) {
+            list.moves[captureCount++] = list.moves[i];
+        }
+    }
+    list.count = captureCount;
+    scoreMoves(state, pos, &list, scores, MOVE_NONE, ply);
+
+    for(int i = 0; i < list.count; i++) {
+        int move = pickMove(&list, scores, i);
+
+        makeSearchMove(state, pos, move, &undo, ply);
+        if(isPlayerInCheck(pos, player)) {
+            unmakeSearchMove(state, pos, move, &undo);
+            continue;
+        }
+        int score = -quiescence(state, pos, -beta, -alpha, ply + 1);
+        unmakeSearchMove(state, pos, move, &undo);
+
+        if(isStopped(state)) {
+            return 0;
+        }
+        if(score > alpha) {
+            alpha = score;
+            if(score >= beta) {
+                break;
+            }
+        }
+    }
+
+    return alpha;
+}
+
+static int negamax(struct searchState * state, struct position * pos, int depth, int alpha, int beta, int ply,
+                   int allowNull) {
+    state->pvLength[ply] = 0;
+
+    if(ply >= MAX_PLY - 1) {
+        return evaluate(state, pos, ply);
+    }
+
+    // Repetitions, the fifty move rule and dead positions. Not at the root, the root still needs a move.
+    if(ply > 0 && isDraw(state, pos)) {
+        return 0;
+    }
+
+    // Endgame tablebases. Not at the root, the root still needs a move.
+    struct tablebaseResult tablebase;
+    if(ply > 0 && tablebasePieces && probeTablebase(pos, &tablebase)) {
+        return tablebaseScore(&tablebase, ply);
+    }
+
+    // Check extension, a checked side must not fall into quiescence.
+    int inCheck = isPlayerInCheck(pos, pos->turn);
+    if(inCheck) {
+        depth++;
+    }
+    if(depth <= 0) {
+        return quiescence(state, pos, alpha, beta, ply);
+    }
+
+    state->nodes++;
+    if((state->nodes % CHECK_LIMITS_INTERVAL) == 0) {
+        checkLimits(state);
+    }
+    if(isStopped(state)) {
+        return 0;
+    }
+
+    int isPvNode = (beta - alpha) > 1;
+    int originalAlpha = alpha;
+
+    // Transposition table
+    struct ttEntry entry;
+    int ttMove = MOVE_NONE;
+    if(probeTransposition(&state->table, pos->key, &entry)) {
+        ttMove = entry.move;
+        if(!isPvNode && ply > 0 && entry.depth >= depth) {
+            int ttScore = scoreFromTable(entry.score, ply);
+            if(entry.flag == TT_EXACT || (entry.flag == TT_LOWER && ttScore >= beta) ||
+               (entry.flag == TT_UPPER && ttScore <= alpha)) {
+                return ttScore;
+            }
+        }
+    }
+
+    struct undoRecord undo;
+
+    // Null move pruning: if passing the turn still beats beta, a real move will too.
+    if(allowNull && !inCheck && !isPvNode && ply > 0 && depth >= 3 && hasNonPawnMaterial(pos, pos->turn) &&
+       evaluate(state, pos, ply) >= beta) {
+        if(state->network) {
+            recordMoveChanges(pos, MOVE_NONE, &state->accumulators[ply + 1]);
+        }
+        pushPositionHistory(&state->keyHistory, pos->key);
+        makeNullMove(pos, &undo);
+        int score = -negamax(state, pos, depth - 3, -beta, -beta + 1, ply + 1, 0);
+        unmakeNullMove(pos, &undo);
+        popPositionHistory(&state->keyHistory);
+
+        if(isStopped(state)) {
+            return 0;
+        }
+        if(score >= beta) {
+            // Don't trust mate scores from a null move.
+            return (score > MATE_BOUND) ? beta : score;
+        }
+    }
+
+    // The root's table move is excluded after the first line, try the next best of the previous iteration instead.
+    if(ply == 0 && state->excludedCount > 0) {
+        ttMove = MOVE_NONE;
+        for(int i = 0; i < state->previousLineCount && ttMove == MOVE_NONE; i++) {
+            if(!isExcludedMove(state, state->previousLineMoves[i])) {
+                ttMove = state->previousLineMoves[i];
+            }
+        }
+    }
+
+    struct moveList list;
+    int scores[MAX_MOVES];
+    int player = pos->turn;
+    int bestScore = -INFINITE_SCORE;
+    int bestMove = MOVE_NONE;
+    int legalCount = 0;
+
+    generatePseudoLegalMoves(pos, &list);
+    scoreMoves(state, pos, &list, scores, ttMove, ply);
+
+    for(int i = 0; i < list.count; i++) {
+        int move = pickMove(&list, scores, i);
+        int isQuiet = isQuietMove(pos, move);
+
+        if(ply == 0 && isExcludedMove(state, move)) {
+            continue;
+        }
+
+        makeSearchMove(state, pos, move, &undo, ply);
+        if(isPlayerInCheck(pos, player)) {
+            unmakeSearchMove(state, pos, move, &undo);
+            continue;
+        }
+        legalCount++;
+
+        int score;
+        if(legalCount == 1) {
+            score = -negamax(state, pos, depth - 1, -beta, -alpha, ply + 1, 1);
+        }
+        else {
+            // Late quiet moves are rarely best, search them shallower first.
+            int reduction = 0;
+            if(depth >= 3 && legalCount > 3 && isQuiet && !inCheck && move != state->killers[ply][0] &&
+               move != state->killers[ply][1]) {
+                reduction = (legalCount > 8) ? 2 : 1;
+            }
+
+            score = -negamax(state, pos, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, 1);
+            if(score > alpha && reduction) {
+                score = -negamax(state, pos, depth - 1, -alpha - 1, -alpha, ply + 1, 1);
+            }
+            if(score > alpha && score < beta) {
+                score = -negamax(state, pos, depth - 1, -beta, -alpha, ply + 1, 1);
+            }
+        }
+        unmakeSearchMove(state, pos, move, &undo);
+
+        if(isStopped(state)) {
+            return 0;
+        }
+
+        if(score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+
+            if(score > alpha) {
+                alpha = score;
+
+                // Update principal variation
+                state->pv[ply][0] = move;
+                for(int j = 0; j < state->pvLength[ply + 1]; j++) {
+                    state->pv[ply][j + 1] = state->pv[ply + 1][j];
+                }
+                state->pvLength[ply] = state->pvLength[ply + 1] + 1;
+
+                if(score >= beta) {
+                    if(isQuiet) {
+                        if(state->killers[ply][0] != move) {
+                            state->killers[ply][1] = state->killers[ply][0];
+                            state->killers[ply][0] = move;
+                        }
+                        state->history[MOVE_FROM(move)][MOVE_TO(move)] += depth * depth;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // No legal moves: checkmate or stalemate. Or a MultiPV search has no more root moves to try.
+    if(legalCount == 0) {
+        if(ply == 0 && state->excludedCount > 0) {
+            return -INFINITE_SCORE;
+        }
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+
+    // With moves left out the best of the rest isn't the root's best move, keep it out of the table.
+    if(ply == 0 && state->excludedCount > 0) {
+        return bestScore;
+    }
+
+    int flag = TT_UPPER;
+    if(bestScore >= beta) {
+        flag = TT_LOWER;
+    }
+    else if(bestScore > originalAlpha) {
+        flag = TT_EXACT;
+    }
+    storeTransposition(&state->table, pos->key, bestMove, scoreToTable(bestScore, ply), depth, flag);
+
+    return bestScore;
+}
+
+void searchPosition(struct searchState * state, struct position * pos, const struct searchLimits * limits,
+                    struct searchResult * outResult) {
+    // Iterative deepening. The result is from the deepest finished iteration.
+    double startTime = getTimeSeconds();
+
+    state->nodes = 0;
+    state->nodeLimit = limits->nodes;
+    state->deadline = (limits->timeSeconds > 0) ? startTime + limits->timeSeconds : 0;
+    atomic_store(&state->stop, 0);
+    memset(state->killers, 0, sizeof(state->killers));
+    memset(state->history, 0, sizeof(state->history));
+    state->network = getNetwork();
+    if(state->network) {
+        refreshAccumulator(state->network, pos, &state->accumulators[0]);
+    }
+
+    int maxDepth = (limits->depth > 0 && limits->depth < MAX_PLY - 1) ? limits->depth : MAX_PLY - 2;
+    int multiPV = (limits->multiPV > 1) ? limits->multiPV : 1;
+    if(multiPV > MULTIPV_MAX) {
+        multiPV = MULTIPV_MAX;
+    }
+
+    outResult->bestMove = MOVE_NONE;
+    outResult->score = 0;
+    outResult->depth = 0;
+    outResult->pvLength = 0;
+    outResult->lineCount = 0;
+    outResult->bestLineNodes = 0;
+
+    struct searchLine lines[MULTIPV_MAX];
+    long bestLineNodes = 0;
+    state->previousLineCount = 0;
+
+    for(int depth = 1; depth <= maxDepth; depth++) {
+        state->rootDepth = depth;
+
+        // One root search per line, each leaving out the first moves of the lines before it.
+        int lineCount = 0;
+        for(state->excludedCount = 0; state->excludedCount < multiPV; state->excludedCount++) {
+            long nodesBefore = state->nodes;
+            int score = negamax(state, pos, depth, -INFINITE_SCORE, INFINITE_SCORE, 0, 0);
+            if(state->excludedCount == 0) {
+                bestLineNodes += state->nodes - nodesBefore;
+            }
+            if(isStopped(state) || state->pvLength[0] == 0) {
+                break;
+            }
+
+            // Searches of different lines can disagree a little, keep the lines ranked by score.
+            int index = lineCount++;
+            while(index > 0 && lines[index - 1].score < score) {
+                lines[index] = lines[index - 1];
+                index--;
+            }
+            lines[index].score = score;
+            lines[index].pvLength = state->pvLength[0];
+            memcpy(lines[index].pv, state->pv[0], state->pvLength[0] * sizeof(int));
+            state->excludedMoves[state->excludedCount] = state->pv[0][0];
+        }
+        state->excludedCount = 0;
+
+        // An iteration counts only if it found all of its lines.
+        if(isStopped(state)) {
+            break;
+        }
+
+        for(int i = 0; i < lineCount; i++) {
+            state->previousLineMoves[i] = lines[i].pv[0];
+        }
+        state->previousLineCount = lineCount;
+
+        outResult->lineCount = lineCount;
+        memcpy(outResult->lines, lines, lineCount * sizeof(struct searchLine));
+        outResult->bestLineNodes = bestLineNodes;
+        outResult->score = lineCount ? lines[0].score : 0;
+        outResult->depth = depth;
+        outResult->pvLength = lineCount ? lines[0].pvLength : 0;
+        memcpy(outResult->pv, lines[0].pv, outResult->pvLength * sizeof(int));
+        outResult->bestMove = outResult->pvLength ? outResult->pv[0] : MOVE_NONE;
+        int score = outResult->score;
+        if(state->onIteration) {
+            outResult->nodes = state->nodes;
+            outResult->seconds = getTimeSeconds() - startTime;
+            state->onIteration(outResult, state->iterationContext);
+        }
+
+        // No legal moves, or a forced mate that deeper search cannot improve. Other lines of a MultiPV search still
+        // can.
+        if(outResult->bestMove == MOVE_NONE ||
+           (multiPV == 1 && abs(score) > MATE_BOUND && MATE_SCORE - abs(score) <= depth)) {
+            break;
+        }
+        // Next iteration would most likely not finish in time.
+        if(state->deadline > 0 && getTimeSeconds() - startTime > limits->timeSeconds / 2) {
+            break;
+        }
+    }
+
+    outResult->nodes = state->nodes;
+    outResult->seconds = getTimeSeconds() - startTime;
+}
@@ -0,0 +1,93 @@
+/*
+File:           Search.h
+Author:         Toni Lindeman
+Description:    Alpha-beta search for the computer player.
+*/
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "Position.h"
+#include "Transposition.h"
+#include "Evaluate.h"
+#include "Network.h"
+
+#define MAX_PLY 64
+#define MATE_SCORE 30000
+// Scores beyond this are mates. Tablebase mates can be much further away than MAX_PLY.
+#define MATE_BOUND (MATE_SCORE - 512)
+#define INFINITE_SCORE 32000
+// Most lines a MultiPV search can report.
+#define MULTIPV_MAX 8
+
+struct searchLimits {
+    // 0 means no limit.
+    int depth;
+    double timeSeconds;
+    long nodes;
+    // Best lines to find, each with a different first move. 0 or 1 is one line, at most MULTIPV_MAX.
+    int multiPV;
+};
+
+struct searchLine {
+    int score;
+    int pv[MAX_PLY];
+    int pvLength;
+};
+
+struct searchResult {
+    int bestMove;
+    int score;
+    int depth;
+    long nodes;
+    double seconds;
+    int pv[MAX_PLY];
+    int pvLength;
+    // Lines of a MultiPV search from best to worst, the first is the same as above. Fewer than asked for if the
+    // position doesn't have that many legal moves.
+    struct searchLine lines[MULTIPV_MAX];
+    int lineCount;
+    // Nodes spent on the first line. nodes / bestLineNodes is what the other lines cost.
+    long bestLineNodes;
+};
+
+// Everything one search thread needs. Threads never share a search state.
+struct searchState {
+    struct transpositionTable table;
+    struct pawnHashTable pawnTable;
+    // Network evaluation, NULL if there is no network. Accumulators are indexed by ply.
+    const struct network * network;
+    struct accumulator * accumulators;
+    // Keys of the game before the root, set with setSearchHistory, followed by the current search path.
+    struct positionHistory keyHistory;
+    int killers[MAX_PLY][2];
+    int history[64][64];
+    int pv[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    long nodes;
+    long nodeLimit;
+    double deadline;
+    int rootDepth;
+    // Root moves left out of the search, the first moves of the lines a MultiPV iteration already found.
+    int excludedMoves[MULTIPV_MAX];
+    int excludedCount;
+    // First moves of the lines of the previous iteration, best first. Each line tries the best of them it may first.
+    int previousLineMoves[MULTIPV_MAX];
+    int previousLineCount;
+    atomic_int stop;
+    // Called on the search thread with the result of every finished iteration, NULL for none.
+    void (* onIteration)(const struct searchResult * result, void * context);
+    void * iterationContext;
+};
+
+int initSearchState(struct searchState * state, size_t hashMegabytes);
+void freeSearchState(struct searchState * state);
+void searchPosition(struct searchState * state, struct position * pos, const struct searchLimits * limits,
+                    struct searchResult * outResult);
+void setSearchHistory(struct searchState * state, const struct positionHistory * history);
+void stopSearch(struct searchState * state);
+int scoreToMateMoves(int score);
+
+#endif /* SEARCH_H */
@@ -0,0 +1,642 @@
+/*
+File:           Server.c
+Author:         Toni Lindeman
+Description:    Game server hosting many sessions over a local socket, and a simple client for it.
+
+The server is a single thread around epoll: every socket is non-blocking and submitMove never waits, so one
+thread keeps thousands of games going. Sessions are not tied to connections, any connection can move in any
+game by its id, so two players (or a test script) can share a game.
+
+Address is "unix:/path/to/socket" for a Unix socket, or "port" / "host:port" for TCP (host defaults to
+127.0.0.1). The protocol is one command per line and one reply line per command:
+    new [base seconds] [increment]  ->  ok <game id>
+    move <id> <e2e4>                ->  ok <active | checkmate winner | timeout winner | stalemate 0 | draw 0>
+    show <id>                       ->  ok <fen> <state> <winner> <player 1 clock> <player 2 clock>
+    moves <id>                      ->  ok <moves in coordinate notation>
+    close <id>                      ->  ok
+    stats                           ->  ok sessions <count> connections <count> bytes <session memory>
+                                        pool <name> <in use>/<capacity> ...
+    quit                            ->  closes the connection
+Failed commands reply "error <reason>".
+
+epoll is Linux only, as are the rest of the calls here in practice.
+*/
+
+// Sockets are POSIX, not part of C11.
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "ChessPiece.h"
+#include "Position.h"
+#include "Notation.h"
+#include "Session.h"
+#include "Log.h"
+#include "Pool.h"
+#include "Server.h"
+
+// Longest command line
+#define SERVER_LINE_LENGTH 256
+// Replies waiting to be sent to one connection. The buffer starts at SERVER_OUTPUT_SIZE and grows for long replies
+// (a long game's moves), a client that lets it reach SERVER_OUTPUT_MAX is disconnected.
+#define SERVER_OUTPUT_SIZE 4096
+#define SERVER_OUTPUT_MAX (1 << 20)
+#define SERVER_MAX_EVENTS 256
+#define SERVER_LISTEN_BACKLOG 512
+// Sessions the pools are grown to hold at start, they grow further a slab at a time when needed.
+#define SERVER_RESERVED_SESSIONS 1024
+
+struct serverConnection {
+    int socket;
+    int inputLength;
+    int outputLength;
+    int outputCapacity;
+    // Set when the connection should be closed once its replies are sent.
+    int closing;
+    struct serverConnection * previous;
+    struct serverConnection * next;
+    char input[SERVER_LINE_LENGTH];
+    char * output;
+};
+
+struct serverState {
+    int epoll;
+    int listenSocket;
+    // Session of game id n is at index n - 1.
+    struct gameSession ** sessions;
+    int maxSessions;
+    int sessionCount;
+    // Stack of unused game ids
+    int * freeIds;
+    int freeIdCount;
+    struct serverConnection * connections;
+    int connectionCount;
+};
+
+static volatile sig_atomic_t serverStopping = 0;
+
+static void stopServer(int signalNumber) {
+    (void) signalNumber;
+    serverStopping = 1;
+}
+
+// SOCKETS -------------------------------------------------------------------------------------------------------------
+static int openSocket(const char * address, int listening) {
+    // Open a listening or a connected socket for address. Returns the socket, or -1 on failure.
+    int socketFd = -1;
+
+    if(!strncmp(address, "unix:", 5)) {
+        struct sockaddr_un unixAddress;
+        memset(&unixAddress, 0, sizeof(unixAddress));
+        unixAddress.sun_family = AF_UNIX;
+        if(strlen(address + 5) >= sizeof(unixAddress.sun_path)) {
+            return -1;
+        }
+        strcpy(unixAddress.sun_path, address + 5);
+
+        socketFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(socketFd == -1) {
+            return -1;
+        }
+        if(listening) {
+            // A socket file left behind by an earlier server would make bind fail.
+            unlink(unixAddress.sun_path);
+            if(bind(socketFd, (struct sockaddr *) &unixAddress, sizeof(unixAddress)) == -1) {
+                close(socketFd);
+                return -1;
+            }
+        }
+        else if(connect(socketFd, (struct sockaddr *) &unixAddress, sizeof(unixAddress)) == -1) {
+            close(socketFd);
+            return -1;
+        }
+    }
+    else {
+        char host[64] = "127.0.0.1";
+        int port = 0;
+        const char * colon = strrchr(address, ':');
+        if(colon) {
+            if(colon - address >= (long) sizeof(host)) {
+                return -1;
+            }
+            memcpy(host, address, colon - address);
+            host[colon - address] = '\0';
+            port = atoi(colon + 1);
+        }
+        else {
+            port = atoi(address);
+        }
+
+        struct sockaddr_in inetAddress;
+        memset(&inetAddress, 0, sizeof(inetAddress));
+        inetAddress.sin_family = AF_INET;
+        inetAddress.sin_port = htons((unsigned short) port);
+        if(port <= 0 || port > 65535 || inet_pton(AF_INET, host, &inetAddress.sin_addr) != 1) {
+            return -1;
+        }
+
+        socketFd = socket(AF_INET, SOCK_STREAM, 0);
+        if(socketFd == -1) {
+            return -1;
+        }
+        if(listening) {
+            int reuse = 1;
+            setsockopt(socketFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if(bind(socketFd, (struct sockaddr *) &inetAddress, sizeof(inetAddress)) == -1) {
+                close(socketFd);
+                return -1;
+            }
+        }
+        else if(connect(socketFd, (struct sockaddr *) &inetAddress, sizeof(inetAddress)) == -1) {
+            close(socketFd);
+            return -1;
+        }
+    }
+
+    if(listening && listen(socketFd, SERVER_LISTEN_BACKLOG) == -1) {
+        close(socketFd);
+        return -1;
+    }
+    return socketFd;
+}
+
+static int setNonBlocking(int socketFd) {
+    int flags = fcntl(socketFd, F_GETFL, 0);
+    return flags != -1 && fcntl(socketFd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+// CONNECTIONS ---------------------------------------------------------------------------------------------------------
+static int reserveOutput(struct serverConnection * connection, int length) {
+    // Make room for length more bytes of replies. Returns 0 if the buffer would grow past SERVER_OUTPUT_MAX or
+    // can't grow.
+    if(connection->outputLength + length <= connection->outputCapacity) {
+        return 1;
+    }
+    int newCapacity = connection->outputCapacity ? connection->outputCapacity : SERVER_OUTPUT_SIZE;
+    while(newCapacity < connection->outputLength + length && newCapacity < SERVER_OUTPUT_MAX) {
+        newCapacity *= 2;
+    }
+    if(newCapacity < connection->outputLength + length) {
+        return 0;
+    }
+    char * tempPointer = (char *) realloc(connection->output, newCapacity);
+    if(!tempPointer) {
+        return 0;
+    }
+    connection->output = tempPointer;
+    connection->outputCapacity = newCapacity;
+    return 1;
+}
+
+static void reply(struct serverConnection * connection, const char * format, ...) {
+    // Queue one reply line. If the client isn't reading its replies, give up on it.
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(NULL, 0, format, arguments);
+    va_end(arguments);
+
+    // Room for the newline, and the terminator vsnprintf writes.
+    if(length < 0 || length > SERVER_OUTPUT_MAX || !reserveOutput(connection, length + 2)) {
+        connection->closing = 1;
+        return;
+    }
+    va_start(arguments, format);
+    vsnprintf(connection->output + connection->outputLength, length + 1, format, arguments);
+    va_end(arguments);
+    connection->outputLength += length;
+    connection->output[connection->outputLength++] = '\n';
+}
+
+static int sendReplies(struct serverState * server, struct serverConnection * connection) {
+    // Send as much as the socket takes, and wait for it to drain if it doesn't take everything.
+    // Returns 0 if the connection failed.
+    int sent = 0;
+    while(sent < connection->outputLength) {
+        ssize_t count = send(connection->socket, connection->output + sent, connection->outputLength - sent,
+                             MSG_NOSIGNAL);
+        if(count > 0) {
+            sent += (int) count;
+        }
+        else if(count == -1 && errno == EINTR) {
+            continue;
+        }
+        else if(count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        else {
+            return 0;
+        }
+    }
+
+    if(sent > 0) {
+        memmove(connection->output, connection->output + sent, connection->outputLength - sent);
+        connection->outputLength -= sent;
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN | (connection->outputLength ? EPOLLOUT : 0);
+    event.data.ptr = connection;
+    return epoll_ctl(server->epoll, EPOLL_CTL_MOD, connection->socket, &event) != -1;
+}
+
+static void closeConnection(struct serverState * server, struct serverConnection * connection) {
+    // Closing the socket also removes it from epoll.
+    close(connection->socket);
+    if(connection->previous) {
+        connection->previous->next = connection->next;
+    }
+    else {
+        server->connections = connection->next;
+    }
+    if(connection->next) {
+        connection->next->previous = connection->previous;
+    }
+    server->connectionCount--;
+    free(connection->output);
+    free(connection);
+}
+
+static void acceptConnections(struct serverState * server) {
+    // Accept every waiting connection.
+    while(1) {
+        int socketFd = accept(server->listenSocket, NULL, NULL);
+        if(socketFd == -1) {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                logMessage(LOG_WARNING, ERROR_NONE, "server: accept failed, errno %d", errno);
+            }
+            return;
+        }
+
+        struct serverConnection * connection = NULL;
+        if(setNonBlocking(socketFd)) {
+            connection = (struct serverConnection *) calloc(1, sizeof(struct serverConnection));
+        }
+        if(!connection) {
+            logMessage(LOG_ERROR, ERROR_OUT_OF_MEMORY, "server: failed to set up a connection");
+            close(socketFd);
+            continue;
+        }
+        connection->socket = socketFd;
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if(epoll_ctl(server->epoll, EPOLL_CTL_ADD, socketFd, &event) == -1) {
+            close(socketFd);
+            free(connection);
+            continue;
+        }
+
+        connection->next = server->connections;
+        if(server->connections) {
+            server->connections->previous = connection;
+        }
+        server->connections = connection;
+        server->connectionCount++;
+    }
+}
+
+// COMMANDS ------------------------------------------------------------------------------------------------------------
+static struct gameSession * findSession(struct serverState * server, const char * idText) {
+    int id = idText ? atoi(idText) : 0;
+    if(id < 1 || id > server->maxSessions) {
+        return NULL;
+    }
+    return server->sessions[id - 1];
+}
+
+static const char * getStateName(int state) {
+    if(state == SESSION_CHECKMATE) {
+        return "checkmate";
+    }
+    if(state == SESSION_TIMEOUT) {
+        return "timeout";
+    }
+    if(state == SESSION_STALEMATE) {
+        return "stalemate";
+    }
+    if(state == SESSION_DRAW) {
+        return "draw";
+    }
+    return "active";
+}
+
+static void handleCommand(struct serverState * server, struct serverConnection * connection, char * line) {
+    char * command = strtok(line, " \t\r");
+    char * argument1 = strtok(NULL, " \t\r");
+    char * argument2 = strtok(NULL, " \t\r");
+
+    if(!command) {
+        return;
+    }
+
+    if(!strcmp(command, "new")) {
+        double baseSeconds = argument1 ? atof(argument1) : 0;
+        double incrementSeconds = argument2 ? atof(argument2) : 0;
+        if(server->freeIdCount == 0) {
+            reply(connection, "error server full");
+            return;
+        }
+        int id = server->freeIds[server->freeIdCount - 1];
+        struct gameSession * session = createSession(id, baseSeconds, incrementSeconds);
+        if(!session) {
+            logMessage(LOG_ERROR, ERROR_OUT_OF_MEMORY, "server: failed to create session %d", id);
+            reply(connection, "error out of memory");
+            return;
+        }
+        server->freeIdCount--;
+        server->sessions[id - 1] = session;
+        server->sessionCount++;
+        reply(connection, "ok %d", id);
+        return;
+    }
+
+    if(!strcmp(command, "stats")) {
+        size_t bytes = 0;
+        for(int i = 0; i < server->maxSessions; i++) {
+            if(server->sessions[i]) {
+                bytes += getSessionMemory(server->sessions[i]);
+            }
+        }
+        // Pool occupancy on the same line
+        char pools[256];
+        int length = 0;
+        struct poolStats stats[POOL_MAX_POOLS];
+        int poolCount = getAllPoolStats(stats, POOL_MAX_POOLS);
+        pools[0] = '\0';
+        for(int i = 0; i < poolCount && length < (int) sizeof(pools) - 64; i++) {
+            length += sprintf(pools + length, " pool %s %ld/%ld", stats[i].name, stats[i].inUse, stats[i].capacity);
+        }
+        reply(connection, "ok sessions %d connections %d bytes %zu%s", server->sessionCount, server->connectionCount,
+              bytes, pools);
+        return;
+    }
+
+    if(!strcmp(command, "quit")) {
+        connection->closing = 1;
+        return;
+    }
+
+    // The rest of the commands are about one game.
+    struct gameSession * session = findSession(server, argument1);
+    if(strcmp(command, "move") && strcmp(command, "show") && strcmp(command, "moves") && strcmp(command, "close")) {
+        reply(connection, "error unknown command");
+        return;
+    }
+    if(!session) {
+        reply(connection, "error unknown game");
+        return;
+    }
+
+    if(!strcmp(command, "move")) {
+        int move = argument2 ? coordinateToMove(argument2, (int) strlen(argument2)) : MOVE_NONE;
+        int result = (move == MOVE_NONE) ? SUBMIT_ILLEGAL : submitMove(session, move);
+        // submitMove tags log messages with the game, the server's own messages aren't about a game.
+        setLogContext(0, 0);
+
+        if(result == SUBMIT_OK && session->state == SESSION_ACTIVE) {
+            reply(connection, "ok active");
+        }
+        else if(result == SUBMIT_OK) {
+            reply(connection, "ok %s %d", getStateName(session->state), session->winner);
+        }
+        else if(result == SUBMIT_KING_CHECKED) {
+            reply(connection, "error king checked");
+        }
+        else if(result == SUBMIT_GAME_OVER) {
+            reply(connection, "error game over %s %d", getStateName(session->state), session->winner);
+        }
+        else if(result == SUBMIT_NO_MEMORY) {
+            reply(connection, "error out of memory");
+        }
+        else {
+            reply(connection, "error illegal move");
+        }
+    }
+    else if(!strcmp(command, "show")) {
+        char fen[FEN_MAX_LENGTH];
+        updateSessionClock(session);
+        writeFen(&session->position, fen);
+        reply(connection, "ok %s %s %d %.1f %.1f", fen, getStateName(session->state), session->winner,
+              getSessionClock(session, 1), getSessionClock(session, 2));
+    }
+    else if(!strcmp(command, "moves")) {
+        // Build the list first, reply grows the output buffer to fit it.
+        char * list = (char *) malloc(((size_t) session->moveCount * 6) + 1);
+        if(!list) {
+            reply(connection, "error out of memory");
+            return;
+        }
+        int length = 0;
+        for(int i = 0; i < session->moveCount; i++) {
+            if(i) {
+                list[length++] = ' ';
+            }
+            moveToCoordinate(session->moves[i], list + length);
+            length += (int) strlen(list + length);
+        }
+        list[length] = '\0';
+        reply(connection, "ok %s", list);
+        free(list);
+    }
+    else {
+        server->sessions[session->id - 1] = NULL;
+        server->freeIds[server->freeIdCount++] = session->id;
+        server->sessionCount--;
+        freeSession(session);
+        reply(connection, "ok");
+    }
+}
+
+static int readCommands(struct serverState * server, struct serverConnection * connection) {
+    // Read what the client sent and run every complete line. Returns 0 if the connection is done.
+    while(1) {
+        int room = SERVER_LINE_LENGTH - connection->inputLength;
+        ssize_t count = recv(connection->socket, connection->input + connection->inputLength, room, 0);
+        if(count == 0) {
+            return 0;
+        }
+        if(count == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection->inputLength += (int) count;
+
+        // Run complete lines
+        int start = 0;
+        for(int i = 0; i < connection->inputLength; i++) {
+            if(connection->input[i] == '\n') {
+                connection->input[i] = '\0';
+                handleCommand(server, connection, connection->input + start);
+                start = i + 1;
+                if(connection->closing) {
+                    return 1;
+                }
+            }
+        }
+        memmove(connection->input, connection->input + start, connection->inputLength - start);
+        connection->inputLength -= start;
+
+        if(connection->inputLength == SERVER_LINE_LENGTH) {
+            reply(connection, "error line too long");
+            connection->closing = 1;
+            return 1;
+        }
+    }
+}
+
+// PUBLIC FUNCTIONS ----------------------------------------------------------------------------------------------------
+int runServer(const char * address, int maxSessions) {
+    // Host games until interrupted with ctrl-c or SIGTERM. Returns 1 on a clean shutdown, 0 on failure.
+    struct serverState server;
+    memset(&server, 0, sizeof(server));
+    server.maxSessions = maxSessions;
+    server.epoll = -1;
+
+    server.sessions = (struct gameSession **) calloc(maxSessions, sizeof(struct gameSession *));
+    server.freeIds = (int *) malloc(maxSessions * sizeof(int));
+    server.listenSocket = openSocket(address, 1);
+    if(server.listenSocket != -1 && setNonBlocking(server.listenSocket)) {
+        server.epoll = epoll_create1(0);
+    }
+    if(!server.sessions || !server.freeIds || server.epoll == -1) {
+        fprintf(stderr, "Failed to start the server on %s.\n", address);
+        if(server.listenSocket != -1) {
+            close(server.listenSocket);
+        }
+        free(server.sessions);
+        free(server.freeIds);
+        return 0;
+    }
+
+    // Smallest ids are handed out first.
+    for(int i = 0; i < maxSessions; i++) {
+        server.freeIds[i] = maxSessions - i;
+    }
+    server.freeIdCount = maxSessions;
+    reserveSessions((maxSessions < SERVER_RESERVED_SESSIONS) ? maxSessions : SERVER_RESERVED_SESSIONS);
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.listenSocket, &event);
+
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+
+    printf("Serving up to %d games on %s, stop with ctrl-c.\n", maxSessions, address);
+    fflush(stdout);
+    logMessage(LOG_INFO, ERROR_NONE, "server: listening on %s", address);
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while(!serverStopping) {
+        int eventCount = epoll_wait(server.epoll, events, SERVER_MAX_EVENTS, -1);
+        if(eventCount == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            logMessage(LOG_ERROR, ERROR_NONE, "server: epoll_wait failed, errno %d", errno);
+            break;
+        }
+
+        for(int i = 0; i < eventCount; i++) {
+            struct serverConnection * connection = (struct serverConnection *) events[i].data.ptr;
+            if(!connection) {
+                acceptConnections(&server);
+                continue;
+            }
+
+            int ok = 1;
+            if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                ok = readCommands(&server, connection);
+            }
+            if(ok) {
+                ok = sendReplies(&server, connection);
+            }
+            if(!ok || (connection->closing && connection->outputLength == 0)) {
+                closeConnection(&server, connection);
+            }
+        }
+    }
+
+    printf("Server stopped with %d games and %d connections open.\n", server.sessionCount, server.connectionCount);
+    printPoolStats(stdout);
+    logMessage(LOG_INFO, ERROR_NONE, "server: stopped with %d games open", server.sessionCount);
+
+    while(server.connections) {
+        closeConnection(&server, server.connections);
+    }
+    for(int i = 0; i < maxSessions; i++) {
+        freeSession(server.sessions[i]);
+    }
+    close(server.listenSocket);
+    close(server.epoll);
+    if(!strncmp(address, "unix:", 5)) {
+        unlink(address + 5);
+    }
+    free(server.sessions);
+    free(server.freeIds);
+    return 1;
+}
+
+int runClient(const char * address) {
+    // Send each line of standard input to the server and print its reply. Returns 1 on success.
+    int socketFd = openSocket(address, 0);
+    if(socketFd == -1) {
+        fprintf(stderr, "Failed to connect to %s.\n", address);
+        return 0;
+    }
+    FILE * replies = fdopen(socketFd, "r");
+    if(!replies) {
+        close(socketFd);
+        return 0;
+    }
+
+    char line[SERVER_LINE_LENGTH];
+    char replyLine[SERVER_OUTPUT_SIZE];
+    while(fgets(line, sizeof(line), stdin)) {
+        size_t length = strlen(line);
+        if(length == 0 || line[length - 1] != '\n') {
+            if(length + 1 >= sizeof(line)) {
+                fprintf(stderr, "Line too long.\n");
+                break;
+            }
+            line[length++] = '\n';
+        }
+        if(send(socketFd, line, length, MSG_NOSIGNAL) != (ssize_t) length) {
+            break;
+        }
+
+        // Every command except quit and empty lines gets one reply line.
+        char * command = line + strspn(line, " \t\r");
+        if(!strncmp(command, "quit", 4) || *command == '\n') {
+            continue;
+        }
+        // A long reply comes in more than one piece.
+        int replyDone = 0;
+        while(!replyDone && fgets(replyLine, sizeof(replyLine), replies)) {
+            fputs(replyLine, stdout);
+            replyDone = replyLine[strlen(replyLine) - 1] == '\n';
+        }
+        fflush(stdout);
+        if(!replyDone) {
+            break;
+        }
+    }
+
+    fclose(replies);
+    return 1;
+}
@@ -0,0 +1,16 @@
+/*
+File:           Server.h
+Author:         Toni Lindeman
+Description:    Game server hosting many sessions over a local socket, and a simple client for it.
+*/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+// Sessions one server hosts by default.
+#define SERVER_DEFAULT_SESSIONS 10000
+
+int runServer(const char * address, int maxSessions);
+int runClient(const char * address);
+
+#endif /* SERVER_H */
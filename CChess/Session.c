@@ -0,0 +1,219 @@
+/*
+File:           Session.c
+Author:         Toni Lindeman
+Description:    Game sessions: the state of one game in a struct, played one submitted move at a time.
+
+playGame keeps its game in local variables and waits for the player at the terminal. A session holds the same
+state in a struct, so any number of games can be kept at once and moved along whenever a move arrives.
+submitMove never waits for anything: it referees the move with refereeMove, updates the clock and tells whether
+the game is over, by checkmate, stalemate or one of the draw rules, decided from the legal moves like in playGame.
+
+Sessions, their boards and their first SESSION_MOVE_BLOCK moves come from object pools (Pool.c), so a server
+starting and ending thousands of games doesn't go to malloc for them. Only a game longer than that grows its
+move record with realloc. A session takes under 4 KB, boards and move block included: of the position keys it
+keeps only the last SESSION_KEY_RING, as far back as the draw rules can look.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "OSSpecific.h"
+#include "ChessPiece.h"
+#include "Chessboard.h"
+#include "Gameplay.h"
+#include "Position.h"
+#include "MoveGen.h"
+#include "Log.h"
+#include "Pool.h"
+#include "Session.h"
+
+static struct objectPool sessionPool = POOL_INITIALIZER("sessions", POOL_ID_SESSIONS, sizeof(struct gameSession), 64);
+static struct objectPool moveRecordPool = POOL_INITIALIZER("moves", POOL_ID_MOVE_RECORDS,
+                                                           SESSION_MOVE_BLOCK * sizeof(int), 64);
+
+int reserveSessions(long count) {
+    // Grow the pools up front to hold count sessions. Returns 0 if out of memory.
+    return reservePoolObjects(&sessionPool, count) && reservePoolObjects(&moveRecordPool, count) &&
+           reserveChessboards(2 * count);
+}
+
+struct gameSession * createSession(int id, double baseSeconds, double incrementSeconds) {
+    // New game from the standard setup, player 1 to move. baseSeconds 0 means no clock.
+    // Returns NULL if memory allocation fails.
+    struct gameSession * session = (struct gameSession *) acquirePoolObject(&sessionPool);
+    if(!session) {
+        return NULL;
+    }
+    memset(session, 0, sizeof(struct gameSession));
+
+    session->chessboard = getInitChessboard();
+    session->chessboardPrevious = getEmptyChessboard();
+    session->moves = (int *) acquirePoolObject(&moveRecordPool);
+    session->moveCapacity = SESSION_MOVE_BLOCK;
+    if(!session->chessboard || !session->chessboardPrevious || !session->moves) {
+        return freeSession(session);
+    }
+    copyChessboard(session->chessboard, session->chessboardPrevious);
+    setInitialPosition(&session->position);
+
+    session->id = id;
+    session->turn = 1;
+    session->state = SESSION_ACTIVE;
+    session->drawReason = DRAW_NONE;
+    session->hasClock = baseSeconds > 0;
+    session->clocks[1] = baseSeconds;
+    session->clocks[2] = baseSeconds;
+    session->incrementSeconds = incrementSeconds;
+    session->turnStartTime = getTimeSeconds();
+
+    return session;
+}
+
+struct gameSession * freeSession(struct gameSession * session) {
+    // Returns NULL so the caller can clear their pointer in the same line.
+    if(session) {
+        freeChessboardMemory(session->chessboard);
+        freeChessboardMemory(session->chessboardPrevious);
+        // Records that outgrew their block were moved to malloc'd memory.
+        if(session->moveCapacity == SESSION_MOVE_BLOCK) {
+            releasePoolObject(&moveRecordPool, session->moves);
+        }
+        else {
+            free(session->moves);
+        }
+        releasePoolObject(&sessionPool, session);
+    }
+    return NULL;
+}
+
+int updateSessionClock(struct gameSession * session) {
+    // Check if the player in turn has run out of time. Returns the session state.
+    if(session->state == SESSION_ACTIVE && session->hasClock &&
+       getSessionClock(session, session->turn) <= 0) {
+        session->state = SESSION_TIMEOUT;
+        session->clocks[session->turn] = 0;
+        session->winner = (session->turn % 2) + 1;
+    }
+    return session->state;
+}
+
+double getSessionClock(const struct gameSession * session, int player) {
+    // Seconds left for player, counting the current turn. 0 if the game has no clock.
+    if(!session->hasClock) {
+        return 0;
+    }
+    double seconds = session->clocks[player];
+    if(player == session->turn && session->state == SESSION_ACTIVE) {
+        seconds -= getTimeSeconds() - session->turnStartTime;
+    }
+    return seconds;
+}
+
+size_t getSessionMemory(const struct gameSession * session) {
+    // Bytes of memory held by the session.
+    return sizeof(struct gameSession) + (2 * 64 * sizeof(struct chessPiece)) +
+           ((size_t)session->moveCapacity * sizeof(int));
+}
+
+static int getSessionDrawReason(const struct gameSession * session) {
+    // getDrawReason on the session's ring of keys. Like countRepetitions, only positions with the same player in
+    // turn and since the last capture or pawn move are compared, and those are all still in the ring.
+    const struct position * pos = &session->position;
+    if(isInsufficientMaterial(pos)) {
+        return DRAW_INSUFFICIENT_MATERIAL;
+    }
+    if(pos->halfmoveClock >= FIFTY_MOVE_PLIES) {
+        return DRAW_FIFTY_MOVES;
+    }
+
+    int repetitions = 0;
+    for(int plies = 4; plies <= pos->halfmoveClock && plies <= session->moveCount; plies += 2) {
+        if(session->keys[(session->moveCount - plies) % SESSION_KEY_RING] == pos->key) {
+            repetitions++;
+        }
+    }
+    return (repetitions >= 2) ? DRAW_REPETITION : DRAW_NONE;
+}
+
+int submitMove(struct gameSession * session, int move) {
+    // Make a move for the player in turn. A pawn reaching the last row without a promotion becomes a queen.
+    // Returns one of the SUBMIT_ results, SUBMIT_OK means the move was made. Check the session state after a
+    // made move, it may have ended the game.
+    if(updateSessionClock(session) != SESSION_ACTIVE) {
+        return SUBMIT_GAME_OVER;
+    }
+
+    // Errors logged while refereeing are tagged with this game.
+    setLogContext(session->id, (session->moveCount / 2) + 1);
+
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int promotion = MOVE_PROMOTION(move);
+    if(session->chessboard[from].rank == 1 && (SQUARE_ROW(to) == 0 || SQUARE_ROW(to) == 7) && promotion == 0) {
+        promotion = 5;
+        move = MOVE_ENCODE(from, to, promotion);
+    }
+
+    // Make room in the record first, so a made move is always recorded.
+    if(session->moveCount == session->moveCapacity) {
+        int newCapacity = 2 * session->moveCapacity;
+        int * tempPointer = NULL;
+        if(session->moveCapacity == SESSION_MOVE_BLOCK) {
+            // Leave the pool block
+            tempPointer = (int *) malloc(newCapacity * sizeof(int));
+            if(tempPointer) {
+                memcpy(tempPointer, session->moves, session->moveCount * sizeof(int));
+                releasePoolObject(&moveRecordPool, session->moves);
+            }
+        }
+        else {
+            tempPointer = (int *) realloc(session->moves, newCapacity * sizeof(int));
+        }
+        if(!tempPointer) {
+            logMessage(LOG_ERROR, ERROR_OUT_OF_MEMORY, "submitMove: failed to grow the move record");
+            return SUBMIT_NO_MEMORY;
+        }
+        session->moves = tempPointer;
+        session->moveCapacity = newCapacity;
+    }
+
+    uint64_t keyBefore = session->position.key;
+    int result = refereeMove(&session->position, session->chessboard, session->chessboardPrevious, SQUARE_ROW(from),
+                             SQUARE_COLUMN(from), SQUARE_ROW(to), SQUARE_COLUMN(to), promotion, &move);
+    if(result != 1) {
+        return (result == -1) ? SUBMIT_KING_CHECKED : SUBMIT_ILLEGAL;
+    }
+    session->keys[session->moveCount % SESSION_KEY_RING] = keyBefore;
+    session->moves[session->moveCount++] = move;
+
+    // Stop the mover's clock
+    double now = getTimeSeconds();
+    if(session->hasClock) {
+        session->clocks[session->turn] -= now - session->turnStartTime;
+        session->clocks[session->turn] += session->incrementSeconds;
+    }
+    session->turnStartTime = now;
+
+    // Change player turn and see if the game is over, exactly as in playGame.
+    int player = session->turn;
+    session->turn = (player % 2) + 1;
+    struct moveList legalMoves;
+    generateLegalMoves(&session->position, &legalMoves);
+    if(legalMoves.count == 0) {
+        if(isPlayerInCheck(&session->position, session->turn)) {
+            session->state = SESSION_CHECKMATE;
+            session->winner = player;
+        }
+        else {
+            session->state = SESSION_STALEMATE;
+        }
+        return SUBMIT_OK;
+    }
+
+    session->drawReason = getSessionDrawReason(session);
+    if(session->drawReason != DRAW_NONE) {
+        session->state = SESSION_DRAW;
+    }
+
+    return SUBMIT_OK;
+}
@@ -0,0 +1,72 @@
+/*
+File:           Session.h
+Author:         Toni Lindeman
+Description:    Game sessions: the state of one game in a struct, played one submitted move at a time.
+*/
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ChessPiece.h"
+#include "Position.h"
+
+// Session states
+#define SESSION_ACTIVE 0
+#define SESSION_CHECKMATE 1
+#define SESSION_TIMEOUT 2
+// The player in turn has no legal moves and is not in check.
+#define SESSION_STALEMATE 3
+// Drawn by repetition, the fifty move rule or insufficient material (see getDrawReason).
+#define SESSION_DRAW 4
+
+// Moves a session records before its record has to leave the pool (see Session.c).
+#define SESSION_MOVE_BLOCK 256
+// Position keys a session keeps for the draw rules. No repetition reaches past the last capture or pawn move, and
+// the fifty move rule ends the game at FIFTY_MOVE_PLIES of those.
+#define SESSION_KEY_RING (FIFTY_MOVE_PLIES + 1)
+
+// submitMove results
+#define SUBMIT_OK 1
+#define SUBMIT_ILLEGAL 0
+#define SUBMIT_KING_CHECKED -1
+#define SUBMIT_GAME_OVER -2
+#define SUBMIT_NO_MEMORY -3
+
+struct gameSession {
+    int id;
+    struct chessPiece * chessboard;
+    struct chessPiece * chessboardPrevious;
+    // The same game as a position, with the castling rights and en passant square the chessboard can't hold.
+    struct position position;
+    int turn;
+    int state;
+    // Player number of the winner, 0 while the game is on and for a draw.
+    int winner;
+    // DRAW_ reason of a SESSION_DRAW, DRAW_NONE otherwise.
+    int drawReason;
+    // Seconds left per player (index 1 and 2), no clock when increment and clocks are 0.
+    double clocks[3];
+    double incrementSeconds;
+    int hasClock;
+    // When the player in turn started thinking.
+    double turnStartTime;
+    // Moves made from the initial setup, encoded as in Position.h.
+    int * moves;
+    int moveCount;
+    int moveCapacity;
+    // Keys of the positions before the last SESSION_KEY_RING moves, for the draw rules. The key before move i is
+    // at keys[i % SESSION_KEY_RING].
+    uint64_t keys[SESSION_KEY_RING];
+};
+
+struct gameSession * createSession(int id, double baseSeconds, double incrementSeconds);
+struct gameSession * freeSession(struct gameSession * session);
+int submitMove(struct gameSession * session, int move);
+int updateSessionClock(struct gameSession * session);
+double getSessionClock(const struct gameSession * session, int player);
+size_t getSessionMemory(const struct gameSession * session);
+int reserveSessions(long count);
+
+#endif /* SESSION_H */
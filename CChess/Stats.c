@@ -0,0 +1,163 @@
+/*
+File:           Stats.c
+Author:         Toni Lindeman
+Description:    Optional call and cycle counters for the rule checking hot path.
+
+Every thread gets its own counters on its first counted call, so counting needs no locking. The counters are
+kept in a list until the program exits, so a dump also shows threads that have already finished.
+By default the counters are printed as a table to stderr at exit, set CCHESS_STATS=json for JSON instead.
+They can also be printed while the program runs, e.g. in the middle of a long match, with "kill -USR1 <pid>".
+A thread of its own waits for the signal, so the dump can take the lock like any other caller of printStats.
+*/
+
+// sigwait and pthread_sigmask are POSIX, not part of C11.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include "Stats.h"
+
+static const char * statNames[STAT_COUNT] = {
+    "validateAndMakeMove", "checkForCheckedKing", "checkForCheckmate", "findAttackerCoordinates",
+    "copyChessboard", "malloc", "free"
+};
+
+#ifdef CCHESS_STATS
+
+_Thread_local struct statsThread * statsCurrentThread = NULL;
+
+static pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+static struct statsThread * statsThreads = NULL;
+static int statsThreadCount = 0;
+
+struct statsThread * registerStatsThread() {
+    // Called once per thread. If this allocation fails there is nothing sensible to count with.
+    struct statsThread * stats = (struct statsThread *) calloc(1, sizeof(struct statsThread));
+    if(!stats) {
+        fprintf(stderr, "Failed to allocate statistics counters.\n");
+        exit(1);
+    }
+
+    pthread_mutex_lock(&statsLock);
+    stats->id = statsThreadCount++;
+    stats->next = statsThreads;
+    statsThreads = stats;
+    pthread_mutex_unlock(&statsLock);
+
+    statsCurrentThread = stats;
+    return stats;
+}
+
+static void printStatsRow(FILE * file, const char * thread, int counter, uint64_t calls, uint64_t cycles) {
+    fprintf(file, "%-8s %-24s %14llu %16llu %12.1f\n", thread, statNames[counter], (unsigned long long) calls,
+            (unsigned long long) cycles, calls ? (double) cycles / (double) calls : 0.0);
+}
+
+static void printJsonCounters(FILE * file, const uint64_t * calls, const uint64_t * cycles) {
+    fprintf(file, "{");
+    for(int i = 0; i < STAT_COUNT; i++) {
+        fprintf(file, "%s\"%s\":{\"calls\":%llu,\"cycles\":%llu}", i ? "," : "", statNames[i],
+                (unsigned long long) calls[i], (unsigned long long) cycles[i]);
+    }
+    fprintf(file, "}");
+}
+
+void printStats(FILE * file, int json) {
+    // Print the counters of every thread and the totals. Can be called at any time, counts of running threads
+    // may be slightly behind.
+    uint64_t totalCalls[STAT_COUNT] = {0};
+    uint64_t totalCycles[STAT_COUNT] = {0};
+
+    pthread_mutex_lock(&statsLock);
+
+    if(json) {
+        fprintf(file, "{\"threads\":[");
+    }
+    else {
+        fprintf(file, "%-8s %-24s %14s %16s %12s\n", "Thread", "Counter", "Calls", "Cycles", "Cycles/call");
+    }
+
+    for(struct statsThread * stats = statsThreads; stats; stats = stats->next) {
+        char thread[16];
+        snprintf(thread, sizeof(thread), "%d", stats->id);
+
+        if(json) {
+            fprintf(file, "%s{\"thread\":%d,\"counters\":", stats == statsThreads ? "" : ",", stats->id);
+            printJsonCounters(file, stats->calls, stats->cycles);
+            fprintf(file, "}");
+        }
+        for(int i = 0; i < STAT_COUNT; i++) {
+            if(!json && stats->calls[i]) {
+                printStatsRow(file, thread, i, stats->calls[i], stats->cycles[i]);
+            }
+            totalCalls[i] += stats->calls[i];
+            totalCycles[i] += stats->cycles[i];
+        }
+    }
+
+    if(json) {
+        fprintf(file, "],\"total\":");
+        printJsonCounters(file, totalCalls, totalCycles);
+        fprintf(file, "}\n");
+    }
+    else {
+        for(int i = 0; i < STAT_COUNT; i++) {
+            printStatsRow(file, "total", i, totalCalls[i], totalCycles[i]);
+        }
+    }
+
+    pthread_mutex_unlock(&statsLock);
+}
+
+static void printStatsToStderr() {
+    const char * format = getenv("CCHESS_STATS");
+    printStats(stderr, format && !strcmp(format, "json"));
+}
+
+static void * statsSignalWorker(void * argument) {
+    // Print the counters every time the process gets SIGUSR1.
+    const sigset_t * signals = (const sigset_t *) argument;
+    int signalNumber;
+    while(sigwait(signals, &signalNumber) == 0) {
+        printStatsToStderr();
+    }
+    return NULL;
+}
+
+void initStats() {
+    // Call once at program start, before any other thread is started, to get the counters printed at exit and
+    // on SIGUSR1. Threads inherit the blocked signal, so only the signal thread ever receives it.
+    static sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    pthread_t thread;
+    if(pthread_sigmask(SIG_BLOCK, &signals, NULL) == 0 &&
+       pthread_create(&thread, NULL, statsSignalWorker, &signals) == 0) {
+        pthread_detach(thread);
+    }
+    else {
+        fprintf(stderr, "Failed to start the statistics signal thread, counters are printed at exit only.\n");
+    }
+    atexit(printStatsToStderr);
+}
+
+#else
+
+void initStats() {
+}
+
+void printStats(FILE * file, int json) {
+    // Keeps callers simple, they don't need to know how the program was built.
+    (void) statNames;
+    if(json) {
+        fprintf(file, "{\"threads\":[],\"error\":\"statistics are not compiled in\"}\n");
+    }
+    else {
+        fprintf(file, "Statistics are not compiled in, build with make STATS=1.\n");
+    }
+}
+
+#endif /* CCHESS_STATS */
@@ -0,0 +1,78 @@
+/*
+File:           Stats.h
+Author:         Toni Lindeman
+Description:    Optional call and cycle counters for the rule checking hot path.
+
+Build with "make STATS=1" to count calls, or "make STATS=2" to also count cycles with rdtsc (x86 only).
+In a normal build the macros below expand to nothing, so the counted functions are exactly as fast as before.
+The counters are printed at exit, and any time the program gets SIGUSR1 ("kill -USR1 <pid>").
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Counted functions and allocations
+#define STAT_VALIDATE_AND_MAKE_MOVE 0
+#define STAT_CHECK_FOR_CHECKED_KING 1
+#define STAT_CHECK_FOR_CHECKMATE 2
+#define STAT_FIND_ATTACKER_COORDINATES 3
+#define STAT_COPY_CHESSBOARD 4
+#define STAT_MALLOC 5
+#define STAT_FREE 6
+#define STAT_COUNT 7
+
+#ifdef CCHESS_STATS
+
+#if defined(CCHESS_STATS_CYCLES) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define STATS_READ_CYCLES() __rdtsc()
+#else
+#define STATS_READ_CYCLES() 0
+#endif
+
+// Counters of one thread. Threads only ever write their own.
+struct statsThread {
+    uint64_t calls[STAT_COUNT];
+    uint64_t cycles[STAT_COUNT];
+    int id;
+    struct statsThread * next;
+};
+
+struct statsScope {
+    int counter;
+    uint64_t start;
+};
+
+extern _Thread_local struct statsThread * statsCurrentThread;
+struct statsThread * registerStatsThread();
+
+static inline uint64_t beginStatsScope(int counter) {
+    struct statsThread * stats = statsCurrentThread ? statsCurrentThread : registerStatsThread();
+    stats->calls[counter]++;
+    return STATS_READ_CYCLES();
+}
+
+static inline void endStatsScope(struct statsScope * scope) {
+    // Cycles are inclusive, e.g. checkForCheckmate's include the validateAndMakeMove calls it makes.
+    statsCurrentThread->cycles[scope->counter] += STATS_READ_CYCLES() - scope->start;
+}
+
+// First line of a counted function. The scope ends, and cycles are added, on every return.
+#define STATS_FUNCTION(counter) \
+    struct statsScope statsScope __attribute__((cleanup(endStatsScope))) = {(counter), beginStatsScope(counter)}
+#define STATS_ALLOCATION(counter) ((void) beginStatsScope(counter))
+
+#else
+
+#define STATS_FUNCTION(counter)
+#define STATS_ALLOCATION(counter)
+
+#endif /* CCHESS_STATS */
+
+void initStats();
+void printStats(FILE * file, int json);
+
+#endif /* STATS_H */
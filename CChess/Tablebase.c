@@ -0,0 +1,865 @@
+/*
+File:           Tablebase.c
+Author:         Toni Lindeman
+Description:    Endgame tablebases: retrograde generation and memory mapped probing.
+
+Table layout:
+One table per material signature, e.g. KRvKN. Player 1 is always the side with more material, positions with
+colors the other way around are flipped before probing. A table has one byte per index:
+    0           draw
+    1 - 127     player in turn mates in that many moves
+    128 - 254   player in turn gets mated in (value - 128) moves
+    255         illegal position, or a symmetric duplicate of another index
+The index is (player in turn, slot of player 1's king, squares of the other pieces). Symmetry keeps player 1's
+king in the a1-d1-d4 triangle (pawnless) or on files a-d (with pawns), so tables are index addressed with no
+search, and a probe is one memory read from the mapped file.
+
+Generation:
+Retrograde analysis, one distance in plies at a time. Every position first counts its moves that stay in the
+table; captures and promotions are looked up from the smaller tables, which are built first. Then, starting
+from the checkmates, positions resolved at distance N are unmade one move backwards: a predecessor of a loss is
+a win at N + 1, a predecessor whose every move leads to the opponent's win is a loss. Whatever is left in the
+end is a draw. The work of every step is split between threads.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "OSSpecific.h"
+#include "MoveGen.h"
+#include "Tablebase.h"
+
+#define TABLE_MAX_COUNT 256
+// Must be a power of two.
+#define TABLE_HASH_SIZE 1024
+#define TABLE_NAME_LENGTH 16
+#define TABLE_PATH_LENGTH 512
+
+// Table bytes
+#define BYTE_DRAW 0
+#define BYTE_LOSS 128
+#define BYTE_ILLEGAL 255
+// Longest distance a byte can hold.
+#define MAX_PLIES 252
+
+// Generation states. Resolved positions store the distance in plies and one bit for win / loss.
+#define STATE_UNKNOWN -1
+#define STATE_ILLEGAL -2
+#define STATE_DRAW -3
+#define STATE_WIN(plies) ((short)(((plies) << 1) | 1))
+#define STATE_LOSS(plies) ((short)((plies) << 1))
+#define STATE_PLIES(state) ((state) >> 1)
+#define STATE_IS_WIN(state) ((state) & 1)
+
+// Best result through captures and promotions, from the point of view of the player in turn.
+#define EXIT_NONE -32000
+#define EXIT_WIN(plies) (1000 - (plies))
+#define EXIT_LOSS(plies) (-1000 + (plies))
+
+// Indexes a thread takes at a time.
+#define WORK_BLOCK 65536
+
+// Piece order inside a side: queen, rook, bishop, knight, pawn.
+static const int rankOrder[5] = {5, 2, 4, 3, 1};
+static const char rankLetters[7] = {' ', 'P', 'R', 'N', 'B', 'Q', 'K'};
+
+static const int knightJumps[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+static const int kingSteps[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+struct tablebaseTable {
+    char name[TABLE_NAME_LENGTH];
+    // Pieces in index order: the two kings, then player 1's pieces and then player 2's.
+    int pieceCount;
+    int ranks[TABLEBASE_MAX_PIECES];
+    int owners[TABLEBASE_MAX_PIECES];
+    int pawnCount;
+    long size;
+    uint64_t materialKey;
+    const unsigned char * data;
+    size_t mappedSize;
+};
+
+struct tablebaseGenerator {
+    struct tablebaseTable * table;
+    atomic_short * states;
+    atomic_uchar * counters;
+    short * exits;
+    int level;
+    int threadCount;
+    atomic_long nextIndex;
+    atomic_int maxPlies;
+    atomic_int missingTable;
+    void (* work)(struct tablebaseGenerator * generator, long start, long end);
+};
+
+int tablebasePieces = 0;
+
+static struct tablebaseTable tables[TABLE_MAX_COUNT];
+static int tableCount = 0;
+// Table index + 1 by material key, 0 for an empty slot.
+static int tableHash[TABLE_HASH_SIZE];
+
+// King slots: a1-d1-d4 triangle for pawnless tables, files a-d for tables with pawns.
+static int triangleSlot[64];
+static int triangleSquare[10];
+static int halfSlot[64];
+static int halfSquare[32];
+
+// TABLES --------------------------------------------------------------------------------------------------------------
+static void initKingSlots() {
+    int triangleCount = 0;
+    int halfCount = 0;
+
+    for(int square = 0; square < 64; square++) {
+        int row = SQUARE_ROW(square);
+        int column = SQUARE_COLUMN(square);
+
+        triangleSlot[square] = -1;
+        if(column < 4 && row <= column) {
+            triangleSquare[triangleCount] = square;
+            triangleSlot[square] = triangleCount++;
+        }
+        halfSlot[square] = -1;
+        if(column < 4) {
+            halfSquare[halfCount] = square;
+            halfSlot[square] = halfCount++;
+        }
+    }
+}
+
+static uint64_t getMaterialKey(const int counts[3][7]) {
+    // Same key as the material key of a position with these counts, so positions find their table without counting.
+    // The counts leave out the kings, every table has one per player.
+    uint64_t key = MATERIAL_ONE(1, 6) + MATERIAL_ONE(2, 6);
+    for(int owner = 1; owner <= 2; owner++) {
+        for(int rank = 1; rank <= 5; rank++) {
+            key += (uint64_t)counts[owner][rank] * MATERIAL_ONE(owner, rank);
+        }
+    }
+    return key;
+}
+
+static int compareSides(const int * first, const int * second) {
+    // Which side has "more" material: most queens, then rooks, bishops, knights and pawns.
+    for(int i = 0; i < 5; i++) {
+        if(first[rankOrder[i]] != second[rankOrder[i]]) {
+            return first[rankOrder[i]] > second[rankOrder[i]] ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+static int getTableSlot(uint64_t materialKey) {
+    // The low bits of a material key are only player 1's pawns and rooks, so mix in the rest before taking the slot.
+    return (int)((materialKey * 0x9E3779B97F4A7C15ULL) >> 32) & (TABLE_HASH_SIZE - 1);
+}
+
+static struct tablebaseTable * findTableByKey(uint64_t materialKey) {
+    int slot = getTableSlot(materialKey);
+    while(tableHash[slot]) {
+        if(tables[tableHash[slot] - 1].materialKey == materialKey) {
+            return &tables[tableHash[slot] - 1];
+        }
+        slot = (slot + 1) % TABLE_HASH_SIZE;
+    }
+    return NULL;
+}
+
+static void setupTable(struct tablebaseTable * table, const int counts[3][7]) {
+    // Fill in a table description from the piece counts of both players.
+    int length = 0;
+    table->pieceCount = 2;
+    table->ranks[0] = 6;
+    table->owners[0] = 1;
+    table->ranks[1] = 6;
+    table->owners[1] = 2;
+    table->pawnCount = counts[1][1] + counts[2][1];
+
+    for(int owner = 1; owner <= 2; owner++) {
+        table->name[length++] = 'K';
+        for(int i = 0; i < 5; i++) {
+            for(int count = 0; count < counts[owner][rankOrder[i]]; count++) {
+                table->name[length++] = rankLetters[rankOrder[i]];
+                table->ranks[table->pieceCount] = rankOrder[i];
+                table->owners[table->pieceCount] = owner;
+                table->pieceCount++;
+            }
+        }
+        if(owner == 1) {
+            table->name[length++] = 'v';
+        }
+    }
+    table->name[length] = '\0';
+
+    table->size = 2 * (table->pawnCount ? 32 : 10);
+    for(int i = 1; i < table->pieceCount; i++) {
+        table->size *= 64;
+    }
+    table->materialKey = getMaterialKey(counts);
+    table->data = NULL;
+    table->mappedSize = 0;
+}
+
+static int compareTables(const void * a, const void * b) {
+    // Smaller tables first, and with the same piece count, fewer pawns first. Captures and promotions then only
+    // lead to tables built earlier.
+    const struct tablebaseTable * first = (const struct tablebaseTable *) a;
+    const struct tablebaseTable * second = (const struct tablebaseTable *) b;
+
+    if(first->pieceCount != second->pieceCount) {
+        return first->pieceCount - second->pieceCount;
+    }
+    if(first->pawnCount != second->pawnCount) {
+        return first->pawnCount - second->pawnCount;
+    }
+    return strcmp(first->name, second->name);
+}
+
+static void addTables(int counts[3][7], int owner, int rankIndex, int remaining) {
+    // Recursively go through every way to give the non-king pieces to the players, and add a table for each.
+    if(rankIndex == 5) {
+        if(owner == 1) {
+            // Player 2 gets what player 1 left.
+            addTables(counts, 2, 0, remaining);
+            return;
+        }
+        int pieceCount = 2;
+        for(int rank = 1; rank <= 5; rank++) {
+            pieceCount += counts[1][rank] + counts[2][rank];
+        }
+        // Player 1 has at least as much as player 2. Two bare kings are always a draw, no table needed.
+        if(pieceCount > 2 && compareSides(counts[1], counts[2]) >= 0 && tableCount < TABLE_MAX_COUNT) {
+            setupTable(&tables[tableCount++], (const int (*)[7]) counts);
+        }
+        return;
+    }
+
+    for(int count = 0; count <= remaining; count++) {
+        counts[owner][rankOrder[rankIndex]] = count;
+        addTables(counts, owner, rankIndex + 1, remaining - count);
+    }
+    counts[owner][rankOrder[rankIndex]] = 0;
+}
+
+static void setupTables(int maxPieces) {
+    // Describe every table up to maxPieces, smallest first. Nothing is mapped yet.
+    int counts[3][7];
+    memset(counts, 0, sizeof(counts));
+
+    initKingSlots();
+    tableCount = 0;
+    addTables(counts, 1, 0, maxPieces - 2);
+    qsort(tables, tableCount, sizeof(struct tablebaseTable), compareTables);
+
+    memset(tableHash, 0, sizeof(tableHash));
+    for(int i = 0; i < tableCount; i++) {
+        int slot = getTableSlot(tables[i].materialKey);
+        while(tableHash[slot]) {
+            slot = (slot + 1) % TABLE_HASH_SIZE;
+        }
+        tableHash[slot] = i + 1;
+    }
+}
+
+static int mapTable(struct tablebaseTable * table, const char * directory) {
+    // Map a table file. Returns 0 if it doesn't exist or is the wrong size.
+    char path[TABLE_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s.tb", directory, table->name);
+
+    table->data = (const unsigned char *) mapFile(path, &table->mappedSize);
+    if(table->data && table->mappedSize != (size_t)table->size) {
+        printf("Tablebase %s has the wrong size, ignoring it.\n", path);
+        unmapFile((const char *) table->data, table->mappedSize);
+        table->data = NULL;
+    }
+    if(!table->data) {
+        table->mappedSize = 0;
+        return 0;
+    }
+    if(table->pieceCount > tablebasePieces) {
+        tablebasePieces = table->pieceCount;
+    }
+    return 1;
+}
+
+int openTablebases(const char * directory) {
+    // Map every table found in directory. Returns the number of tables opened.
+    closeTablebases();
+    setupTables(TABLEBASE_MAX_PIECES);
+
+    int opened = 0;
+    for(int i = 0; i < tableCount; i++) {
+        opened += mapTable(&tables[i], directory);
+    }
+    return opened;
+}
+
+void closeTablebases() {
+    for(int i = 0; i < tableCount; i++) {
+        if(tables[i].data) {
+            unmapFile((const char *) tables[i].data, tables[i].mappedSize);
+            tables[i].data = NULL;
+        }
+    }
+    tableCount = 0;
+    tablebasePieces = 0;
+    memset(tableHash, 0, sizeof(tableHash));
+}
+
+// INDEXING ------------------------------------------------------------------------------------------------------------
+static int transformSquare(int square, int transform) {
+    // Bit 0 mirrors files, bit 1 mirrors rows, bit 2 mirrors along the a1-h8 diagonal.
+    int row = SQUARE_ROW(square);
+    int column = SQUARE_COLUMN(square);
+
+    if(transform & 1) {
+        column = 7 - column;
+    }
+    if(transform & 2) {
+        row = 7 - row;
+    }
+    if(transform & 4) {
+        int temp = row;
+        row = column;
+        column = temp;
+    }
+    return SQUARE(row, column);
+}
+
+static long canonicalIndex(const struct tablebaseTable * table, const int * squares, int turn) {
+    // Index of the position, the smallest over its symmetric copies. Pieces of the same kind are sorted so that
+    // swapping them gives the same index.
+    int transformCount = table->pawnCount ? 2 : 8;
+    int slotCount = table->pawnCount ? 32 : 10;
+    const int * slots = table->pawnCount ? halfSlot : triangleSlot;
+    int transformed[TABLEBASE_MAX_PIECES];
+    long best = -1;
+
+    for(int transform = 0; transform < transformCount; transform++) {
+        for(int i = 0; i < table->pieceCount; i++) {
+            transformed[i] = transformSquare(squares[i], transform);
+        }
+        if(slots[transformed[0]] == -1) {
+            continue;
+        }
+
+        for(int i = 3; i < table->pieceCount; i++) {
+            for(int j = i; j > 2 && table->ranks[j - 1] == table->ranks[j] &&
+                           table->owners[j - 1] == table->owners[j] && transformed[j - 1] > transformed[j]; j--) {
+                int temp = transformed[j];
+                transformed[j] = transformed[j - 1];
+                transformed[j - 1] = temp;
+            }
+        }
+
+        long index = ((long)(turn - 1) * slotCount) + slots[transformed[0]];
+        for(int i = 1; i < table->pieceCount; i++) {
+            index = (index * 64) + transformed[i];
+        }
+        if(best == -1 || index < best) {
+            best = index;
+        }
+    }
+    return best;
+}
+
+static void decodeIndex(const struct tablebaseTable * table, long index, int * outSquares, int * outTurn) {
+    int slotCount = table->pawnCount ? 32 : 10;
+
+    for(int i = table->pieceCount - 1; i >= 1; i--) {
+        outSquares[i] = (int)(index % 64);
+        index /= 64;
+    }
+    int slot = (int)(index % slotCount);
+    outSquares[0] = table->pawnCount ? halfSquare[slot] : triangleSquare[slot];
+    *outTurn = (int)(index / slotCount) + 1;
+}
+
+static int setupPosition(const struct tablebaseTable * table, const int * squares, int turn, struct position * pos) {
+    // Place the pieces on an empty board. Returns 0 if pieces overlap or a pawn is on the first or last row.
+    for(int square = 0; square < 64; square++) {
+        pos->board[square].rank = 0;
+        pos->board[square].owner = 0;
+    }
+    for(int i = 0; i < table->pieceCount; i++) {
+        int row = SQUARE_ROW(squares[i]);
+        if(pos->board[squares[i]].rank != 0 || (table->ranks[i] == 1 && (row == 0 || row == 7))) {
+            return 0;
+        }
+        pos->board[squares[i]].rank = table->ranks[i];
+        pos->board[squares[i]].owner = table->owners[i];
+    }
+    computePieceCounts(pos);
+    pos->turn = turn;
+    // Keys are not used by the tables.
+    pos->key = 0;
+    pos->pawnKey = 0;
+    pos->halfmoveClock = 0;
+    pos->fullmoveNumber = 1;
+    pos->castlingRights = 0;
+    pos->enPassantSquare = NO_SQUARE;
+    return 1;
+}
+
+static const struct tablebaseTable * findTable(const struct position * pos, int * outSquares, int * outTurn) {
+    // Find the table of the position and the squares of its pieces in table order.
+    // The position's counts and material key are kept up to date by make / unmake, so there is nothing to count.
+    int pieceCount = pos->pieceListCount[1] + pos->pieceListCount[2];
+    if(pieceCount > tablebasePieces || pos->pieceCounts[1][6] != 1 || pos->pieceCounts[2][6] != 1) {
+        return NULL;
+    }
+
+    // Tables have the stronger side as player 1, flip the board if needed.
+    int flip = compareSides(pos->pieceCounts[2], pos->pieceCounts[1]) > 0;
+
+    const struct tablebaseTable * table = findTableByKey(flip ? MATERIAL_FLIP(pos->materialKey) : pos->materialKey);
+    if(!table || !table->data) {
+        return NULL;
+    }
+
+    int used[TABLEBASE_MAX_PIECES] = {0};
+    for(int square = 0; square < 64; square++) {
+        struct chessPiece piece = pos->board[square];
+        if(piece.rank == 0) {
+            continue;
+        }
+        int owner = flip ? 3 - piece.owner : piece.owner;
+        for(int i = 0; i < table->pieceCount; i++) {
+            if(!used[i] && table->ranks[i] == piece.rank && table->owners[i] == owner) {
+                used[i] = 1;
+                outSquares[i] = flip ? (square ^ 56) : square;
+                break;
+            }
+        }
+    }
+    *outTurn = flip ? 3 - pos->turn : pos->turn;
+
+    return table;
+}
+
+static int decodeByte(unsigned char value, struct tablebaseResult * outResult) {
+    if(value == BYTE_ILLEGAL) {
+        return 0;
+    }
+    if(value == BYTE_DRAW) {
+        outResult->wdl = 0;
+        outResult->movesToMate = 0;
+    }
+    else if(value < BYTE_LOSS) {
+        outResult->wdl = 1;
+        outResult->movesToMate = value;
+    }
+    else {
+        outResult->wdl = -1;
+        outResult->movesToMate = value - BYTE_LOSS;
+    }
+    return 1;
+}
+
+int probeTablebase(const struct position * pos, struct tablebaseResult * outResult) {
+    // Look up the exact result of a position. Returns 0 if there is no table for it.
+    // Tables have no castling or en passant, positions that still allow them aren't in any table.
+    if(!tablebasePieces || pos->castlingRights || pos->enPassantSquare != NO_SQUARE) {
+        return 0;
+    }
+
+    // Two bare kings
+    if(pos->pieceListCount[1] + pos->pieceListCount[2] == 2) {
+        outResult->wdl = 0;
+        outResult->movesToMate = 0;
+        return 1;
+    }
+
+    int squares[TABLEBASE_MAX_PIECES];
+    int turn;
+    const struct tablebaseTable * table = findTable(pos, squares, &turn);
+    if(!table) {
+        return 0;
+    }
+    return decodeByte(table->data[canonicalIndex(table, squares, turn)], outResult);
+}
+
+// GENERATION ----------------------------------------------------------------------------------------------------------
+static void updateMaxPlies(struct tablebaseGenerator * generator, int plies) {
+    int current = atomic_load(&generator->maxPlies);
+    while(plies > current && !atomic_compare_exchange_weak(&generator->maxPlies, &current, plies)) {
+    }
+}
+
+static int addUnique(long * list, int count, long value) {
+    // Append value if it is not in the list yet. Returns the new count.
+    for(int i = 0; i < count; i++) {
+        if(list[i] == value) {
+            return count;
+        }
+    }
+    list[count] = value;
+    return count + 1;
+}
+
+static void initializeEntries(struct tablebaseGenerator * generator, long start, long end) {
+    // Mark illegal positions, mates and stalemates, count moves staying in the table and look up the rest.
+    const struct tablebaseTable * table = generator->table;
+    struct position pos;
+    struct moveList list;
+    struct undoRecord undo;
+    struct tablebaseResult result;
+    int squares[TABLEBASE_MAX_PIECES];
+    int nextSquares[TABLEBASE_MAX_PIECES];
+    long successors[MAX_MOVES];
+    int turn;
+
+    for(long index = start; index < end; index++) {
+        decodeIndex(table, index, squares, &turn);
+
+        // The player who just moved can't be left in check.
+        if(!setupPosition(table, squares, turn, &pos) || canonicalIndex(table, squares, turn) != index ||
+           isPlayerInCheck(&pos, 3 - turn)) {
+            atomic_store_explicit(&generator->states[index], STATE_ILLEGAL, memory_order_relaxed);
+            continue;
+        }
+
+        generateLegalMoves(&pos, &list);
+        int exitBest = EXIT_NONE;
+        int successorCount = 0;
+
+        for(int i = 0; i < list.count; i++) {
+            int move = list.moves[i];
+            int from = MOVE_FROM(move);
+            int to = MOVE_TO(move);
+
+            // Captures and promotions change the material, so the result comes from another table.
+            if(pos.board[to].rank != 0 || MOVE_PROMOTION(move) || MOVE_IS_EN_PASSANT(move)) {
+                makeMove(&pos, move, &undo);
+                int found = probeTablebase(&pos, &result);
+                unmakeMove(&pos, move, &undo);
+
+                if(!found) {
+                    atomic_store(&generator->missingTable, 1);
+                    continue;
+                }
+                // Result is from the opponent's point of view.
+                int score = (result.wdl == 1) ? EXIT_LOSS(2 * result.movesToMate) :
+                            (result.wdl == -1) ? EXIT_WIN((2 * result.movesToMate) + 1) : 0;
+                if(score > exitBest) {
+                    exitBest = score;
+                }
+                continue;
+            }
+
+            for(int j = 0; j < table->pieceCount; j++) {
+                nextSquares[j] = (squares[j] == from) ? to : squares[j];
+            }
+            successorCount = addUnique(successors, successorCount, canonicalIndex(table, nextSquares, 3 - turn));
+        }
+
+        generator->exits[index] = (short)exitBest;
+        atomic_store_explicit(&generator->counters[index], (unsigned char)successorCount, memory_order_relaxed);
+
+        short state = STATE_UNKNOWN;
+        if(list.count == 0) {
+            state = isPlayerInCheck(&pos, turn) ? STATE_LOSS(0) : STATE_DRAW;
+        }
+        else if(successorCount == 0) {
+            // Every move leaves the table, the result is already known.
+            state = (exitBest > 0) ? STATE_WIN(EXIT_WIN(0) - exitBest) :
+                    (exitBest == 0) ? STATE_DRAW : STATE_LOSS(exitBest - EXIT_LOSS(0));
+        }
+        if(state >= 0) {
+            updateMaxPlies(generator, STATE_PLIES(state));
+        }
+        else if(exitBest > 0) {
+            updateMaxPlies(generator, EXIT_WIN(0) - exitBest);
+        }
+        atomic_store_explicit(&generator->states[index], state, memory_order_relaxed);
+    }
+}
+
+static void resolveExitWins(struct tablebaseGenerator * generator, long start, long end) {
+    // Positions winning through a capture or promotion at this distance, with nothing faster in the table.
+    short exitScore = (short)EXIT_WIN(generator->level);
+
+    for(long index = start; index < end; index++) {
+        if(generator->exits[index] == exitScore &&
+           atomic_load_explicit(&generator->states[index], memory_order_relaxed) == STATE_UNKNOWN) {
+            atomic_store_explicit(&generator->states[index], STATE_WIN(generator->level), memory_order_relaxed);
+        }
+    }
+}
+
+static int addPredecessors(const struct tablebaseTable * table, const struct position * pos, const int * squares,
+                           int piece, long * predecessors, int count) {
+    // Unmake one move of a piece: every empty square it could have come from without capturing or promoting.
+    int row = SQUARE_ROW(squares[piece]);
+    int column = SQUARE_COLUMN(squares[piece]);
+    int rank = table->ranks[piece];
+    int previousTurn = table->owners[piece];
+    int previousSquares[TABLEBASE_MAX_PIECES];
+    int fromSquares[32];
+    int fromCount = 0;
+
+    if(rank == 1) {
+        // Pawns step back towards their own side, two steps back to the starting row.
+        int direction = (previousTurn == 1) ? -1 : 1;
+        int startRow = (previousTurn == 1) ? 1 : 6;
+        int oneBack = row + direction;
+
+        if(pos->board[SQUARE(oneBack, column)].rank == 0 && oneBack != 0 && oneBack != 7) {
+            fromSquares[fromCount++] = SQUARE(oneBack, column);
+            if(oneBack + direction == startRow && pos->board[SQUARE(startRow, column)].rank == 0) {
+                fromSquares[fromCount++] = SQUARE(startRow, column);
+            }
+        }
+    }
+    else if(rank == 3 || rank == 6) {
+        const int (* steps)[2] = (rank == 3) ? knightJumps : kingSteps;
+        for(int i = 0; i < 8; i++) {
+            int fromRow = row + steps[i][0];
+            int fromColumn = column + steps[i][1];
+            if(fromRow >= 0 && fromRow <= 7 && fromColumn >= 0 && fromColumn <= 7 &&
+               pos->board[SQUARE(fromRow, fromColumn)].rank == 0) {
+                fromSquares[fromCount++] = SQUARE(fromRow, fromColumn);
+            }
+        }
+    }
+    else {
+        // Sliders. The first four king steps are straight, the last four diagonal.
+        for(int i = 0; i < 8; i++) {
+            if((rank == 2 && i >= 4) || (rank == 4 && i < 4)) {
+                continue;
+            }
+            int fromRow = row + kingSteps[i][0];
+            int fromColumn = column + kingSteps[i][1];
+            while(fromRow >= 0 && fromRow <= 7 && fromColumn >= 0 && fromColumn <= 7 &&
+                  pos->board[SQUARE(fromRow, fromColumn)].rank == 0) {
+                fromSquares[fromCount++] = SQUARE(fromRow, fromColumn);
+                fromRow += kingSteps[i][0];
+                fromColumn += kingSteps[i][1];
+            }
+        }
+    }
+
+    for(int i = 0; i < fromCount; i++) {
+        for(int j = 0; j < table->pieceCount; j++) {
+            previousSquares[j] = (j == piece) ? fromSquares[i] : squares[j];
+        }
+        count = addUnique(predecessors, count, canonicalIndex(table, previousSquares, previousTurn));
+    }
+    return count;
+}
+
+static void propagateLevel(struct tablebaseGenerator * generator, long start, long end) {
+    // Unmake moves from the positions resolved at this distance.
+    const struct tablebaseTable * table = generator->table;
+    struct position pos;
+    int squares[TABLEBASE_MAX_PIECES];
+    // A piece can come from at most 27 squares.
+    long predecessors[TABLEBASE_MAX_PIECES * 28];
+    int turn;
+    int level = generator->level;
+
+    for(long index = start; index < end; index++) {
+        short state = atomic_load_explicit(&generator->states[index], memory_order_relaxed);
+        if(state < 0 || STATE_PLIES(state) != level) {
+            continue;
+        }
+
+        decodeIndex(table, index, squares, &turn);
+        setupPosition(table, squares, turn, &pos);
+
+        int count = 0;
+        for(int piece = 0; piece < table->pieceCount; piece++) {
+            if(table->owners[piece] != turn) {
+                count = addPredecessors(table, &pos, squares, piece, predecessors, count);
+            }
+        }
+
+        for(int i = 0; i < count; i++) {
+            long previous = predecessors[i];
+            short expected = STATE_UNKNOWN;
+            if(atomic_load_explicit(&generator->states[previous], memory_order_relaxed) != STATE_UNKNOWN) {
+                continue;
+            }
+
+            // A move to a lost position wins.
+            if(!STATE_IS_WIN(state)) {
+                if(atomic_compare_exchange_strong(&generator->states[previous], &expected, STATE_WIN(level + 1))) {
+                    updateMaxPlies(generator, level + 1);
+                }
+                continue;
+            }
+
+            // If all moves staying in the table lose, the position is lost unless a capture or promotion helps.
+            if(atomic_fetch_sub(&generator->counters[previous], 1) == 1) {
+                int exitBest = generator->exits[previous];
+                if(exitBest < 0) {
+                    int plies = level + 1;
+                    if(exitBest != EXIT_NONE && exitBest - EXIT_LOSS(0) > plies) {
+                        plies = exitBest - EXIT_LOSS(0);
+                    }
+                    if(atomic_compare_exchange_strong(&generator->states[previous], &expected, STATE_LOSS(plies))) {
+                        updateMaxPlies(generator, plies);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void * generatorWorker(void * argument) {
+    // Take blocks of indexes until the table is done.
+    struct tablebaseGenerator * generator = (struct tablebaseGenerator *) argument;
+
+    while(1) {
+        long start = atomic_fetch_add(&generator->nextIndex, WORK_BLOCK);
+        if(start >= generator->table->size) {
+            break;
+        }
+        long end = (start + WORK_BLOCK < generator->table->size) ? start + WORK_BLOCK : generator->table->size;
+        generator->work(generator, start, end);
+    }
+    return NULL;
+}
+
+static void runGeneratorStep(struct tablebaseGenerator * generator,
+                             void (* work)(struct tablebaseGenerator * generator, long start, long end)) {
+    // Run one step over the whole table on all threads. The calling thread works too.
+    pthread_t threads[64];
+    int started = 0;
+
+    generator->work = work;
+    atomic_store(&generator->nextIndex, 0);
+
+    for(int i = 1; i < generator->threadCount && i < 64; i++) {
+        if(pthread_create(&threads[started], NULL, generatorWorker, generator) == 0) {
+            started++;
+        }
+    }
+    generatorWorker(generator);
+    for(int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+static int generateTable(struct tablebaseTable * table, const char * directory, int threadCount) {
+    // Generate one table and write it to directory. Returns 0 on failure.
+    struct tablebaseGenerator generator;
+    generator.table = table;
+    generator.threadCount = threadCount;
+    generator.states = (atomic_short *) malloc(table->size * sizeof(atomic_short));
+    generator.counters = (atomic_uchar *) malloc(table->size * sizeof(atomic_uchar));
+    generator.exits = (short *) malloc(table->size * sizeof(short));
+    atomic_init(&generator.maxPlies, 0);
+    atomic_init(&generator.missingTable, 0);
+    atomic_init(&generator.nextIndex, 0);
+
+    if(!generator.states || !generator.counters || !generator.exits) {
+        printf("Not enough memory for %s (%ld positions).\n", table->name, table->size);
+        free(generator.states);
+        free(generator.counters);
+        free(generator.exits);
+        return 0;
+    }
+
+    double startTime = getTimeSeconds();
+
+    runGeneratorStep(&generator, initializeEntries);
+    if(atomic_load(&generator.missingTable)) {
+        printf("Tables needed by %s are missing.\n", table->name);
+    }
+
+    for(generator.level = 0; generator.level <= atomic_load(&generator.maxPlies) && generator.level <= MAX_PLIES;
+        generator.level++) {
+        if(generator.level % 2 == 1) {
+            runGeneratorStep(&generator, resolveExitWins);
+        }
+        runGeneratorStep(&generator, propagateLevel);
+    }
+
+    int success = !atomic_load(&generator.missingTable);
+    if(atomic_load(&generator.maxPlies) > MAX_PLIES) {
+        printf("Mates in %s are too long to store.\n", table->name);
+        success = 0;
+    }
+
+    // Convert to table bytes, reusing the exit scores' memory.
+    unsigned char * bytes = (unsigned char *) generator.exits;
+    long counts[3] = {0, 0, 0};
+    for(long index = 0; index < table->size && success; index++) {
+        short state = atomic_load_explicit(&generator.states[index], memory_order_relaxed);
+        if(state == STATE_ILLEGAL) {
+            bytes[index] = BYTE_ILLEGAL;
+        }
+        else if(state < 0) {
+            bytes[index] = BYTE_DRAW;
+            counts[1]++;
+        }
+        else if(STATE_IS_WIN(state)) {
+            bytes[index] = (unsigned char)((STATE_PLIES(state) + 1) / 2);
+            counts[0]++;
+        }
+        else {
+            bytes[index] = (unsigned char)(BYTE_LOSS + (STATE_PLIES(state) / 2));
+            counts[2]++;
+        }
+    }
+
+    if(success) {
+        char path[TABLE_PATH_LENGTH];
+        snprintf(path, sizeof(path), "%s/%s.tb", directory, table->name);
+        FILE * file = fopen(path, "wb");
+        if(!file || fwrite(bytes, 1, (size_t)table->size, file) != (size_t)table->size) {
+            printf("Failed to write %s.\n", path);
+            success = 0;
+        }
+        if(file) {
+            fclose(file);
+        }
+    }
+
+    if(success) {
+        printf("%-8s %10ld positions: %ld wins, %ld draws, %ld losses, longest mate %d moves, %.1f s\n",
+               table->name, counts[0] + counts[1] + counts[2], counts[0], counts[1], counts[2],
+               (atomic_load(&generator.maxPlies) + 1) / 2, getTimeSeconds() - startTime);
+    }
+
+    free(generator.states);
+    free(generator.counters);
+    free(generator.exits);
+
+    return success;
+}
+
+int buildTablebases(const char * directory, int maxPieces, int threadCount) {
+    // Generate every missing table with up to maxPieces pieces. Returns 0 on failure.
+    if(maxPieces < 3 || maxPieces > TABLEBASE_MAX_PIECES) {
+        printf("Tablebases can have 3 to %d pieces.\n", TABLEBASE_MAX_PIECES);
+        return 0;
+    }
+    if(!makeDirectory(directory)) {
+        printf("Failed to create directory %s.\n", directory);
+        return 0;
+    }
+
+    closeTablebases();
+    setupTables(maxPieces);
+
+    // Tables are in build order, so everything a table needs is mapped before it is generated.
+    for(int i = 0; i < tableCount; i++) {
+        if(mapTable(&tables[i], directory)) {
+            printf("%-8s exists\n", tables[i].name);
+            continue;
+        }
+        // Captures and promotions are probed from the tables already mapped.
+        if(tablebasePieces < tables[i].pieceCount) {
+            tablebasePieces = tables[i].pieceCount;
+        }
+        if(!generateTable(&tables[i], directory, threadCount) || !mapTable(&tables[i], directory)) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,31 @@
+/*
+File:           Tablebase.h
+Author:         Toni Lindeman
+Description:    Endgame tablebases: retrograde generation and memory mapped probing.
+*/
+
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "Position.h"
+
+#define TABLEBASE_DIRECTORY "tablebases"
+// Kings included. 5 piece tables need a few GB of memory to generate.
+#define TABLEBASE_MAX_PIECES 5
+
+struct tablebaseResult {
+    // 1 if the player in turn wins, 0 draw, -1 loss.
+    int wdl;
+    // Moves until mate with best play, 0 for a draw or if the player in turn is already checkmated.
+    int movesToMate;
+};
+
+// Largest piece count with at least one table open, 0 if none.
+extern int tablebasePieces;
+
+int openTablebases(const char * directory);
+void closeTablebases();
+int probeTablebase(const struct position * pos, struct tablebaseResult * outResult);
+int buildTablebases(const char * directory, int maxPieces, int threadCount);
+
+#endif /* TABLEBASE_H */
@@ -0,0 +1,68 @@
+/*
+File:           Transposition.c
+Author:         Toni Lindeman
+Description:    Transposition table for the search.
+
+The table remembers search results by position key, so positions reached through different move orders are only
+searched once. Size is rounded down to a power of two so the slot can be found with a mask.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "Transposition.h"
+
+int initTranspositionTable(struct transpositionTable * table, size_t megabytes) {
+    // Returns 0 if memory allocation fails.
+    size_t entryCount = 1;
+    while(entryCount * 2 * sizeof(struct ttEntry) <= megabytes * 1024 * 1024) {
+        entryCount *= 2;
+    }
+
+    table->entries = (struct ttEntry *) calloc(entryCount, sizeof(struct ttEntry));
+    if(!table->entries) {
+        table->mask = 0;
+        return 0;
+    }
+    table->mask = entryCount - 1;
+    return 1;
+}
+
+void freeTranspositionTable(struct transpositionTable * table) {
+    free(table->entries);
+    table->entries = NULL;
+    table->mask = 0;
+}
+
+void clearTranspositionTable(struct transpositionTable * table) {
+    memset(table->entries, 0, (table->mask + 1) * sizeof(struct ttEntry));
+}
+
+int probeTransposition(const struct transpositionTable * table, uint64_t key, struct ttEntry * outEntry) {
+    // Copies the entry for key to outEntry, returns 0 if the position is not in the table.
+    const struct ttEntry * entry = &table->entries[key & table->mask];
+
+    if(entry->key != key || entry->flag == 0) {
+        return 0;
+    }
+    *outEntry = *entry;
+    return 1;
+}
+
+void storeTransposition(struct transpositionTable * table, uint64_t key, int move, int score, int depth, int flag) {
+    struct ttEntry * entry = &table->entries[key & table->mask];
+
+    // Keep a deeper result of the same position, otherwise always replace.
+    if(entry->key == key && entry->depth > depth && flag != TT_EXACT) {
+        return;
+    }
+    // Keep the old best move if this search didn't find one.
+    if(move == 0 && entry->key == key) {
+        move = entry->move;
+    }
+
+    entry->key = key;
+    entry->move = move;
+    entry->score = (short)score;
+    entry->depth = (signed char)depth;
+    entry->flag = (unsigned char)flag;
+}
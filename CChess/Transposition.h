@@ -0,0 +1,37 @@
+/*
+File:           Transposition.h
+Author:         Toni Lindeman
+Description:    Transposition table for the search.
+*/
+
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Score bound stored with an entry.
+#define TT_EXACT 1
+#define TT_LOWER 2
+#define TT_UPPER 3
+
+struct ttEntry {
+    uint64_t key;
+    int move;
+    short score;
+    signed char depth;
+    unsigned char flag;
+};
+
+struct transpositionTable {
+    struct ttEntry * entries;
+    size_t mask;
+};
+
+int initTranspositionTable(struct transpositionTable * table, size_t megabytes);
+void freeTranspositionTable(struct transpositionTable * table);
+void clearTranspositionTable(struct transpositionTable * table);
+int probeTransposition(const struct transpositionTable * table, uint64_t key, struct ttEntry * outEntry);
+void storeTransposition(struct transpositionTable * table, uint64_t key, int move, int score, int depth, int flag);
+
+#endif /* TRANSPOSITION_H */
@@ -1,19 +1,26 @@
-/*
-File:           UserInput.h
-Author:         Toni Lindeman
-Description:    Functionality for getting and validating user input.
-*/
-
-
-#ifndef USERINPUT_H
-#define USERINPUT_H
-
-int getMenuChoice(int min, int max);
-void clearConsole();
-void promptReturnToContinue();
-void getSelectSquare(int * outX, int * outY, int promptSelectOrMove);
-void getScenarioPlacement(int * placement);
-int promptYesNo(char * prompt);
-int promptPromotePawn();
-
-#endif /* USERINPUT_H */
+/*
+File:           UserInput.h
+Author:         Toni Lindeman
+Description:    Functionality for getting and validating user input.
+*/
+
+
+#ifndef USERINPUT_H
+#define USERINPUT_H
+
+// getSelectSquare gives these instead of a square.
+#define SELECT_EXIT -1
+#define SELECT_HINT -2
+#define SELECT_TAKEBACK -3
+#define SELECT_REDO -4
+
+int getMenuChoice(int min, int max);
+void clearConsole();
+void promptReturnToContinue();
+void getSelectSquare(int * outX, int * outY, int promptSelectOrMove);
+void getScenarioPlacement(int * placement);
+int promptYesNo(char * prompt);
+int promptPromotePawn();
+const char * getMoveResultText(int result);
+
+#endif /* USERINPUT_H */
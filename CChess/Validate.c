@@ -0,0 +1,433 @@
+/*
+File:           Validate.c
+Author:         Toni Lindeman
+Description:    Position legality checks, one position at a time or in bulk from a stream of FENs.
+
+The scenario editor checks its positions interactively. These are the same kind of checks without any I/O,
+so they can be run on generated positions by the million:
+    - each side has exactly one king
+    - no pawn stands on the first or last row
+    - the side that just moved is not left in check
+    - piece counts are reachable, counting promotions: every queen above 1, or rook, knight or bishop above 2,
+      needs a pawn that is no longer on the board (so 9 queens and no pawns is fine, 9 queens and 1 pawn isn't)
+    - castling rights have their king and rook on the starting squares
+    - an en passant square is right behind a pawn of the player not in turn, with the two squares it crossed empty
+A position failing any of these can never come up in a game, a checkmate or stalemate can and is legal.
+
+runValidation reads FEN or EPD lines from a file (or "-" for stdin) in large rounds. Every thread validates its
+own part of a round and writes its results to its own buffer, the buffers are then printed in input order.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "OSSpecific.h"
+#include "Notation.h"
+#include "Validate.h"
+
+// Input bytes per thread per round.
+#define VALIDATE_CHUNK_SIZE (1 << 20)
+#define VALIDATE_LINE_LENGTH 512
+
+static const char * invalidReasonNames[INVALID_REASON_COUNT] = {
+    "fen", "king_count", "pawn_row", "opponent_in_check", "piece_count", "castling", "en_passant"
+};
+
+static const char * invalidReasonTexts[INVALID_REASON_COUNT] = {
+    "The position could not be read.",
+    "Both sides must have exactly one king.",
+    "Pawns can't stand on the first or last row.",
+    "The player not in turn can't be in check.",
+    "Too many pieces, every extra queen, rook, knight or bishop needs a promoted pawn.",
+    "Castling needs the king and the rook on their starting squares.",
+    "The en passant square must be right behind a pawn that could have just moved two steps."
+};
+
+// One thread's part of a bulk validation.
+struct validationJob {
+    // validatePositions
+    const struct position * positions;
+    int * reasons;
+    long count;
+
+    // runValidation
+    const char * input;
+    size_t inputLength;
+    long lineCount;
+    long firstLine;
+    int illegalOnly;
+    char * output;
+    size_t outputLength;
+    size_t outputCapacity;
+    long positionCount;
+    long illegalCount;
+    long reasonCounts[INVALID_REASON_COUNT];
+    int failed;
+    // Whether the job got its own thread
+    int started;
+};
+
+// CHECKS --------------------------------------------------------------------------------------------------------------
+int validatePosition(const struct position * pos) {
+    // Returns the INVALID_ reasons of the position as bits, 0 if the position is legal.
+    int counts[3][7] = {{0}};
+    int kingSquares[3] = {-1, -1, -1};
+    int reasons = 0;
+
+    for(int square = 0; square < 64; square++) {
+        int rank = pos->board[square].rank;
+        int owner = pos->board[square].owner;
+        if(rank == 0) {
+            continue;
+        }
+        if(rank < 0 || rank > 6 || owner < 1 || owner > 2) {
+            return INVALID_FEN;
+        }
+        counts[owner][rank]++;
+        if(rank == 6) {
+            kingSquares[owner] = square;
+        }
+        else if(rank == 1 && (SQUARE_ROW(square) == 0 || SQUARE_ROW(square) == 7)) {
+            reasons |= INVALID_PAWN_ROW;
+        }
+    }
+
+    if(counts[1][6] != 1 || counts[2][6] != 1) {
+        reasons |= INVALID_KING_COUNT;
+    }
+
+    for(int player = 1; player <= 2; player++) {
+        // Pieces above the starting set must all be promoted pawns.
+        if(counts[player][1] + countPromotedPieces(counts[player]) > 8) {
+            reasons |= INVALID_PIECE_COUNT;
+        }
+    }
+
+    if(pos->castlingRights & ~inferCastlingRights(pos)) {
+        reasons |= INVALID_CASTLING;
+    }
+
+    if(pos->enPassantSquare != NO_SQUARE) {
+        // Player 1 in turn: player 2's pawn moved from row 6 over row 5 to row 4.
+        int square = pos->enPassantSquare;
+        int direction = (pos->turn == 1) ? -1 : 1;
+        struct chessPiece pawn = pos->board[square + (8 * direction)];
+        if(SQUARE_ROW(square) != ((pos->turn == 1) ? 5 : 2) || pos->board[square].rank != 0 ||
+           pos->board[square - (8 * direction)].rank != 0 || pawn.rank != 1 || pawn.owner == pos->turn) {
+            reasons |= INVALID_EN_PASSANT;
+        }
+    }
+
+    // The side not in turn may not be in check. Without both kings this means nothing.
+    if(!(reasons & INVALID_KING_COUNT) && (pos->turn == 1 || pos->turn == 2)) {
+        int opponent = (pos->turn % 2) + 1;
+        if(isSquareAttacked(pos, kingSquares[opponent], pos->turn)) {
+            reasons |= INVALID_OPPONENT_IN_CHECK;
+        }
+    }
+
+    return reasons;
+}
+
+int validateChessboard(struct chessPiece * chessboard, int turn) {
+    // Same as validatePosition, for a chessboard with turn to move.
+    struct position pos;
+    setPositionFromChessboard(&pos, chessboard, turn);
+    return validatePosition(&pos);
+}
+
+const char * getInvalidReasonName(int reason) {
+    // Short name of a single reason bit, for machine readable output.
+    for(int i = 0; i < INVALID_REASON_COUNT; i++) {
+        if(reason == (1 << i)) {
+            return invalidReasonNames[i];
+        }
+    }
+    return "unknown";
+}
+
+const char * getInvalidReasonText(int reason) {
+    // Explanation of a single reason bit for the player.
+    for(int i = 0; i < INVALID_REASON_COUNT; i++) {
+        if(reason == (1 << i)) {
+            return invalidReasonTexts[i];
+        }
+    }
+    return "The position is not legal.";
+}
+
+// BULK ----------------------------------------------------------------------------------------------------------------
+static void runJobs(struct validationJob * jobs, pthread_t * threads, int jobCount, void * (* worker)(void *)) {
+    // Run every job on its own thread. Jobs whose thread can't be started are run here.
+    for(int i = 0; i < jobCount; i++) {
+        jobs[i].started = pthread_create(&threads[i], NULL, worker, &jobs[i]) == 0;
+        if(!jobs[i].started) {
+            worker(&jobs[i]);
+        }
+    }
+    for(int i = 0; i < jobCount; i++) {
+        if(jobs[i].started) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+static void * validatePositionsWorker(void * argument) {
+    struct validationJob * job = (struct validationJob *) argument;
+    for(long i = 0; i < job->count; i++) {
+        job->reasons[i] = validatePosition(&job->positions[i]);
+    }
+    return NULL;
+}
+
+long validatePositions(const struct position * positions, long count, int * outReasons, int threadCount) {
+    // Validate count positions split over threadCount threads. outReasons gets validatePosition's result for
+    // each. Returns the number of legal positions, or -1 if out of memory.
+    struct validationJob * jobs = (struct validationJob *) calloc(threadCount, sizeof(struct validationJob));
+    pthread_t * threads = (pthread_t *) malloc(threadCount * sizeof(pthread_t));
+    if(!jobs || !threads) {
+        free(jobs);
+        free(threads);
+        return -1;
+    }
+
+    long perThread = (count + threadCount - 1) / threadCount;
+    for(int i = 0; i < threadCount; i++) {
+        long first = i * perThread;
+        jobs[i].positions = positions + first;
+        jobs[i].reasons = outReasons + first;
+        jobs[i].count = (first >= count) ? 0 : ((count - first < perThread) ? count - first : perThread);
+    }
+    runJobs(jobs, threads, threadCount, validatePositionsWorker);
+    free(jobs);
+    free(threads);
+
+    long legal = 0;
+    for(long i = 0; i < count; i++) {
+        legal += (outReasons[i] == 0);
+    }
+    return legal;
+}
+
+// STREAM --------------------------------------------------------------------------------------------------------------
+static int appendOutput(struct validationJob * job, const char * text, size_t length) {
+    // Returns 0 if the output buffer can't grow.
+    if(job->outputLength + length > job->outputCapacity) {
+        size_t newCapacity = job->outputCapacity ? 2 * job->outputCapacity : 65536;
+        while(newCapacity < job->outputLength + length) {
+            newCapacity *= 2;
+        }
+        char * tempPointer = (char *) realloc(job->output, newCapacity);
+        if(!tempPointer) {
+            return 0;
+        }
+        job->output = tempPointer;
+        job->outputCapacity = newCapacity;
+    }
+    memcpy(job->output + job->outputLength, text, length);
+    job->outputLength += length;
+    return 1;
+}
+
+static void * countLinesWorker(void * argument) {
+    // First pass of a round, so every job knows its first line number.
+    struct validationJob * job = (struct validationJob *) argument;
+    const char * end = job->input + job->inputLength;
+
+    job->lineCount = 0;
+    for(const char * next = job->input; next < end && (next = memchr(next, '\n', end - next)); next++) {
+        job->lineCount++;
+    }
+    return NULL;
+}
+
+static void * validateStreamWorker(void * argument) {
+    struct validationJob * job = (struct validationJob *) argument;
+    const char * end = job->input + job->inputLength;
+
+    char line[VALIDATE_LINE_LENGTH];
+    char result[160];
+    long lineNumber = job->firstLine;
+    const char * start = job->input;
+
+    while(start < end && !job->failed) {
+        const char * newline = memchr(start, '\n', end - start);
+        size_t length = (newline ? newline : end) - start;
+        const char * next = newline ? newline + 1 : end;
+        lineNumber++;
+
+        if(length > 0 && start[length - 1] == '\r') {
+            length--;
+        }
+        if(length == 0 || start[0] == '#') {
+            start = next;
+            continue;
+        }
+        if(length > VALIDATE_LINE_LENGTH - 1) {
+            length = VALIDATE_LINE_LENGTH - 1;
+        }
+        memcpy(line, start, length);
+        line[length] = '\0';
+        start = next;
+
+        struct position pos;
+        // Strict, a plain read would drop the castling rights and en passant square that fail the checks.
+        int reasons = setPositionFromFenStrict(&pos, line) ? validatePosition(&pos) : INVALID_FEN;
+        job->positionCount++;
+
+        int resultLength = 0;
+        if(reasons == 0) {
+            if(job->illegalOnly) {
+                continue;
+            }
+            resultLength = sprintf(result, "{\"line\":%ld,\"legal\":true}\n", lineNumber);
+        }
+        else {
+            job->illegalCount++;
+            resultLength = sprintf(result, "{\"line\":%ld,\"legal\":false,\"reasons\":[", lineNumber);
+            int first = 1;
+            for(int i = 0; i < INVALID_REASON_COUNT; i++) {
+                if(reasons & (1 << i)) {
+                    job->reasonCounts[i]++;
+                    resultLength += sprintf(result + resultLength, "%s\"%s\"", first ? "" : ",",
+                                            invalidReasonNames[i]);
+                    first = 0;
+                }
+            }
+            resultLength += sprintf(result + resultLength, "]}\n");
+        }
+        if(!appendOutput(job, result, (size_t) resultLength)) {
+            job->failed = 1;
+        }
+    }
+    return NULL;
+}
+
+static size_t findLineEnd(const char * data, size_t position, size_t length) {
+    // Position just after the newline at or after position, or length.
+    const char * newline = (position < length) ? memchr(data + position, '\n', length - position) : NULL;
+    return newline ? (size_t)(newline - data) + 1 : length;
+}
+
+int runValidation(const char * fileName, int threadCount, int illegalOnly) {
+    // Validate every FEN / EPD line of a file, "-" reads stdin. Results go to stdout as JSON lines, a summary
+    // to stderr. Returns 0 on failure.
+    FILE * file = strcmp(fileName, "-") ? fopen(fileName, "rb") : stdin;
+    if(!file) {
+        fprintf(stderr, "Failed to open %s.\n", fileName);
+        return 0;
+    }
+
+    size_t capacity = (size_t) threadCount * VALIDATE_CHUNK_SIZE;
+    char * buffer = (char *) malloc(capacity);
+    struct validationJob * jobs = (struct validationJob *) calloc(threadCount, sizeof(struct validationJob));
+    pthread_t * threads = (pthread_t *) malloc(threadCount * sizeof(pthread_t));
+    if(!buffer || !jobs || !threads) {
+        fprintf(stderr, "Failed to allocate memory for validation.\n");
+        free(buffer);
+        free(jobs);
+        free(threads);
+        if(file != stdin) {
+            fclose(file);
+        }
+        return 0;
+    }
+
+    long totalPositions = 0;
+    long totalLines = 0;
+    long reasonCounts[INVALID_REASON_COUNT] = {0};
+    long illegalPositions = 0;
+    size_t carry = 0;
+    int success = 1;
+    double startTime = getTimeSeconds();
+
+    while(success) {
+        size_t length = carry + fread(buffer + carry, 1, capacity - carry, file);
+        int atEnd = length < capacity;
+        if(length == 0) {
+            break;
+        }
+
+        // Only whole lines go into this round. A line longer than the whole buffer is cut.
+        size_t usable = length;
+        if(!atEnd) {
+            while(usable > 0 && buffer[usable - 1] != '\n') {
+                usable--;
+            }
+            if(usable == 0) {
+                usable = length;
+            }
+        }
+
+        // Split the round at line boundaries.
+        size_t position = 0;
+        for(int i = 0; i < threadCount; i++) {
+            size_t chunkEnd = (i == threadCount - 1) ? usable :
+                              findLineEnd(buffer, position + (usable / threadCount), usable);
+            if(chunkEnd < position) {
+                chunkEnd = position;
+            }
+            jobs[i].input = buffer + position;
+            jobs[i].inputLength = chunkEnd - position;
+            jobs[i].illegalOnly = illegalOnly;
+            jobs[i].outputLength = 0;
+            position = chunkEnd;
+        }
+
+        runJobs(jobs, threads, threadCount, countLinesWorker);
+        long firstLine = totalLines;
+        for(int i = 0; i < threadCount; i++) {
+            jobs[i].firstLine = firstLine;
+            firstLine += jobs[i].lineCount;
+        }
+        runJobs(jobs, threads, threadCount, validateStreamWorker);
+
+        for(int i = 0; i < threadCount; i++) {
+            if(jobs[i].failed) {
+                fprintf(stderr, "Failed to allocate memory for validation results.\n");
+                success = 0;
+            }
+            fwrite(jobs[i].output, 1, jobs[i].outputLength, stdout);
+            totalLines += jobs[i].lineCount;
+        }
+
+        // A last line without a newline
+        if(atEnd && usable > 0 && buffer[usable - 1] != '\n') {
+            totalLines++;
+        }
+
+        carry = length - usable;
+        memmove(buffer, buffer + usable, carry);
+        if(atEnd && carry == 0) {
+            break;
+        }
+    }
+
+    for(int i = 0; i < threadCount; i++) {
+        totalPositions += jobs[i].positionCount;
+        illegalPositions += jobs[i].illegalCount;
+        for(int reason = 0; reason < INVALID_REASON_COUNT; reason++) {
+            reasonCounts[reason] += jobs[i].reasonCounts[reason];
+        }
+        free(jobs[i].output);
+    }
+    fflush(stdout);
+
+    double seconds = getTimeSeconds() - startTime;
+    fprintf(stderr, "Validated %ld positions in %.2f s with %d threads, %.0f positions/second.\n", totalPositions,
+            seconds, threadCount, seconds > 0 ? totalPositions / seconds : 0.0);
+    fprintf(stderr, "  %-20s %ld\n  %-20s %ld\n", "legal", totalPositions - illegalPositions, "illegal",
+            illegalPositions);
+    for(int reason = 0; reason < INVALID_REASON_COUNT; reason++) {
+        fprintf(stderr, "  %-20s %ld\n", invalidReasonNames[reason], reasonCounts[reason]);
+    }
+
+    free(buffer);
+    free(jobs);
+    free(threads);
+    if(file != stdin) {
+        fclose(file);
+    }
+    return success;
+}
@@ -0,0 +1,30 @@
+/*
+File:           Validate.h
+Author:         Toni Lindeman
+Description:    Position legality checks, one position at a time or in bulk from a stream of FENs.
+*/
+
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <stdio.h>
+#include "Position.h"
+
+// Reasons a position is illegal, as bits so one position can have several.
+#define INVALID_FEN 0x01
+#define INVALID_KING_COUNT 0x02
+#define INVALID_PAWN_ROW 0x04
+#define INVALID_OPPONENT_IN_CHECK 0x08
+#define INVALID_PIECE_COUNT 0x10
+#define INVALID_CASTLING 0x20
+#define INVALID_EN_PASSANT 0x40
+#define INVALID_REASON_COUNT 7
+
+int validatePosition(const struct position * pos);
+int validateChessboard(struct chessPiece * chessboard, int turn);
+long validatePositions(const struct position * positions, long count, int * outReasons, int threadCount);
+const char * getInvalidReasonName(int reason);
+const char * getInvalidReasonText(int reason);
+int runValidation(const char * fileName, int threadCount, int illegalOnly);
+
+#endif /* VALIDATE_H */
@@ -0,0 +1,49 @@
+/*
+File:           Zobrist.c
+Author:         Toni Lindeman
+Description:    Zobrist hashing of positions.
+
+A position key is the XOR of one random number per piece on the board, plus one more if player 2 is in turn, one
+for the castling rights and one for the column of the en passant square if there is one. Making a move only
+needs a few XORs to update the key.
+*/
+
+#include "Zobrist.h"
+
+uint64_t zobristPieceKeys[2][6][64];
+uint64_t zobristTurnKey;
+uint64_t zobristCastlingKeys[16];
+uint64_t zobristEnPassantKeys[8];
+
+uint64_t nextRandom(uint64_t * state) {
+    // splitmix64. The caller owns the state, so threads don't share it and a fixed seed gives the same numbers on
+    // every run.
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void initZobristKeys() {
+    // Must be called once at program start, before any positions are set up.
+    // Fixed seed, so keys (and anything stored by key) are the same on every run.
+    uint64_t state = 20190101;
+
+    for(int owner = 0; owner < 2; owner++) {
+        for(int rank = 0; rank < 6; rank++) {
+            for(int square = 0; square < 64; square++) {
+                zobristPieceKeys[owner][rank][square] = nextRandom(&state);
+            }
+        }
+    }
+    zobristTurnKey = nextRandom(&state);
+
+    // No rights, no key: positions without castling keep the keys they had before castling was in the rules.
+    zobristCastlingKeys[0] = 0;
+    for(int rights = 1; rights < 16; rights++) {
+        zobristCastlingKeys[rights] = nextRandom(&state);
+    }
+    for(int column = 0; column < 8; column++) {
+        zobristEnPassantKeys[column] = nextRandom(&state);
+    }
+}
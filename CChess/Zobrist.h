@@ -0,0 +1,23 @@
+/*
+File:           Zobrist.h
+Author:         Toni Lindeman
+Description:    Zobrist hashing of positions.
+*/
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+
+// Indexed [owner - 1][rank - 1][square].
+extern uint64_t zobristPieceKeys[2][6][64];
+extern uint64_t zobristTurnKey;
+// Indexed by the castling rights bits.
+extern uint64_t zobristCastlingKeys[16];
+// Indexed by the column of the en passant square.
+extern uint64_t zobristEnPassantKeys[8];
+
+void initZobristKeys();
+uint64_t nextRandom(uint64_t * state);
+
+#endif /* ZOBRIST_H */